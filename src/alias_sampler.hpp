@@ -0,0 +1,160 @@
+/*
+ * Alias-method sampling from a discrete distribution
+ *
+ * Vose's construction splits every outcome's probability between at most
+ * two table slots, so a draw is one uniform slot index plus one comparison:
+ * O(1) per shot after an O(N) build, instead of a binary search over the
+ * cumulative distribution. Both the slot and the comparison value come
+ * from a single 64-bit draw (the high and low halves of a 64x64-bit
+ * product). Shots are split across threads, each with its own xoshiro256**
+ * stream, so results are reproducible for a given seed and thread count.
+ */
+
+#ifndef QKX_ALIAS_SAMPLER_HPP
+#define QKX_ALIAS_SAMPLER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "random.hpp"
+
+namespace qkx {
+
+struct SamplingOptions {
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+    uint64_t seed = 0xa11a5;
+};
+
+class AliasTable {
+public:
+    // Weights need not be normalized; zero weights are never drawn
+    explicit AliasTable(const std::vector<double>& weights) {
+        const size_t n = weights.size();
+        if (n == 0 || n > (uint64_t(1) << 32)) {
+            throw std::invalid_argument("alias table needs 1 to 2^32 outcomes");
+        }
+        double total = 0.0;
+        for (double w : weights) {
+            if (w < 0.0) {
+                throw std::invalid_argument("negative weight");
+            }
+            total += w;
+        }
+        if (total <= 0.0) {
+            throw std::invalid_argument("weights sum to zero");
+        }
+
+        // Scaled so the average slot holds exactly 1; slots below 1 are
+        // topped up from a slot above 1, which then becomes its alias
+        threshold_.resize(n);
+        alias_.resize(n);
+        std::vector<uint32_t> small, large;
+        small.reserve(n);
+        large.reserve(n);
+        const double scale = static_cast<double>(n) / total;
+        for (size_t i = 0; i < n; i++) {
+            threshold_[i] = weights[i] * scale;
+            alias_[i] = static_cast<uint32_t>(i);
+            (threshold_[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            uint32_t l = large.back();
+            small.pop_back();
+            alias_[s] = l;
+            threshold_[l] -= 1.0 - threshold_[s];
+            if (threshold_[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Leftovers are 1 up to rounding
+        for (uint32_t i : small) {
+            threshold_[i] = 1.0;
+        }
+        for (uint32_t i : large) {
+            threshold_[i] = 1.0;
+        }
+    }
+
+    size_t size() const { return threshold_.size(); }
+
+    uint64_t operator()(Xoshiro256& rng) const {
+        uint64_t slot;
+        uint64_t low = mul128(rng(), threshold_.size(), &slot);
+        double u = static_cast<double>(low >> 11) * 0x1.0p-53;
+        return u < threshold_[slot] ? slot : alias_[slot];
+    }
+
+    // Calls fn(shot, outcome) for every shot; shots are split across threads
+    // in contiguous ranges, so fn may write to per-shot storage freely
+    template <typename Fn>
+    void sample(size_t shots, const SamplingOptions& options, Fn&& fn) const {
+        Xoshiro256 base(options.seed);
+        parallel_for(shots, default_num_threads(options.num_threads), 4096,
+                     [&](size_t begin, size_t end, unsigned t) {
+            Xoshiro256 rng = base.stream(t);
+            for (size_t shot = begin; shot < end; shot++) {
+                fn(shot, (*this)(rng));
+            }
+        });
+    }
+
+    // (outcome, count) pairs sorted by outcome. Threads count into dense
+    // arrays when the table is small next to the shot count, otherwise they
+    // sort their draws and the runs are merged.
+    std::vector<std::pair<uint64_t, uint64_t>> sample_counts(size_t shots,
+                                                             const SamplingOptions& options = SamplingOptions()) const {
+        const unsigned threads = default_num_threads(options.num_threads);
+        const size_t n = size();
+        Xoshiro256 base(options.seed);
+        std::vector<std::pair<uint64_t, uint64_t>> out;
+
+        if (n * threads <= 4 * shots) {
+            std::vector<std::vector<uint64_t>> partial(threads);
+            parallel_for(shots, threads, 4096, [&](size_t begin, size_t end, unsigned t) {
+                Xoshiro256 rng = base.stream(t);
+                std::vector<uint64_t>& counts = partial[t];
+                counts.assign(n, 0);
+                for (size_t shot = begin; shot < end; shot++) {
+                    counts[(*this)(rng)]++;
+                }
+            });
+            for (size_t i = 0; i < n; i++) {
+                uint64_t total = 0;
+                for (const auto& counts : partial) {
+                    total += counts.empty() ? 0 : counts[i];
+                }
+                if (total > 0) {
+                    out.emplace_back(i, total);
+                }
+            }
+            return out;
+        }
+
+        std::vector<uint64_t> draws(shots);
+        sample(shots, options, [&draws](size_t shot, uint64_t outcome) { draws[shot] = outcome; });
+        std::sort(draws.begin(), draws.end());
+        for (size_t i = 0; i < shots;) {
+            size_t j = i;
+            while (j < shots && draws[j] == draws[i]) {
+                j++;
+            }
+            out.emplace_back(draws[i], j - i);
+            i = j;
+        }
+        return out;
+    }
+
+private:
+    std::vector<double> threshold_;
+    std::vector<uint32_t> alias_;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_ALIAS_SAMPLER_HPP
@@ -0,0 +1,161 @@
+/*
+ * Batch driver - many circuits, backends and shot counts in one process
+ *
+ * bell_state and ghz_20q run one circuit per process, paying for service
+ * creation, authentication and the backend/target fetch every time. This
+ * driver reads a JSON batch file, creates one QiskitRuntimeService for the
+ * whole batch, fetches each backend (and its target) once, transpiles each
+ * distinct (circuit, backend) pair once, and runs the jobs on a pool of
+ * worker threads.
+ *
+ * Usage: batch_runner <batch.json>
+ *
+ * Batch file:
+ *   {
+ *     "concurrency": 4,                  // jobs in flight (default 4)
+ *     "output": "results.json",          // optional: counts of every job
+ *     "dedup": true,                     // optional: run identical jobs once
+ *     "defaults": {"backend": "ibm_torino", "shots": 1024},
+ *     "jobs": [
+ *       {"name": "bell", "circuit": "bell"},
+ *       {"circuit": "ghz", "num_qubits": 20, "backend": "ibm_fez", "shots": 4096},
+ *       {"circuit": "ghz", "num_qubits": 127, "backend": "local:mps", "shots": 100000},
+ *       {"qasm": "circuits/qft_12.qasm", "backend": "ibm_fez"},
+ *       {"library": "circuits.qkxl", "entry": "vqe_layer_3", "backend": "ibm_fez"}
+ *     ]
+ *   }
+ *
+ * OpenQASM 3 files are parsed up front on all cores (qasm_reader.hpp) and
+ * binary circuit libraries (circuit_library.hpp) are mapped once each; a
+ * file or entry that does not load fails the batch before anything is
+ * submitted.
+ *
+ * Every job is reported with the structural fingerprint of its circuit
+ * (circuit_fingerprint.hpp), which also keys the transpile cache. With
+ * "dedup", jobs with the same fingerprint, backend and shot count are run
+ * once and share the result; the fingerprints in the output let later
+ * batches find circuits that were already run.
+ *
+ * The session (runtime_session.hpp) is shared with runtime_daemon, which
+ * keeps it warm between invocations.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "runtime_session.hpp"
+#include "top_k.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <batch.json>" << std::endl;
+        std::cerr << "Runs every job of the batch file with one service session;" << std::endl;
+        std::cerr << "see the comment at the top of src/batch_runner.cpp for the format." << std::endl;
+        return 1;
+    }
+
+    nlohmann::json batch;
+    std::vector<qkx::JobSpec> jobs;
+    try {
+        std::ifstream in(argv[1]);
+        if (!in) {
+            throw std::runtime_error(std::string("cannot read ") + argv[1]);
+        }
+        batch = nlohmann::json::parse(in);
+        nlohmann::json defaults = batch.value("defaults", nlohmann::json::object());
+        const auto& entries = batch.at("jobs");
+        for (size_t i = 0; i < entries.size(); i++) {
+            jobs.push_back(qkx::parse_job(entries[i], defaults, i));
+        }
+        qkx::load_job_programs(jobs);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    const unsigned concurrency = std::max(1, batch.value("concurrency", 4));
+
+    // Jobs to run; with dedup, later copies of a job point at the first
+    std::vector<size_t> pending, same_as(jobs.size());
+    std::map<std::tuple<qkx::Fingerprint, std::string, int>, size_t> first;
+    const bool dedup = batch.value("dedup", false);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        auto key = std::make_tuple(jobs[i].fingerprint, jobs[i].backend, jobs[i].shots);
+        same_as[i] = dedup ? first.emplace(key, i).first->second : i;
+        if (same_as[i] == i) {
+            pending.push_back(i);
+        }
+    }
+
+    std::cout << "Batch: " << jobs.size() << " jobs";
+    if (pending.size() < jobs.size()) {
+        std::cout << " (" << pending.size() << " distinct)";
+    }
+    std::cout << ", concurrency " << concurrency << std::endl;
+
+    qkx::RuntimeSession session;
+    std::vector<qkx::JobResult> results(jobs.size());
+    std::atomic<size_t> next{0};
+    std::mutex print_lock;
+    auto worker = [&]() {
+        for (size_t n = next++; n < pending.size(); n = next++) {
+            const size_t i = pending[n];
+            results[i] = session.run(jobs[i]);
+            std::lock_guard<std::mutex> guard(print_lock);
+            const qkx::JobSpec& job = jobs[i];
+            const qkx::JobResult& r = results[i];
+            std::cout << "  " << job.name << " (" << job.backend << ", " << job.shots << " shots): ";
+            if (!r.ok) {
+                std::cout << "FAILED - " << r.error << std::endl;
+                continue;
+            }
+            std::cout << std::fixed << std::setprecision(2) << r.seconds << " s, " << r.details << std::endl;
+            for (const auto& c : qkx::top_k(r.counts, 2)) {
+                std::cout << "      |" << c.first << "⟩: " << c.second << " (" << std::setprecision(1)
+                          << (100.0 * c.second / job.shots) << "%)" << std::endl;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<size_t>(concurrency, pending.size()); t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (same_as[i] != i) {
+            results[i] = results[same_as[i]];
+            results[i].details = "same as " + jobs[same_as[i]].name;
+        }
+    }
+
+    size_t failed = 0;
+    nlohmann::json report = nlohmann::json::array();
+    for (size_t i = 0; i < jobs.size(); i++) {
+        failed += !results[i].ok;
+        nlohmann::json entry = qkx::job_report(jobs[i], results[i]);
+        report.push_back(entry);
+    }
+    if (batch.contains("output")) {
+        std::string path = batch["output"];
+        std::ofstream out(path);
+        out << report.dump(2) << std::endl;
+        std::cout << "Results written to " << path << std::endl;
+    }
+
+    std::cout << jobs.size() - failed << " of " << jobs.size() << " jobs succeeded" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -5,6 +5,7 @@
  * IBM Quantum hardware using the Qiskit C API (Qiskit 2.2+).
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,6 +15,108 @@
 #include <qiskit.h>
 #include <qiskit_ibm_runtime/qiskit_ibm_runtime.h>
 
+#include "qk_bulk.h"
+
+// xorshift64* generator for the bootstrap below
+static uint64_t rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Uniform double in [0, 1)
+static double rng_uniform(uint64_t *state) {
+    return (double)(rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Binomial(n, p) draw: inversion when the mean is small, otherwise
+// rejection from a Lorentzian envelope (Numerical Recipes, bnldev), so the
+// cost does not grow with n
+static uint64_t binomial_draw(uint64_t *state, uint64_t n, double p) {
+    if (n == 0 || p <= 0.0) {
+        return 0;
+    }
+    if (p >= 1.0) {
+        return n;
+    }
+    const double q = p > 0.5 ? 1.0 - p : p;
+    const double mean = (double)n * q;
+    uint64_t k;
+    if (mean < 25.0) {
+        double u = rng_uniform(state);
+        double pk = exp((double)n * log1p(-q));
+        double cdf = pk;
+        k = 0;
+        while (u > cdf && k < n) {
+            pk *= (double)(n - k) / (double)(k + 1) * q / (1.0 - q);
+            cdf += pk;
+            k++;
+        }
+    } else {
+        const double pi = 3.14159265358979323846;
+        const double en = (double)n;
+        const double g = lgamma(en + 1.0);
+        const double log_q = log(q), log_1mq = log(1.0 - q);
+        const double sq = sqrt(2.0 * mean * (1.0 - q));
+        double em, y, t;
+        do {
+            do {
+                y = tan(pi * rng_uniform(state));
+                em = sq * y + mean;
+            } while (em < 0.0 || em >= en + 1.0);
+            em = floor(em);
+            t = 1.2 * sq * (1.0 + y * y) *
+                exp(g - lgamma(em + 1.0) - lgamma(en - em + 1.0) + em * log_q + (en - em) * log_1mq);
+        } while (rng_uniform(state) > t);
+        k = (uint64_t)em;
+    }
+    return p > 0.5 ? n - k : k;
+}
+
+// 95% percentile bootstrap intervals for the four outcome probabilities:
+// each resample of the shots is a multinomial draw of the four counts, made
+// as a chain of conditional binomials, and the intervals are the 2.5% and
+// 97.5% quantiles of the resampled proportions
+static int bootstrap_intervals(const int counts[4], size_t num_samples, size_t resamples,
+                               double lower[4], double upper[4]) {
+    double *replicates = malloc(4 * resamples * sizeof(double));
+    if (replicates == NULL || num_samples == 0) {
+        free(replicates);
+        return -1;
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t r = 0; r < resamples; r++) {
+        uint64_t remaining = num_samples, mass = num_samples;
+        for (int k = 0; k < 4; k++) {
+            uint64_t drawn = remaining;
+            if (k < 3) {
+                drawn = counts[k] == 0 ? 0 : binomial_draw(&state, remaining, (double)counts[k] / (double)mass);
+                remaining -= drawn;
+                mass -= (uint64_t)counts[k];
+            }
+            replicates[k * resamples + r] = (double)drawn / num_samples;
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        double *rep = replicates + k * resamples;
+        qsort(rep, resamples, sizeof(double), compare_doubles);
+        lower[k] = rep[(size_t)(0.025 * (resamples - 1))];
+        upper[k] = rep[(size_t)(0.975 * (resamples - 1))];
+    }
+    free(replicates);
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     const char *backend_name = "ibm_fez";  // Default backend
     int32_t num_shots = 1024;
@@ -44,8 +147,7 @@ int main(int argc, char *argv[]) {
     qk_circuit_gate(qc, QkGate_CX, cx_qargs, NULL);
 
     // Measure both qubits
-    qk_circuit_measure(qc, 0, 0);
-    qk_circuit_measure(qc, 1, 1);
+    qkx_circuit_measure_all(qc, 2);
 
     printf("Circuit created: H(0), CX(0,1), Measure\n\n");
 
@@ -166,11 +268,22 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Display counts
-    printf("  |00⟩: %d (%.1f%%)\n", counts[0], 100.0 * counts[0] / num_samples);
-    printf("  |01⟩: %d (%.1f%%)\n", counts[1], 100.0 * counts[1] / num_samples);
-    printf("  |10⟩: %d (%.1f%%)\n", counts[2], 100.0 * counts[2] / num_samples);
-    printf("  |11⟩: %d (%.1f%%)\n", counts[3], 100.0 * counts[3] / num_samples);
+    // Display counts with 95% bootstrap confidence intervals. Shots that
+    // could not be parsed are excluded, from the percentages as well as
+    // from the resampling.
+    const char *labels[4] = {"00", "01", "10", "11"};
+    size_t counted = (size_t)(counts[0] + counts[1] + counts[2] + counts[3]);
+    double lower[4], upper[4];
+    int have_ci = bootstrap_intervals(counts, counted, 1000, lower, upper) == 0;
+    double total = counted > 0 ? (double)counted : 1.0;
+    for (int k = 0; k < 4; k++) {
+        if (have_ci) {
+            printf("  |%s⟩: %d (%.1f%%, 95%% CI %.1f–%.1f%%)\n", labels[k], counts[k],
+                   100.0 * counts[k] / total, 100.0 * lower[k], 100.0 * upper[k]);
+        } else {
+            printf("  |%s⟩: %d (%.1f%%)\n", labels[k], counts[k], 100.0 * counts[k] / total);
+        }
+    }
 
     printf("\nExpected: ~50%% |00⟩ and ~50%% |11⟩ (Bell state entanglement)\n");
     printf("(|01⟩ and |10⟩ indicate noise/errors)\n");
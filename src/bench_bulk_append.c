@@ -0,0 +1,139 @@
+/*
+ * Bulk append benchmark for the Qiskit C API
+ *
+ * Builds the same generated circuit (H layer, then layers of RZ on every
+ * qubit and CX along a chain, then measurements) two ways and reports
+ * instructions per second:
+ *
+ *   per-call  one qk_circuit_gate()/qk_circuit_measure() per instruction
+ *             with stack qarg arrays, as in bell_state_c.c
+ *   arrays    the stream generated into plain parallel arrays, appended with
+ *             qkx_circuit_append_gates() and qkx_circuit_measure_all()
+ *
+ * Usage: bench_bulk_append [num_qubits] [layers] [repeats]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <qiskit.h>
+
+#include "qk_bulk.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double angle(uint32_t layer, uint32_t q) {
+    return 0.1 * (layer + 1) + 0.001 * q;
+}
+
+static QkCircuit *build_per_call(uint32_t n, uint32_t layers) {
+    QkCircuit *qc = qk_circuit_new(n, n);
+    for (uint32_t q = 0; q < n; q++) {
+        uint32_t qargs[1] = {q};
+        qk_circuit_gate(qc, QkGate_H, qargs, NULL);
+    }
+    for (uint32_t l = 0; l < layers; l++) {
+        for (uint32_t q = 0; q < n; q++) {
+            uint32_t qargs[1] = {q};
+            double params[1] = {angle(l, q)};
+            qk_circuit_gate(qc, QkGate_RZ, qargs, params);
+        }
+        for (uint32_t q = 0; q + 1 < n; q++) {
+            uint32_t qargs[2] = {q, q + 1};
+            qk_circuit_gate(qc, QkGate_CX, qargs, NULL);
+        }
+    }
+    for (uint32_t q = 0; q < n; q++) {
+        qk_circuit_measure(qc, q, q);
+    }
+    return qc;
+}
+
+static QkCircuit *build_arrays(uint32_t n, uint32_t layers) {
+    size_t num_gates = n + (size_t)layers * (2 * n - 1);
+    QkGate *gates = malloc(num_gates * sizeof(QkGate));
+    uint32_t *qargs = malloc((n + (size_t)layers * (3 * n - 2)) * sizeof(uint32_t));
+    double *params = malloc((size_t)layers * n * sizeof(double));
+    if (gates == NULL || qargs == NULL || params == NULL) {
+        free(gates);
+        free(qargs);
+        free(params);
+        return NULL;
+    }
+
+    size_t g = 0, a = 0, p = 0;
+    for (uint32_t q = 0; q < n; q++) {
+        gates[g++] = QkGate_H;
+        qargs[a++] = q;
+    }
+    for (uint32_t l = 0; l < layers; l++) {
+        for (uint32_t q = 0; q < n; q++) {
+            gates[g++] = QkGate_RZ;
+            qargs[a++] = q;
+            params[p++] = angle(l, q);
+        }
+        for (uint32_t q = 0; q + 1 < n; q++) {
+            gates[g++] = QkGate_CX;
+            qargs[a++] = q;
+            qargs[a++] = q + 1;
+        }
+    }
+
+    QkCircuit *qc = qk_circuit_new(n, n);
+    qkx_circuit_append_gates(qc, g, gates, qargs, params);
+    qkx_circuit_measure_all(qc, n);
+    free(gates);
+    free(qargs);
+    free(params);
+    return qc;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t n = argc > 1 ? (uint32_t)atoi(argv[1]) : 127;
+    uint32_t layers = argc > 2 ? (uint32_t)atoi(argv[2]) : 4000;
+    int repeats = argc > 3 ? atoi(argv[3]) : 3;
+    if (n < 2 || layers < 1 || repeats < 1) {
+        fprintf(stderr, "Usage: %s [num_qubits >= 2] [layers] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    const char *names[2] = {"per-call", "arrays"};
+    size_t expected = 0;
+    int status = 0;
+
+    printf("Bulk append: %u qubits x %u layers, best of %d\n", n, layers, repeats);
+    for (int mode = 0; mode < 2; mode++) {
+        double best = 0.0;
+        for (int r = 0; r < repeats; r++) {
+            double start = now_seconds();
+            QkCircuit *qc = mode == 0 ? build_per_call(n, layers) : build_arrays(n, layers);
+            double elapsed = now_seconds() - start;
+            if (qc == NULL) {
+                fprintf(stderr, "ERROR: out of memory\n");
+                return 1;
+            }
+            size_t count = qk_circuit_num_instructions(qc);
+            if (expected == 0) {
+                expected = count;
+            } else if (count != expected) {
+                fprintf(stderr, "ERROR: %s built %zu instructions, expected %zu\n", names[mode], count,
+                        expected);
+                status = 1;
+            }
+            // Freeing is the same for every mode, so it stays out of the timing
+            qk_circuit_free(qc);
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        printf("  %-9s %8.3f s  %6.1f M instructions/s\n", names[mode], best, expected / best / 1e6);
+    }
+
+    return status;
+}
@@ -0,0 +1,111 @@
+/*
+ * Circuit-cutting reconstruction benchmark
+ *
+ * Cuts GHZ chains into K fragments of a fixed width, samples the distinct
+ * fragment circuits with the Pauli-frame engine under depolarizing noise on
+ * every CX, and times the two classical steps against K: loading the shots
+ * into bit columns and reconstructing every neighbour <Z_i Z_i+1>, the
+ * end-to-end <Z_0 Z_N-1> and the full parity, with one thread and with all
+ * of them. Noiseless fragments would reconstruct the ideal value 1 of every
+ * pair exactly; the error column is the mean deviation of the neighbour
+ * pairs from it, the CX noise seen through the reconstruction, and <Z0 ZN>
+ * shows the end-to-end correlation decaying along the noisy chain.
+ *
+ * Usage: bench_cutting [fragment_width] [shots] [num_threads] [cx_error]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "circuit_cutting.hpp"
+#include "parallel.hpp"
+#include "pauli_frame.hpp"
+
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Depolarizing error of average infidelity `cx_error` on every CX of `circ`
+qkx::NoiseModel cx_noise(const qkx::LocalCircuit& circ, double cx_error) {
+    qkx::NoiseModel noise;
+    for (const qkx::Operation& op : circ.ops()) {
+        if (op.kind == qkx::GateKind::CX) {
+            noise.set_gate_error(op.kind, {op.qubits[0], op.qubits[1]}, cx_error);
+        }
+    }
+    return noise;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const uint32_t width = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 20;
+    const size_t shots = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 8192;
+    const unsigned threads = qkx::default_num_threads(argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0);
+    const double cx_error = argc > 4 ? std::atof(argv[4]) : 0.01;
+    if (width < 2 || shots == 0 || cx_error < 0.0 || cx_error > 0.75) {
+        std::cerr << "Usage: bench_cutting [fragment_width >= 2] [shots > 0] [num_threads] [cx_error in 0..0.75]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::cout << "Fragments of " << width << " qubits, " << shots << " shots per circuit, "
+              << threads << " threads, CX error " << cx_error << std::endl;
+    std::cout << std::setw(5) << "K" << std::setw(8) << "qubits" << std::setw(10) << "circuits"
+              << std::setw(12) << "sample ms" << std::setw(11) << "load ms"
+              << std::setw(13) << "recon 1T ms" << std::setw(13) << "recon NT ms"
+              << std::setw(13) << "mean |err|" << std::setw(11) << "<Z0 ZN>" << std::endl;
+
+    for (uint32_t fragments : {2u, 4u, 8u, 16u, 32u, 64u}) {
+        const uint32_t num_qubits = fragments * (width - 1) + 1;
+        qkx::GhzCutting cut(num_qubits, width);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<qkx::PackedShots> results;
+        for (const qkx::LocalCircuit& circ : cut.circuits()) {
+            results.push_back(qkx::run_pauli_frame(circ, shots, cx_noise(circ, cx_error)));
+        }
+        const double sample_ms = ms_since(start);
+
+        start = std::chrono::steady_clock::now();
+        cut.load_results(results, threads);
+        const double load_ms = ms_since(start);
+
+        std::vector<std::vector<uint32_t>> observables;
+        for (uint32_t q = 0; q + 1 < num_qubits; q++) {
+            observables.push_back({q, q + 1});
+        }
+        observables.push_back({0, num_qubits - 1});
+        std::vector<uint32_t> all(num_qubits);
+        for (uint32_t q = 0; q < num_qubits; q++) {
+            all[q] = q;
+        }
+        observables.push_back(all);
+
+        start = std::chrono::steady_clock::now();
+        cut.expectations(observables, 1);
+        const double serial_ms = ms_since(start);
+        start = std::chrono::steady_clock::now();
+        std::vector<double> values = cut.expectations(observables, threads);
+        const double parallel_ms = ms_since(start);
+
+        double error = 0.0;
+        for (uint32_t q = 0; q + 1 < num_qubits; q++) {
+            error += std::fabs(values[q] - 1.0);
+        }
+        error /= num_qubits - 1;
+
+        std::cout << std::fixed << std::setw(5) << fragments << std::setw(8) << num_qubits
+                  << std::setw(10) << cut.circuits().size() << std::setprecision(1)
+                  << std::setw(12) << sample_ms << std::setw(11) << load_ms
+                  << std::setw(13) << serial_ms << std::setw(13) << parallel_ms << std::setprecision(4)
+                  << std::setw(13) << error << std::setw(11) << values[num_qubits - 1] << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Gate fusion benchmark
+ *
+ * Runs GHZ circuits on the statevector engine with fusion disabled, with
+ * fixed group widths and with the width chosen by the cost model, and
+ * reports memory passes over the statevector, wall time and the largest
+ * amplitude difference from the unfused run.
+ *
+ * Usage: bench_fusion [num_qubits] [num_threads]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gate_fusion.hpp"
+#include "local_circuit.hpp"
+#include "statevector.hpp"
+
+namespace {
+
+// H(0) followed by the CX fan-out of ghz_20q
+qkx::LocalCircuit ghz_fanout(uint32_t n) {
+    qkx::LocalCircuit circ(n, n);
+    circ.h(0);
+    for (uint32_t i = 1; i < n; i++) {
+        circ.cx(0, i);
+    }
+    return circ;
+}
+
+// The same state in a heavy-hex style basis: rz/sx single-qubit gates and
+// CZ along a chain, as the transpiler emits for IBM backends
+qkx::LocalCircuit ghz_transpiled(uint32_t n) {
+    const double half_pi = qkx::kPi / 2;
+    qkx::LocalCircuit circ(n, n);
+    auto hadamard = [&](uint32_t q) {
+        circ.rz(half_pi, q);
+        circ.sx(q);
+        circ.rz(half_pi, q);
+    };
+    hadamard(0);
+    for (uint32_t i = 1; i < n; i++) {
+        hadamard(i);
+        circ.cz(i - 1, i);
+        hadamard(i);
+    }
+    return circ;
+}
+
+struct Run {
+    qkx::StatevectorStats stats;
+    double ms = 0.0;
+    std::vector<qkx::cplx> state;
+};
+
+Run run(const qkx::LocalCircuit& circ, qkx::FusionOptions fusion, unsigned threads) {
+    qkx::StatevectorOptions options;
+    options.num_threads = threads;
+    options.fusion = fusion;
+    Run r;
+    auto start = std::chrono::steady_clock::now();
+    qkx::StatevectorSimulator sim(circ.num_qubits(), options);
+    sim.run(circ);
+    r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    r.stats = sim.stats();
+    r.state = sim.amplitudes();
+    return r;
+}
+
+void bench(const std::string& name, const qkx::LocalCircuit& circ, unsigned threads) {
+    std::cout << name << " (" << circ.num_qubits() << " qubits, " << circ.size() << " gates)" << std::endl;
+    std::cout << "  " << std::left << std::setw(10) << "fusion" << std::right
+              << std::setw(8) << "passes" << std::setw(8) << "width"
+              << std::setw(12) << "time (ms)" << std::setw(10) << "speedup"
+              << std::setw(12) << "max |diff|" << std::endl;
+
+    qkx::FusionOptions off;
+    off.enabled = false;
+    Run baseline = run(circ, off, threads);
+
+    std::vector<std::pair<std::string, qkx::FusionOptions>> configs;
+    configs.emplace_back("none", off);
+    for (uint32_t k = 2; k <= 5; k++) {
+        qkx::FusionOptions fixed;
+        fixed.width = k;
+        configs.emplace_back("k=" + std::to_string(k), fixed);
+    }
+    configs.emplace_back("auto", qkx::FusionOptions());
+
+    for (const auto& config : configs) {
+        Run r = config.first == "none" ? baseline : run(circ, config.second, threads);
+        double diff = 0.0;
+        for (size_t i = 0; i < r.state.size(); i++) {
+            diff = std::max(diff, std::abs(r.state[i] - baseline.state[i]));
+        }
+        std::cout << "  " << std::left << std::setw(10) << config.first << std::right
+                  << std::setw(8) << r.stats.num_passes
+                  << std::setw(8) << r.stats.max_fused_qubits
+                  << std::setw(12) << std::fixed << std::setprecision(1) << r.ms
+                  << std::setw(9) << std::setprecision(2) << baseline.ms / r.ms << "x"
+                  << std::setw(12) << std::scientific << std::setprecision(1) << diff
+                  << std::defaultfloat << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t num_qubits = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 24;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+    if (num_qubits < 2 || num_qubits > 30) {
+        std::cerr << "Error: num_qubits must be between 2 and 30" << std::endl;
+        return 1;
+    }
+
+    bench("GHZ fan-out", ghz_fanout(num_qubits), threads);
+    bench("GHZ, transpiled basis", ghz_transpiled(num_qubits), threads);
+    return 0;
+}
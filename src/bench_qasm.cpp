@@ -0,0 +1,202 @@
+/*
+ * QASM3 export benchmark
+ *
+ * Writes a transpiled-style circuit (rz/sx layers and CZ along a chain) as
+ * OpenQASM 3 four ways and reports throughput and peak resident memory:
+ *
+ *   string     whole program built in an ostringstream, then written, as
+ *              QuantumCircuit::to_qasm3() does
+ *   ostream    QasmWriter on an ofstream
+ *   fd         QasmWriter on a file descriptor
+ *   generated  QasmWriter on a file descriptor, operations generated on the
+ *              fly so the circuit itself is never stored
+ *
+ * Each mode runs in a child process so its peak RSS is its own.
+ *
+ * Usage: bench_qasm [num_qubits] [layers] [output]   (output: /dev/null)
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "local_circuit.hpp"
+#include "qasm_writer.hpp"
+
+namespace {
+
+// Calls `emit` for every operation of the benchmark circuit
+void generate(uint32_t n, uint32_t layers, const std::function<void(const qkx::Operation&)>& emit) {
+    qkx::Operation op{};
+    op.num_qubits = 1;
+    for (uint32_t l = 0; l < layers; l++) {
+        for (uint32_t q = 0; q < n; q++) {
+            op.kind = qkx::GateKind::RZ;
+            op.num_qubits = 1;
+            op.qubits[0] = q;
+            op.params[0] = 0.1 * (l + 1) + 0.01 * q;
+            emit(op);
+            op.kind = qkx::GateKind::SX;
+            emit(op);
+        }
+        for (uint32_t q = l & 1; q + 1 < n; q += 2) {
+            op.kind = qkx::GateKind::CZ;
+            op.num_qubits = 2;
+            op.qubits[0] = q;
+            op.qubits[1] = q + 1;
+            emit(op);
+        }
+    }
+    op.kind = qkx::GateKind::Measure;
+    op.num_qubits = 1;
+    for (uint32_t q = 0; q < n; q++) {
+        op.qubits[0] = q;
+        op.clbit = q;
+        emit(op);
+    }
+}
+
+qkx::LocalCircuit build(uint32_t n, uint32_t layers) {
+    qkx::LocalCircuit circ(n, n);
+    generate(n, layers, [&](const qkx::Operation& op) { circ.append(op); });
+    return circ;
+}
+
+// Program text through an ostringstream, as a string-returning exporter
+std::string to_string_qasm3(const qkx::LocalCircuit& circ) {
+    std::ostringstream out;
+    out.precision(17);
+    out << "OPENQASM 3.0;\ninclude \"stdgates.inc\";\n";
+    out << "bit[" << circ.num_clbits() << "] meas;\nqubit[" << circ.num_qubits() << "] q;\n";
+    for (const qkx::Operation& op : circ.ops()) {
+        if (op.kind == qkx::GateKind::Measure) {
+            out << "meas[" << op.clbit << "] = measure q[" << op.qubits[0] << "];\n";
+            continue;
+        }
+        out << qkx::gate_name(op.kind);
+        for (uint32_t p = 0; p < qkx::gate_num_params(op.kind); p++) {
+            out << (p == 0 ? '(' : ',') << op.params[p];
+        }
+        out << (qkx::gate_num_params(op.kind) ? ") " : " ");
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            out << (i ? ", q[" : "q[") << op.qubits[i] << ']';
+        }
+        out << ";\n";
+    }
+    return out.str();
+}
+
+// Bytes written by `mode`, in the calling (child) process
+uint64_t run_mode(const std::string& mode, uint32_t n, uint32_t layers, const std::string& path) {
+    if (mode == "ostream") {
+        qkx::LocalCircuit circ = build(n, layers);
+        std::ofstream out(path, std::ios::binary);
+        qkx::QasmWriter writer(out);
+        qkx::write_qasm3(circ, writer);
+        return writer.bytes_written();
+    }
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    uint64_t bytes = 0;
+    if (mode == "string") {
+        std::string text = to_string_qasm3(build(n, layers));
+        bytes = text.size();
+        if (::write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size())) {
+            throw std::runtime_error("short write");
+        }
+    } else if (mode == "fd") {
+        qkx::LocalCircuit circ = build(n, layers);
+        qkx::QasmWriter writer(fd);
+        qkx::write_qasm3(circ, writer);
+        bytes = writer.bytes_written();
+    } else {
+        qkx::QasmWriter writer(fd);
+        writer.begin(n, n, 1u << static_cast<int>(qkx::GateKind::CZ));
+        generate(n, layers, [&](const qkx::Operation& op) { writer.op(op); });
+        writer.finish();
+        bytes = writer.bytes_written();
+    }
+    ::close(fd);
+    return bytes;
+}
+
+struct Measurement {
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+    long peak_kib = 0;
+};
+
+Measurement measure(const std::string& mode, uint32_t n, uint32_t layers, const std::string& path) {
+    int pipe_fds[2];
+    if (::pipe(pipe_fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(pipe_fds[0]);
+        Measurement m;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            m.bytes = run_mode(mode, n, layers, path);
+        } catch (const std::exception& e) {
+            std::cerr << mode << ": " << e.what() << std::endl;
+            std::_Exit(1);
+        }
+        m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ssize_t sent = ::write(pipe_fds[1], &m, sizeof(m));
+        std::_Exit(sent == static_cast<ssize_t>(sizeof(m)) ? 0 : 1);
+    }
+    ::close(pipe_fds[1]);
+    Measurement m;
+    bool got = ::read(pipe_fds[0], &m, sizeof(m)) == static_cast<ssize_t>(sizeof(m));
+    ::close(pipe_fds[0]);
+    int status = 0;
+    rusage usage{};
+    ::wait4(pid, &status, 0, &usage);
+    if (!got || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error(mode + " run failed");
+    }
+    m.peak_kib = usage.ru_maxrss;
+    return m;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t n = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 127;
+    uint32_t layers = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 2000;
+    std::string path = argc > 3 ? argv[3] : "/dev/null";
+
+    std::cout << "QASM3 export: " << n << " qubits, " << layers << " layers -> " << path << std::endl;
+    std::cout << "  " << std::left << std::setw(11) << "mode" << std::right
+              << std::setw(12) << "size (MB)" << std::setw(11) << "time (s)"
+              << std::setw(10) << "MB/s" << std::setw(15) << "peak RSS (MB)" << std::endl;
+    try {
+        for (const char* mode : {"string", "ostream", "fd", "generated"}) {
+            Measurement m = measure(mode, n, layers, path);
+            double mb = m.bytes / 1e6;
+            std::cout << "  " << std::left << std::setw(11) << mode << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(12) << mb
+                      << std::setprecision(3) << std::setw(11) << m.seconds
+                      << std::setprecision(0) << std::setw(10) << mb / m.seconds
+                      << std::setprecision(1) << std::setw(15) << m.peak_kib / 1024.0 << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
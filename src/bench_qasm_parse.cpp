@@ -0,0 +1,142 @@
+/*
+ * QASM3 reader benchmark
+ *
+ * Writes a set of transpiled-style OpenQASM 3 files (rz/sx layers and CZ
+ * along a chain, on physical qubits as Qiskit exports them) to a temporary
+ * directory and reports the reader's throughput in MB/s: parsing alone and
+ * parsing plus lowering on one thread from memory, then read_qasm_files()
+ * from disk with 1, 2, 4, ... threads.
+ *
+ * Usage: bench_qasm_parse [num_files] [num_qubits] [layers] [max_threads]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+#include "qasm_reader.hpp"
+#include "qasm_writer.hpp"
+
+namespace {
+
+std::string make_program(uint32_t n, uint32_t layers, uint32_t seed) {
+    qkx::LocalCircuit circ(n, n);
+    for (uint32_t l = 0; l < layers; l++) {
+        for (uint32_t q = 0; q < n; q++) {
+            circ.rz(0.1 * (l + 1) + 0.001 * (q + seed), q);
+            circ.sx(q);
+        }
+        for (uint32_t q = l & 1; q + 1 < n; q += 2) {
+            circ.cz(q, q + 1);
+        }
+    }
+    circ.measure_all();
+    std::ostringstream text;
+    qkx::write_qasm3(circ, text);
+    // Physical qubits, as in a transpiled export
+    std::string program = text.str(), out;
+    out.reserve(program.size());
+    for (size_t i = 0; i < program.size(); i++) {
+        if (program.compare(i, 2, "q[") == 0) {
+            size_t close = program.find(']', i);
+            out += '$';
+            out.append(program, i + 2, close - i - 2);
+            i = close;
+        } else if (program.compare(i, 6, "qubit[") == 0) {
+            i = program.find('\n', i);
+        } else {
+            out += program[i];
+        }
+    }
+    return out;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t num_files = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 64;
+    uint32_t n = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 127;
+    uint32_t layers = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : 200;
+    unsigned max_threads = qkx::default_num_threads(argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 0);
+
+    char dir[] = "/tmp/bench_qasm_parse.XXXXXX";
+    if (!::mkdtemp(dir)) {
+        std::cerr << "Error: cannot create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> paths;
+    uint64_t total_bytes = 0;
+    std::string sample;
+    for (uint32_t f = 0; f < num_files; f++) {
+        std::string program = make_program(n, layers, f);
+        paths.push_back(std::string(dir) + "/circuit_" + std::to_string(f) + ".qasm");
+        std::ofstream(paths.back(), std::ios::binary) << program;
+        total_bytes += program.size();
+        if (f == 0) {
+            sample = program;
+        }
+    }
+    std::cout << "QASM3 reader: " << num_files << " files of " << n << " qubits x " << layers << " layers, "
+              << std::fixed << std::setprecision(1) << total_bytes / 1e6 << " MB" << std::endl;
+
+    // In-memory single-thread rates on the first file
+    const int repeats = 10;
+    size_t statements = 0, gates = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        qkx::QasmProgram prog;
+        prog.source.assign(sample.begin(), sample.end());
+        qkx::parse_qasm(prog);
+        statements = prog.statements.size();
+    }
+    double parse_s = seconds_since(start) / repeats;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        gates = qkx::read_qasm(sample).size();
+    }
+    double read_s = seconds_since(start) / repeats;
+    std::cout << "  one file in memory (" << statements << " statements, " << gates << " operations)" << std::endl;
+    std::cout << "    parse            " << std::setprecision(0) << std::setw(8) << sample.size() / 1e6 / parse_s
+              << " MB/s" << std::endl;
+    std::cout << "    parse + lower    " << std::setw(8) << sample.size() / 1e6 / read_s << " MB/s" << std::endl;
+
+    std::cout << "  read_qasm_files from disk" << std::endl;
+    int status = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        start = std::chrono::steady_clock::now();
+        std::vector<qkx::QasmFileResult> results = qkx::read_qasm_files(paths, threads);
+        double s = seconds_since(start);
+        for (const auto& r : results) {
+            if (!r.error.empty()) {
+                std::cerr << "Error: " << r.error << std::endl;
+                status = 1;
+            }
+        }
+        std::cout << "    " << std::setw(2) << threads << " thread" << (threads > 1 ? "s" : " ") << "       "
+                  << std::setw(8) << total_bytes / 1e6 / s << " MB/s  (" << std::setprecision(3) << s
+                  << " s)" << std::setprecision(0) << std::endl;
+        if (threads * 2 > max_threads && threads != max_threads) {
+            threads = max_threads / 2;
+        }
+    }
+
+    for (const std::string& path : paths) {
+        std::remove(path.c_str());
+    }
+    ::rmdir(dir);
+    return status;
+}
@@ -0,0 +1,266 @@
+/*
+ * Packed measurement outcomes
+ *
+ * Sampler results arrive as strings, either binary ("0110") or hex
+ * ("0x6"). Analysis code works on outcomes packed into 64-bit words, with
+ * bit i of the packed value holding classical bit i, so a 127-qubit
+ * outcome fits in two words and Hamming distances are a few popcounts.
+ */
+
+#ifndef QKX_BITSTRING_HPP
+#define QKX_BITSTRING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace qkx {
+
+inline uint32_t num_words(uint32_t num_bits) {
+    return (num_bits + 63) / 64;
+}
+
+inline int popcount64(uint64_t x) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(x));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// Index of the lowest set bit; x must be non-zero
+inline int ctz64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+class Bitstring {
+public:
+    Bitstring() = default;
+    explicit Bitstring(uint32_t num_bits)
+        : num_bits_(num_bits), words_(num_words(num_bits), 0) {}
+
+    uint32_t num_bits() const { return num_bits_; }
+    const std::vector<uint64_t>& words() const { return words_; }
+    uint64_t* data() { return words_.data(); }
+    const uint64_t* data() const { return words_.data(); }
+
+    bool get(uint32_t bit) const {
+        return (words_[bit >> 6] >> (bit & 63)) & 1ULL;
+    }
+    void set(uint32_t bit, bool value = true) {
+        uint64_t mask = 1ULL << (bit & 63);
+        if (value) {
+            words_[bit >> 6] |= mask;
+        } else {
+            words_[bit >> 6] &= ~mask;
+        }
+    }
+    void flip(uint32_t bit) {
+        words_[bit >> 6] ^= 1ULL << (bit & 63);
+    }
+
+    int hamming_weight() const {
+        int weight = 0;
+        for (uint64_t w : words_) {
+            weight += popcount64(w);
+        }
+        return weight;
+    }
+
+    // Parse a key as returned by BitArray::get_counts(): either a binary
+    // string with the highest classical bit first, or a "0x"-prefixed hex
+    // value with bit i holding classical bit i.
+    static Bitstring from_string(const std::string& key, uint32_t num_bits) {
+        Bitstring b(num_bits);
+        if (key.size() > 2 && key[0] == '0' && (key[1] == 'x' || key[1] == 'X')) {
+            uint32_t bit = 0;
+            for (size_t i = key.size(); i > 2; i--) {
+                int nibble = hex_value(key[i - 1]);
+                if (nibble < 0) {
+                    throw std::invalid_argument("invalid hex outcome: " + key);
+                }
+                for (int k = 0; k < 4; k++, bit++) {
+                    if ((nibble >> k) & 1) {
+                        if (bit >= num_bits) {
+                            throw std::invalid_argument("outcome wider than register: " + key);
+                        }
+                        b.set(bit);
+                    }
+                }
+            }
+            return b;
+        }
+        if (key.size() > num_bits) {
+            throw std::invalid_argument("outcome wider than register: " + key);
+        }
+        uint32_t bit = 0;
+        for (size_t i = key.size(); i > 0; i--, bit++) {
+            char c = key[i - 1];
+            if (c == '1') {
+                b.set(bit);
+            } else if (c != '0') {
+                throw std::invalid_argument("invalid binary outcome: " + key);
+            }
+        }
+        return b;
+    }
+
+    // Binary string, highest classical bit first (Qiskit ordering)
+    std::string to_string() const {
+        std::string s(num_bits_, '0');
+        for (uint32_t bit = 0; bit < num_bits_; bit++) {
+            if (get(bit)) {
+                s[num_bits_ - 1 - bit] = '1';
+            }
+        }
+        return s;
+    }
+
+    bool operator==(const Bitstring& other) const {
+        return num_bits_ == other.num_bits_ && words_ == other.words_;
+    }
+    bool operator!=(const Bitstring& other) const { return !(*this == other); }
+    bool operator<(const Bitstring& other) const {
+        return std::lexicographical_compare(words_.rbegin(), words_.rend(),
+                                            other.words_.rbegin(), other.words_.rend());
+    }
+
+private:
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    uint32_t num_bits_ = 0;
+    std::vector<uint64_t> words_;
+};
+
+inline int hamming_distance(const uint64_t* a, const uint64_t* b, uint32_t words) {
+    int d = 0;
+    for (uint32_t w = 0; w < words; w++) {
+        d += popcount64(a[w] ^ b[w]);
+    }
+    return d;
+}
+
+inline int hamming_distance(const Bitstring& a, const Bitstring& b) {
+    return hamming_distance(a.data(), b.data(), num_words(a.num_bits()));
+}
+
+struct BitstringHash {
+    size_t operator()(const Bitstring& b) const {
+        uint64_t h = 0x9e3779b97f4a7c15ULL ^ b.num_bits();
+        for (uint64_t w : b.words()) {
+            h ^= w + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            h *= 0xff51afd7ed558ccdULL;
+        }
+        return static_cast<size_t>(h ^ (h >> 33));
+    }
+};
+
+// Sparse histogram of observed outcomes
+using Histogram = std::vector<std::pair<Bitstring, uint64_t>>;
+
+// Convert the string-keyed map from BitArray::get_counts() to packed form
+template <typename Counts>
+Histogram histogram_from_counts(const Counts& counts, uint32_t num_bits) {
+    Histogram hist;
+    hist.reserve(counts.size());
+    for (const auto& c : counts) {
+        hist.emplace_back(Bitstring::from_string(c.first, num_bits),
+                          static_cast<uint64_t>(c.second));
+    }
+    return hist;
+}
+
+// Per-shot outcomes stored back to back, num_words(num_bits) words per shot
+class PackedShots {
+public:
+    PackedShots() = default;
+    explicit PackedShots(uint32_t num_bits, size_t num_shots = 0)
+        : num_bits_(num_bits), words_(num_words(num_bits)), data_(num_shots * words_, 0) {}
+
+    uint32_t num_bits() const { return num_bits_; }
+    uint32_t words_per_shot() const { return words_; }
+    size_t num_shots() const { return words_ ? data_.size() / words_ : 0; }
+
+    uint64_t* shot(size_t i) { return data_.data() + i * words_; }
+    const uint64_t* shot(size_t i) const { return data_.data() + i * words_; }
+    uint64_t* data() { return data_.data(); }
+    const uint64_t* data() const { return data_.data(); }
+
+    void reserve(size_t num_shots) { data_.reserve(num_shots * words_); }
+    void resize(size_t num_shots) { data_.resize(num_shots * words_, 0); }
+    void push_back(const Bitstring& b) {
+        if (b.num_bits() != num_bits_) {
+            throw std::invalid_argument("shot has " + std::to_string(b.num_bits()) + " bits, expected " +
+                                        std::to_string(num_bits_));
+        }
+        data_.insert(data_.end(), b.words().begin(), b.words().end());
+    }
+
+    Bitstring get(size_t i) const {
+        Bitstring b(num_bits_);
+        std::copy(shot(i), shot(i) + words_, b.data());
+        return b;
+    }
+
+    // Pack the per-shot strings returned by BitArray::get_bitstrings()
+    template <typename Strings>
+    static PackedShots from_strings(const Strings& strings, uint32_t num_bits) {
+        PackedShots shots(num_bits);
+        shots.reserve(strings.size());
+        for (const auto& s : strings) {
+            shots.push_back(Bitstring::from_string(s, num_bits));
+        }
+        return shots;
+    }
+
+private:
+    uint32_t num_bits_ = 0;
+    uint32_t words_ = 0;
+    std::vector<uint64_t> data_;
+};
+
+// String-keyed counts in the same form as BitArray::get_counts(), for
+// results produced by the local engines
+inline std::unordered_map<std::string, uint64_t> counts_from_shots(const PackedShots& shots) {
+    std::unordered_map<Bitstring, uint64_t, BitstringHash> packed;
+    for (size_t i = 0; i < shots.num_shots(); i++) {
+        packed[shots.get(i)]++;
+    }
+    std::unordered_map<std::string, uint64_t> counts;
+    for (const auto& p : packed) {
+        counts.emplace(p.first.to_string(), p.second);
+    }
+    return counts;
+}
+
+inline uint64_t total_shots(const Histogram& hist) {
+    uint64_t total = 0;
+    for (const auto& h : hist) {
+        total += h.second;
+    }
+    return total;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_BITSTRING_HPP
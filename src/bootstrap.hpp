@@ -0,0 +1,300 @@
+/*
+ * Bootstrap confidence intervals for sampled probabilities
+ *
+ * Every statistic here is a mean over shots of a per-shot value (an
+ * indicator for a probability, ±1 for a parity), so shots only matter
+ * through the class they fall in: an outcome, or a coarser category such
+ * as "all-0", "all-1", "other with even parity". A bootstrap resample is
+ * then a multinomial draw of class counts.
+ *
+ * With few classes each resample is drawn as a chain of conditional
+ * binomials, O(classes) regardless of shots; with many classes shot
+ * indices are drawn directly and counted per class, O(shots). Statistics
+ * are then weighted sums of the class counts; per-outcome probabilities
+ * (class_intervals) read them off directly. Resamples are split
+ * across threads, each with its own xoshiro256** stream, so results are
+ * reproducible for a given seed and thread count. Intervals are
+ * percentile intervals.
+ */
+
+#ifndef QKX_BOOTSTRAP_HPP
+#define QKX_BOOTSTRAP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+
+namespace qkx {
+
+struct ConfidenceInterval {
+    double estimate = 0.0;
+    double lower = 0.0;
+    double upper = 0.0;
+    double std_error = 0.0;
+};
+
+struct BootstrapOptions {
+    size_t resamples = 1000;
+    double confidence = 0.95;
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+    uint64_t seed = 0x5eed;
+};
+
+class Bootstrap {
+public:
+    // class_counts[c] = number of shots that fell in class c
+    explicit Bootstrap(std::vector<uint64_t> class_counts, BootstrapOptions options = BootstrapOptions())
+        : counts_(std::move(class_counts)), options_(options) {
+        for (uint64_t c : counts_) {
+            shots_ += c;
+        }
+        if (shots_ == 0) {
+            throw std::invalid_argument("bootstrap needs at least one shot");
+        }
+        options_.num_threads = default_num_threads(options_.num_threads);
+    }
+
+    uint64_t shots() const { return shots_; }
+
+    // Interval for each statistic s, defined by values[s][c], the value of a
+    // shot in class c; the statistic is the mean of that value over shots
+    std::vector<ConfidenceInterval> mean_intervals(const std::vector<std::vector<double>>& values) const {
+        const size_t num_stats = values.size();
+        const size_t num_classes = counts_.size();
+        for (const auto& v : values) {
+            if (v.size() != num_classes) {
+                throw std::invalid_argument("statistic values do not match number of classes");
+            }
+        }
+
+        // replicates[s * resamples + r]
+        const size_t resamples = options_.resamples;
+        std::vector<double> replicates(num_stats * resamples);
+        resample([&](size_t r, const std::vector<uint64_t>& draw) {
+            for (size_t s = 0; s < num_stats; s++) {
+                const double* v = values[s].data();
+                double sum = 0.0;
+                for (size_t c = 0; c < num_classes; c++) {
+                    sum += static_cast<double>(draw[c]) * v[c];
+                }
+                replicates[s * resamples + r] = sum / static_cast<double>(shots_);
+            }
+        });
+
+        std::vector<double> estimates(num_stats);
+        for (size_t s = 0; s < num_stats; s++) {
+            double point = 0.0;
+            for (size_t c = 0; c < num_classes; c++) {
+                point += static_cast<double>(counts_[c]) * values[s][c];
+            }
+            estimates[s] = point / static_cast<double>(shots_);
+        }
+        return summarize(replicates, estimates);
+    }
+
+    // Interval for the probability of each class; the replicate of class c
+    // is its share of the resample, O(classes) per resample
+    std::vector<ConfidenceInterval> class_intervals() const {
+        const size_t num_classes = counts_.size();
+        const size_t resamples = options_.resamples;
+        std::vector<double> replicates(num_classes * resamples);
+        resample([&](size_t r, const std::vector<uint64_t>& draw) {
+            for (size_t c = 0; c < num_classes; c++) {
+                replicates[c * resamples + r] = static_cast<double>(draw[c]) / static_cast<double>(shots_);
+            }
+        });
+
+        std::vector<double> estimates(num_classes);
+        for (size_t c = 0; c < num_classes; c++) {
+            estimates[c] = static_cast<double>(counts_[c]) / static_cast<double>(shots_);
+        }
+        return summarize(replicates, estimates);
+    }
+
+private:
+    // Calls record(r, draw) for every resample r with its class counts.
+    // With few classes draw is a multinomial draw; otherwise shot indices
+    // are drawn and counted per class.
+    template <typename Record>
+    void resample(Record&& record) const {
+        const size_t num_classes = counts_.size();
+        const bool multinomial = num_classes * 32 < shots_;
+
+        std::vector<uint32_t> shot_class;
+        if (!multinomial) {
+            shot_class.reserve(shots_);
+            for (size_t c = 0; c < num_classes; c++) {
+                shot_class.insert(shot_class.end(), counts_[c], static_cast<uint32_t>(c));
+            }
+        }
+
+        parallel_for(options_.resamples, options_.num_threads, 1, [&](size_t begin, size_t end, unsigned t) {
+            Xoshiro256 rng = Xoshiro256(options_.seed).stream(t);
+            std::vector<uint64_t> draw(num_classes);
+            for (size_t r = begin; r < end; r++) {
+                if (multinomial) {
+                    multinomial_draw(rng, draw);
+                } else {
+                    std::fill(draw.begin(), draw.end(), 0);
+                    for (uint64_t i = 0; i < shots_; i++) {
+                        draw[shot_class[rng.below(shots_)]]++;
+                    }
+                }
+                record(r, draw);
+            }
+        });
+    }
+
+    // Percentile intervals from replicates[s * resamples + r], which are
+    // reordered; statistics are split across threads
+    std::vector<ConfidenceInterval> summarize(std::vector<double>& replicates,
+                                              const std::vector<double>& estimates) const {
+        const size_t resamples = options_.resamples;
+        const double alpha = 1.0 - options_.confidence;
+        std::vector<ConfidenceInterval> out(estimates.size());
+        parallel_for(estimates.size(), options_.num_threads, 64, [&](size_t begin, size_t end, unsigned) {
+            for (size_t s = begin; s < end; s++) {
+                summarize_one(replicates.data() + s * resamples, resamples, alpha, out[s]);
+                out[s].estimate = estimates[s];
+            }
+        });
+        return out;
+    }
+
+    static void summarize_one(double* rep, size_t resamples, double alpha, ConfidenceInterval& out) {
+        double mean = 0.0, sq = 0.0;
+        for (size_t r = 0; r < resamples; r++) {
+            mean += rep[r];
+        }
+        mean /= static_cast<double>(resamples);
+        for (size_t r = 0; r < resamples; r++) {
+            sq += (rep[r] - mean) * (rep[r] - mean);
+        }
+        out.std_error = resamples > 1 ? std::sqrt(sq / static_cast<double>(resamples - 1)) : 0.0;
+        out.lower = quantile(rep, resamples, alpha / 2);
+        out.upper = quantile(rep, resamples, 1.0 - alpha / 2);
+    }
+
+    // Multinomial(shots, counts / shots) as a chain of conditional binomials
+    void multinomial_draw(Xoshiro256& rng, std::vector<uint64_t>& draw) const {
+        uint64_t remaining_shots = shots_;
+        uint64_t remaining_mass = shots_;
+        for (size_t c = 0; c < counts_.size(); c++) {
+            if (remaining_shots == 0 || counts_[c] == remaining_mass) {
+                draw[c] = remaining_shots;
+                remaining_shots = 0;
+            } else if (counts_[c] == 0) {
+                draw[c] = 0;
+            } else {
+                double p = static_cast<double>(counts_[c]) / static_cast<double>(remaining_mass);
+                std::binomial_distribution<uint64_t> binomial(remaining_shots, p);
+                draw[c] = binomial(rng);
+                remaining_shots -= draw[c];
+            }
+            remaining_mass -= counts_[c];
+        }
+    }
+
+    // Linearly interpolated q-quantile of the n values; partially reorders
+    // them (selection, not a full sort)
+    static double quantile(double* values, size_t n, double q) {
+        if (n == 0) {
+            return 0.0;
+        }
+        double pos = q * static_cast<double>(n - 1);
+        size_t lo = static_cast<size_t>(std::floor(pos));
+        double frac = pos - static_cast<double>(lo);
+        std::nth_element(values, values + lo, values + n);
+        double low = values[lo];
+        double high = lo + 1 < n ? *std::min_element(values + lo + 1, values + n) : low;
+        return low * (1.0 - frac) + high * frac;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t shots_ = 0;
+    BootstrapOptions options_;
+};
+
+// Interval for the probability of every entry of a counts map, in the
+// map's iteration order
+template <typename Counts>
+std::vector<ConfidenceInterval> probability_intervals(const Counts& counts,
+                                                      BootstrapOptions options = BootstrapOptions()) {
+    std::vector<uint64_t> class_counts;
+    for (const auto& c : counts) {
+        class_counts.push_back(static_cast<uint64_t>(c.second));
+    }
+    return Bootstrap(class_counts, options).class_intervals();
+}
+
+struct GhzIntervals {
+    ConfidenceInterval all_zeros;
+    ConfidenceInterval all_ones;
+    ConfidenceInterval population;  // P(all-0) + P(all-1)
+    ConfidenceInterval parity;      // <Z...Z>
+};
+
+// GHZ statistics only depend on four classes of shots: all-0, all-1, and
+// the remaining outcomes split by parity
+class GhzClassifier {
+public:
+    explicit GhzClassifier(uint32_t num_qubits) : num_qubits_(num_qubits), counts_(4, 0) {}
+
+    void add(const uint64_t* outcome, uint64_t count = 1) {
+        int weight = 0;
+        for (uint32_t w = 0; w < num_words(num_qubits_); w++) {
+            weight += popcount64(outcome[w]);
+        }
+        if (weight == 0) {
+            counts_[0] += count;
+        } else if (weight == static_cast<int>(num_qubits_)) {
+            counts_[1] += count;
+        } else {
+            counts_[2 + (weight & 1)] += count;
+        }
+    }
+
+    GhzIntervals intervals(BootstrapOptions options = BootstrapOptions()) const {
+        double all_ones_parity = (num_qubits_ & 1) ? -1.0 : 1.0;
+        std::vector<std::vector<double>> values = {
+            {1.0, 0.0, 0.0, 0.0},
+            {0.0, 1.0, 0.0, 0.0},
+            {1.0, 1.0, 0.0, 0.0},
+            {1.0, all_ones_parity, 1.0, -1.0},
+        };
+        auto ci = Bootstrap(counts_, options).mean_intervals(values);
+        return {ci[0], ci[1], ci[2], ci[3]};
+    }
+
+private:
+    uint32_t num_qubits_;
+    std::vector<uint64_t> counts_;  // all-0, all-1, other even, other odd
+};
+
+inline GhzIntervals ghz_intervals(const Histogram& hist, uint32_t num_qubits,
+                                  BootstrapOptions options = BootstrapOptions()) {
+    GhzClassifier classes(num_qubits);
+    for (const auto& h : hist) {
+        classes.add(h.first.data(), h.second);
+    }
+    return classes.intervals(options);
+}
+
+inline GhzIntervals ghz_intervals(const PackedShots& shots, BootstrapOptions options = BootstrapOptions()) {
+    GhzClassifier classes(shots.num_bits());
+    for (size_t i = 0; i < shots.num_shots(); i++) {
+        classes.add(shots.shot(i));
+    }
+    return classes.intervals(options);
+}
+
+}  // namespace qkx
+
+#endif  // QKX_BOOTSTRAP_HPP
@@ -0,0 +1,55 @@
+/*
+ * Circuit library builder - OpenQASM 3 files to a binary circuit library
+ *
+ * Parses the given files in parallel and stores each circuit under its file
+ * name without directory and extension, so batch_runner and runtime_daemon
+ * jobs can name it as {"library": "<out>", "entry": "<name>"} and load it
+ * without parsing.
+ *
+ * Usage: build_library <out.qkxl> <file.qasm>...
+ */
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "circuit_library.hpp"
+#include "qasm_reader.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <out.qkxl> <file.qasm>..." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> paths(argv + 2, argv + argc);
+    std::vector<qkx::QasmFileResult> parsed = qkx::read_qasm_files(paths);
+
+    size_t failed = 0;
+    uint64_t bytes = 0;
+    try {
+        qkx::CircuitLibraryWriter writer(argv[1]);
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (!parsed[i].error.empty()) {
+                std::cerr << "Error: " << parsed[i].error << std::endl;
+                failed++;
+                continue;
+            }
+            bytes += parsed[i].bytes;
+            nlohmann::json metadata = {{"source", paths[i]}};
+            writer.add(parsed[i].circuit, std::filesystem::path(paths[i]).stem().string(), metadata.dump());
+        }
+        if (failed) {
+            return 1;  // the writer drops the partial library
+        }
+        writer.close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << paths.size() << " circuits (" << bytes << " bytes of QASM) to " << argv[1]
+              << std::endl;
+    return 0;
+}
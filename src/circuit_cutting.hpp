@@ -0,0 +1,291 @@
+/*
+ * Wire cutting for GHZ chains wider than the device
+ *
+ * The chain H(0), CX(0,1), CX(1,2), ..., CX(N-2,N-1) only passes one qubit
+ * from one stretch to the next, so cutting that wire at qubits c_1 < ... <
+ * c_{K-1} splits it into K fragments: fragment k runs the chain over
+ * logical qubits c_k..c_{k+1}, the last of which is only measured for the
+ * cut, and its first qubit stands in for c_k after the cut. The identity
+ * channel on the cut wire is expanded as (Peng et al., PRL 125, 150504)
+ *
+ *   ρ = ½ Σ_{P ∈ {I,X,Y,Z}} Tr(Pρ) P,
+ *   I = |0⟩⟨0| + |1⟩⟨1|,  Z = |0⟩⟨0| - |1⟩⟨1|,
+ *   X = 2|+⟩⟨+| - I,  Y = 2|+i⟩⟨+i| - I,
+ *
+ * so each fragment is run with its cut qubit measured in the Z, X and Y
+ * bases and its first qubit prepared in |0⟩, |1⟩, |+⟩ and |+i⟩: up to 12
+ * variants, with every inner fragment of the same width sharing the same
+ * 12 circuits. Only the distinct circuits (by fingerprint) are run.
+ *
+ * A Z-string observable factorizes over the fragments. Per fragment its
+ * expectation, times the cut eigenvalue, forms a 4x4 matrix over (input
+ * Pauli, output Pauli); the observable is the product of these matrices
+ * along the chain, scaled by 2^-(K-1). Fragment results are stored as bit
+ * columns (one bit per shot), so a fragment factor is an XOR of a few
+ * columns and a popcount. Reconstruction is linear in K per observable and
+ * parallel over observables; the number of shots needed for a given
+ * accuracy grows as 4^(K-1), which is what limits K in practice.
+ */
+
+#ifndef QKX_CIRCUIT_CUTTING_HPP
+#define QKX_CIRCUIT_CUTTING_HPP
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "circuit_fingerprint.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+
+namespace qkx {
+
+enum class CutPrep : uint8_t { Zero, One, Plus, PlusI };
+enum class CutBasis : uint8_t { Z, X, Y };
+
+class GhzCutting {
+public:
+    // Fragments of at most max_width qubits, as few as possible and of
+    // nearly equal width
+    GhzCutting(uint32_t num_qubits, uint32_t max_width) : num_qubits_(num_qubits) {
+        if (num_qubits < 2 || max_width < 2) {
+            throw std::invalid_argument("cutting needs at least 2 qubits and fragments of at least 2");
+        }
+        uint32_t fragments = (num_qubits - 1 + max_width - 2) / (max_width - 1);
+        for (uint32_t k = 0; k <= fragments; k++) {
+            cuts_.push_back(static_cast<uint32_t>(static_cast<uint64_t>(num_qubits - 1) * k / fragments));
+        }
+        std::map<Fingerprint, size_t> seen;
+        for (uint32_t k = 0; k < fragments; k++) {
+            variant_offset_.push_back(variant_circuit_.size());
+            for (uint32_t a = 0; a < num_preps(k); a++) {
+                for (uint32_t b = 0; b < num_bases(k); b++) {
+                    LocalCircuit circ = fragment_circuit(k, static_cast<CutPrep>(a), static_cast<CutBasis>(b));
+                    auto it = seen.emplace(fingerprint(circ), circuits_.size()).first;
+                    if (it->second == circuits_.size()) {
+                        circuits_.push_back(std::move(circ));
+                    }
+                    variant_circuit_.push_back(it->second);
+                }
+            }
+        }
+    }
+
+    uint32_t num_qubits() const { return num_qubits_; }
+    uint32_t num_fragments() const { return static_cast<uint32_t>(cuts_.size() - 1); }
+    uint32_t fragment_width(uint32_t k) const { return cuts_[k + 1] - cuts_[k] + 1; }
+
+    // The circuits to run, each once
+    const std::vector<LocalCircuit>& circuits() const { return circuits_; }
+
+    LocalCircuit fragment_circuit(uint32_t k, CutPrep prep, CutBasis basis) const {
+        const uint32_t w = fragment_width(k);
+        LocalCircuit circ(w, w);
+        if (k == 0) {
+            circ.h(0);
+        } else if (prep == CutPrep::One) {
+            circ.x(0);
+        } else if (prep != CutPrep::Zero) {
+            circ.h(0);
+            if (prep == CutPrep::PlusI) {
+                circ.s(0);
+            }
+        }
+        for (uint32_t l = 0; l + 1 < w; l++) {
+            circ.cx(l, l + 1);
+        }
+        if (k + 1 < num_fragments() && basis != CutBasis::Z) {
+            if (basis == CutBasis::Y) {
+                circ.sdg(w - 1);
+            }
+            circ.h(w - 1);
+        }
+        circ.measure_all();
+        return circ;
+    }
+
+    // Shots of circuits()[i] in shots[i]; converted to bit columns
+    void load_results(const std::vector<PackedShots>& shots, unsigned num_threads = 0) {
+        if (shots.size() != circuits_.size()) {
+            throw std::invalid_argument("expected one result per cutting circuit");
+        }
+        for (size_t i = 0; i < shots.size(); i++) {
+            if (shots[i].num_bits() != circuits_[i].num_qubits() || shots[i].num_shots() == 0) {
+                throw std::invalid_argument("cutting result has the wrong width or no shots");
+            }
+        }
+        results_.assign(shots.size(), Columns());
+        parallel_for(shots.size(), default_num_threads(num_threads), 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) {
+                results_[i] = Columns(shots[i], circuits_[i].num_qubits());
+            }
+        });
+        identity_.clear();
+        for (uint32_t k = 0; k < num_fragments(); k++) {
+            identity_.push_back(fragment_matrix(k, nullptr, 0));
+        }
+    }
+
+    // ⟨Z_q1 Z_q2 ...⟩ on the uncut N-qubit state; qubits in ascending order
+    double expectation(const std::vector<uint32_t>& z_qubits) const {
+        std::vector<uint32_t> local;
+        return expectation(z_qubits, local);
+    }
+
+    // Errors in any observable are rethrown here, on the calling thread
+    std::vector<double> expectations(const std::vector<std::vector<uint32_t>>& observables,
+                                     unsigned num_threads = 0) const {
+        const unsigned threads = default_num_threads(num_threads);
+        std::vector<double> out(observables.size());
+        std::vector<std::exception_ptr> errors(threads);
+        parallel_for(observables.size(), threads, 64, [&](size_t begin, size_t end, unsigned t) {
+            try {
+                std::vector<uint32_t> local;
+                for (size_t i = begin; i < end; i++) {
+                    out[i] = expectation(observables[i], local);
+                }
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        return out;
+    }
+
+private:
+    // `local` is scratch space for the fragment-local qubit indices, reused
+    // across calls
+    double expectation(const std::vector<uint32_t>& z_qubits, std::vector<uint32_t>& local) const {
+        if (results_.empty()) {
+            throw std::logic_error("load_results() first");
+        }
+        const uint32_t fragments = num_fragments();
+        std::array<double, 4> v = {0.0, 0.0, 0.0, 0.0};
+        size_t next = 0;
+        for (uint32_t k = 0; k < fragments; k++) {
+            // Qubits whose Z this fragment measures: c_k..c_{k+1}-1, and
+            // the last qubit too in the last fragment
+            uint32_t end = k + 1 == fragments ? num_qubits_ : cuts_[k + 1];
+            local.clear();
+            while (next < z_qubits.size() && z_qubits[next] < end) {
+                if (next > 0 && z_qubits[next] <= z_qubits[next - 1]) {
+                    throw std::invalid_argument("observable qubits not ascending");
+                }
+                local.push_back(z_qubits[next++] - cuts_[k]);
+            }
+            Matrix m = local.empty() ? identity_[k]
+                                     : fragment_matrix(k, local.data(), static_cast<uint32_t>(local.size()));
+            if (k == 0) {
+                v = m[0];
+            } else {
+                std::array<double, 4> w = {0.0, 0.0, 0.0, 0.0};
+                for (int p = 0; p < 4; p++) {
+                    for (int o = 0; o < 4; o++) {
+                        w[o] += 0.5 * v[p] * m[p][o];
+                    }
+                }
+                v = w;
+            }
+        }
+        if (next != z_qubits.size()) {
+            throw std::invalid_argument("observable qubits out of range");
+        }
+        return v[0];
+    }
+
+    // [input Pauli][output Pauli], both in the order I, Z, X, Y. Without an
+    // input (first fragment) only row 0 is used, without an output (last
+    // fragment) only column 0.
+    using Matrix = std::array<std::array<double, 4>, 4>;
+
+    // Per-qubit bit columns of one circuit's shots
+    struct Columns {
+        Columns() = default;
+        Columns(const PackedShots& shots, uint32_t num_bits)
+            : words(static_cast<uint32_t>((shots.num_shots() + 63) / 64)),
+              num_shots(shots.num_shots()),
+              bits(static_cast<size_t>(num_bits) * words, 0) {
+            if (shots.num_bits() != num_bits || num_shots == 0) {
+                throw std::invalid_argument("cutting result has the wrong width or no shots");
+            }
+            for (size_t s = 0; s < num_shots; s++) {
+                const uint64_t* shot = shots.shot(s);
+                for (uint32_t b = 0; b < num_bits; b++) {
+                    bits[b * words + s / 64] |= ((shot[b >> 6] >> (b & 63)) & 1ULL) << (s % 64);
+                }
+            }
+        }
+
+        // E[(-1)^(XOR of the given bits)]
+        double parity(const uint32_t* which, uint32_t count, int extra) const {
+            uint64_t odd = 0;
+            for (uint32_t w = 0; w < words; w++) {
+                uint64_t x = extra >= 0 ? bits[static_cast<size_t>(extra) * words + w] : 0;
+                for (uint32_t i = 0; i < count; i++) {
+                    x ^= bits[static_cast<size_t>(which[i]) * words + w];
+                }
+                odd += popcount64(x);
+            }
+            return 1.0 - 2.0 * static_cast<double>(odd) / static_cast<double>(num_shots);
+        }
+
+        uint32_t words = 0;
+        size_t num_shots = 0;
+        std::vector<uint64_t> bits;
+    };
+
+    uint32_t num_preps(uint32_t k) const { return k == 0 ? 1 : 4; }
+    uint32_t num_bases(uint32_t k) const { return k + 1 < num_fragments() ? 3 : 1; }
+
+    const Columns& result(uint32_t k, uint32_t prep, uint32_t basis) const {
+        return results_[variant_circuit_[variant_offset_[k] + prep * num_bases(k) + basis]];
+    }
+
+    Matrix fragment_matrix(uint32_t k, const uint32_t* local, uint32_t count) const {
+        // e[a][o]: observable times the output eigenvalue, with input state a
+        const int cut = static_cast<int>(fragment_width(k)) - 1;
+        const bool output = k + 1 < num_fragments();
+        double e[4][4] = {};
+        for (uint32_t a = 0; a < num_preps(k); a++) {
+            e[a][0] = result(k, a, 0).parity(local, count, -1);
+            if (output) {
+                e[a][1] = result(k, a, static_cast<uint32_t>(CutBasis::Z)).parity(local, count, cut);
+                e[a][2] = result(k, a, static_cast<uint32_t>(CutBasis::X)).parity(local, count, cut);
+                e[a][3] = result(k, a, static_cast<uint32_t>(CutBasis::Y)).parity(local, count, cut);
+            }
+        }
+        Matrix m{};
+        for (int o = 0; o < 4; o++) {
+            if (k == 0) {
+                m[0][o] = e[0][o];
+                continue;
+            }
+            const double both = e[0][o] + e[1][o];
+            m[0][o] = both;
+            m[1][o] = e[0][o] - e[1][o];
+            m[2][o] = 2.0 * e[2][o] - both;
+            m[3][o] = 2.0 * e[3][o] - both;
+        }
+        return m;
+    }
+
+    uint32_t num_qubits_;
+    std::vector<uint32_t> cuts_;            // c_0 = 0, ..., c_K = N-1
+    std::vector<LocalCircuit> circuits_;    // distinct fragment circuits
+    std::vector<size_t> variant_circuit_;   // per (fragment, prep, basis)
+    std::vector<size_t> variant_offset_;    // first variant of each fragment
+    std::vector<Columns> results_;          // per distinct circuit
+    std::vector<Matrix> identity_;          // fragment matrices of the empty observable
+};
+
+}  // namespace qkx
+
+#endif  // QKX_CIRCUIT_CUTTING_HPP
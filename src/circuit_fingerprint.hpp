@@ -0,0 +1,179 @@
+/*
+ * Structural 128-bit fingerprints of circuits
+ *
+ * Two circuits get the same fingerprint when they have the same width and
+ * the same instructions (kind, qubits, clbits and parameter bits) in the
+ * same order on every wire. The order of instructions on disjoint wires
+ * does not matter, nor does the qubit order of the symmetric CZ and swap,
+ * so circuits built in a different but trivially equivalent order, as a
+ * QASM file and a generator typically are, hash alike. Deeper identities
+ * (gate cancellation, commuting diagonal gates on a shared qubit) are
+ * deliberately not applied.
+ *
+ * The fingerprint is a Merkle hash over the circuit DAG: each wire carries
+ * the hash of its last instruction, an instruction hashes its kind and
+ * parameters with the hashes of the wires it reads, and the result folds
+ * the final wire hashes in wire order. That is O(1) per qubit argument and
+ * stable across runs and platforms, so it can key caches on disk.
+ */
+
+#ifndef QKX_CIRCUIT_FINGERPRINT_HPP
+#define QKX_CIRCUIT_FINGERPRINT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "local_circuit.hpp"
+
+namespace qkx {
+
+struct Fingerprint {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    bool operator==(const Fingerprint& o) const { return hi == o.hi && lo == o.lo; }
+    bool operator!=(const Fingerprint& o) const { return !(*this == o); }
+    bool operator<(const Fingerprint& o) const { return hi != o.hi ? hi < o.hi : lo < o.lo; }
+
+    // 32 lower-case hex digits
+    std::string hex() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(32, '0');
+        for (int i = 0; i < 16; i++) {
+            out[15 - i] = digits[(hi >> (4 * i)) & 0xF];
+            out[31 - i] = digits[(lo >> (4 * i)) & 0xF];
+        }
+        return out;
+    }
+};
+
+struct FingerprintHash {
+    size_t operator()(const Fingerprint& f) const { return static_cast<size_t>(f.lo ^ (f.hi >> 1)); }
+};
+
+namespace detail {
+
+inline uint64_t fingerprint_mix(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xD6E8FEB86659FD93ULL;
+    x ^= x >> 32;
+    x *= 0xD6E8FEB86659FD93ULL;
+    x ^= x >> 32;
+    return x;
+}
+
+// Feeds one word into both lanes; the lanes use independent multipliers
+// and the high lane also takes the low one, so they do not collide together
+inline void fingerprint_absorb(Fingerprint& h, uint64_t v) {
+    h.lo = fingerprint_mix(h.lo ^ (v * 0x9E3779B97F4A7C15ULL));
+    h.hi = fingerprint_mix(h.hi + (v * 0xC2B2AE3D27D4EB4FULL) + h.lo);
+}
+
+inline Fingerprint fingerprint_seed(uint64_t domain, uint64_t index) {
+    Fingerprint h{0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL};
+    fingerprint_absorb(h, domain);
+    fingerprint_absorb(h, index);
+    return h;
+}
+
+inline uint64_t angle_bits(double angle) {
+    if (angle == 0.0) {
+        angle = 0.0;  // -0.0 and 0.0 are the same rotation
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &angle, sizeof(bits));
+    return bits;
+}
+
+}  // namespace detail
+
+// Fingerprint of a circuit built one operation at a time
+class CircuitFingerprinter {
+public:
+    CircuitFingerprinter(uint32_t num_qubits, uint32_t num_clbits) : qubits_(num_qubits), clbits_(num_clbits) {
+        for (uint32_t q = 0; q < num_qubits; q++) {
+            qubits_[q] = detail::fingerprint_seed('q', q);
+        }
+        for (uint32_t c = 0; c < num_clbits; c++) {
+            clbits_[c] = detail::fingerprint_seed('c', c);
+        }
+    }
+
+    void add(const Operation& op) {
+        uint32_t args[2] = {op.qubits[0], op.qubits[1]};
+        if ((op.kind == GateKind::CZ || op.kind == GateKind::Swap) && args[0] > args[1]) {
+            std::swap(args[0], args[1]);
+        }
+        Fingerprint h = detail::fingerprint_seed('o', static_cast<uint64_t>(op.kind));
+        uint32_t num_params = gate_num_params(op.kind);
+        for (uint32_t p = 0; p < num_params; p++) {
+            detail::fingerprint_absorb(h, detail::angle_bits(op.params[p]));
+        }
+
+        if (op.kind == GateKind::Barrier && op.num_qubits == 0) {
+            // Barrier across the whole circuit
+            for (const Fingerprint& wire : qubits_) {
+                absorb_wire(h, wire);
+            }
+            for (uint32_t q = 0; q < qubits_.size(); q++) {
+                qubits_[q] = leave(h, 'q', q);
+            }
+            return;
+        }
+        detail::fingerprint_absorb(h, op.num_qubits);
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            absorb_wire(h, qubits_.at(args[i]));
+        }
+        if (op.kind == GateKind::Measure) {
+            absorb_wire(h, clbits_.at(op.clbit));
+            clbits_[op.clbit] = leave(h, 'c', op.clbit);
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            qubits_[args[i]] = leave(h, 'q', args[i]);
+        }
+    }
+
+    Fingerprint result() const {
+        Fingerprint h = detail::fingerprint_seed('C', qubits_.size());
+        detail::fingerprint_absorb(h, clbits_.size());
+        for (const Fingerprint& wire : qubits_) {
+            absorb_wire(h, wire);
+        }
+        for (const Fingerprint& wire : clbits_) {
+            absorb_wire(h, wire);
+        }
+        return h;
+    }
+
+private:
+    static void absorb_wire(Fingerprint& h, const Fingerprint& wire) {
+        detail::fingerprint_absorb(h, wire.lo);
+        detail::fingerprint_absorb(h, wire.hi);
+    }
+
+    // Wire state after an instruction; distinct per wire, so the outputs of
+    // a two-qubit gate stay distinguishable
+    static Fingerprint leave(Fingerprint h, uint64_t domain, uint64_t index) {
+        detail::fingerprint_absorb(h, domain);
+        detail::fingerprint_absorb(h, index);
+        return h;
+    }
+
+    std::vector<Fingerprint> qubits_;
+    std::vector<Fingerprint> clbits_;
+};
+
+inline Fingerprint fingerprint(const LocalCircuit& circ) {
+    CircuitFingerprinter fp(circ.num_qubits(), circ.num_clbits());
+    for (const Operation& op : circ.ops()) {
+        fp.add(op);
+    }
+    return fp.result();
+}
+
+}  // namespace qkx
+
+#endif  // QKX_CIRCUIT_FINGERPRINT_HPP
@@ -0,0 +1,462 @@
+/*
+ * Binary circuit library with a zero-copy reader
+ *
+ * A library is one file holding any number of named circuits (logical or
+ * transpiled, converted with from_quantum_circuit()), written once and
+ * mapped by every runner that needs them. Opening a library reads only its
+ * trailer; circuits are looked up by position or by name (binary search over
+ * a sorted name index) and viewed in place, so loading costs microseconds
+ * however large the library is.
+ *
+ * File layout (little-endian; records and the footer are 64-byte aligned):
+ *
+ *   LibraryHeader
+ *   record 0:  RecordHeader | name | metadata (JSON text) | ops | params
+ *   record 1:  ...
+ *   footer:    FooterHeader | record offsets (u64) | record numbers sorted
+ *              by name (u32)
+ *   LibraryTrailer
+ *
+ * An operation takes 16 bytes: kind, qubit count, two qubits, and either
+ * the clbit (measure) or the index of its first parameter in the record's
+ * parameter array. The writer assembles the file under a temporary name and
+ * renames it on close, so readers never see a partial library.
+ *
+ * The reader trusts nothing in the file: a record's header is checked
+ * against the mapping when it is viewed, and each operation's kind, arity
+ * and parameter index when it is read, so a corrupt library throws
+ * std::runtime_error instead of reading out of bounds.
+ */
+
+#ifndef QKX_CIRCUIT_LIBRARY_HPP
+#define QKX_CIRCUIT_LIBRARY_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "local_circuit.hpp"
+
+namespace qkx {
+
+namespace library_format {
+
+constexpr uint64_t kLibraryMagic = 0x3142494c584b51ULL;  // "QKXLIB1"
+constexpr uint32_t kRecordMagic = 0x43434b51;            // "QKCC"
+constexpr uint32_t kFooterMagic = 0x49434b51;            // "QKCI"
+constexpr uint64_t kTrailerMagic = 0x444e454c584b51ULL;  // "QKXLEND"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kAlign = 64;
+
+inline size_t align_up(size_t n) {
+    return (n + kAlign - 1) & ~(kAlign - 1);
+}
+
+struct LibraryHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint8_t padding[48];
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t num_qubits;
+    uint32_t num_clbits;
+    uint32_t name_len;
+    uint32_t metadata_len;
+    uint32_t reserved;
+    uint64_t record_size;  // whole record including padding
+    uint64_t num_ops;
+    uint64_t num_params;
+    uint64_t ops_offset;   // from start of record, 8-byte aligned
+};
+
+struct PackedOp {
+    uint8_t kind;
+    uint8_t num_qubits;
+    uint16_t reserved;
+    uint32_t qubits[2];
+    uint32_t extra;  // Measure: clbit; parametric gates: first parameter
+};
+
+struct FooterHeader {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t num_records;
+};
+
+struct LibraryTrailer {
+    uint64_t footer_offset;
+    uint64_t magic;
+};
+
+static_assert(sizeof(LibraryHeader) == kAlign, "library header must fill one block");
+static_assert(sizeof(PackedOp) == 16, "operations are 16 bytes");
+
+}  // namespace library_format
+
+class CircuitLibraryWriter {
+public:
+    explicit CircuitLibraryWriter(const std::string& path) : path_(path), tmp_path_(path + ".tmp") {
+        fd_ = ::open(tmp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot create " + tmp_path_);
+        }
+        library_format::LibraryHeader header{};
+        header.magic = library_format::kLibraryMagic;
+        header.version = library_format::kVersion;
+        write_all(&header, sizeof(header));
+        offset_ = sizeof(header);
+    }
+
+    CircuitLibraryWriter(const CircuitLibraryWriter&) = delete;
+    CircuitLibraryWriter& operator=(const CircuitLibraryWriter&) = delete;
+
+    ~CircuitLibraryWriter() {
+        if (fd_ >= 0) {
+            // Not closed: drop the partial library
+            ::close(fd_);
+            ::unlink(tmp_path_.c_str());
+        }
+    }
+
+    // Append `circ` under `name`, which must be unique in the library
+    void add(const LocalCircuit& circ, const std::string& name, const std::string& metadata = "") {
+        using namespace library_format;
+        if (fd_ < 0) {
+            throw std::logic_error("circuit library writer is closed");
+        }
+        uint64_t num_params = 0;
+        for (const Operation& op : circ.ops()) {
+            num_params += gate_num_params(op.kind);
+        }
+        size_t ops_offset = (sizeof(RecordHeader) + name.size() + metadata.size() + 7) & ~size_t(7);
+        size_t params_offset = ops_offset + circ.size() * sizeof(PackedOp);
+        size_t record_size = align_up(params_offset + num_params * sizeof(double));
+
+        buffer_.assign(record_size, 0);
+        RecordHeader header{};
+        header.magic = kRecordMagic;
+        header.num_qubits = circ.num_qubits();
+        header.num_clbits = circ.num_clbits();
+        header.name_len = static_cast<uint32_t>(name.size());
+        header.metadata_len = static_cast<uint32_t>(metadata.size());
+        header.record_size = record_size;
+        header.num_ops = circ.size();
+        header.num_params = num_params;
+        header.ops_offset = ops_offset;
+        std::memcpy(buffer_.data(), &header, sizeof(header));
+        std::memcpy(buffer_.data() + sizeof(header), name.data(), name.size());
+        std::memcpy(buffer_.data() + sizeof(header) + name.size(), metadata.data(), metadata.size());
+
+        auto* ops = reinterpret_cast<PackedOp*>(buffer_.data() + ops_offset);
+        auto* params = reinterpret_cast<double*>(buffer_.data() + params_offset);
+        uint32_t next_param = 0;
+        for (const Operation& op : circ.ops()) {
+            PackedOp& packed = *ops++;
+            packed.kind = static_cast<uint8_t>(op.kind);
+            packed.num_qubits = static_cast<uint8_t>(op.num_qubits);
+            packed.qubits[0] = op.num_qubits > 0 ? op.qubits[0] : 0;
+            packed.qubits[1] = op.num_qubits > 1 ? op.qubits[1] : 0;
+            if (op.kind == GateKind::Measure) {
+                packed.extra = op.clbit;
+            } else {
+                packed.extra = next_param;
+                for (uint32_t p = 0; p < gate_num_params(op.kind); p++) {
+                    params[next_param++] = op.params[p];
+                }
+            }
+        }
+
+        write_all(buffer_.data(), buffer_.size());
+        offsets_.push_back(offset_);
+        names_.push_back(name);
+        offset_ += record_size;
+    }
+
+    size_t size() const { return offsets_.size(); }
+
+    // Write the index and move the library into place
+    void close() {
+        using namespace library_format;
+        if (fd_ < 0) {
+            return;
+        }
+        const uint64_t n = offsets_.size();
+        std::vector<uint32_t> sorted(n);
+        for (uint32_t i = 0; i < n; i++) {
+            sorted[i] = i;
+        }
+        std::sort(sorted.begin(), sorted.end(), [this](uint32_t a, uint32_t b) { return names_[a] < names_[b]; });
+        for (size_t i = 1; i < n; i++) {
+            if (names_[sorted[i]] == names_[sorted[i - 1]]) {
+                throw std::invalid_argument("duplicate circuit name in library: " + names_[sorted[i]]);
+            }
+        }
+
+        FooterHeader footer{};
+        footer.magic = kFooterMagic;
+        footer.num_records = n;
+        buffer_.clear();
+        auto put = [this](const void* data, size_t size) {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            buffer_.insert(buffer_.end(), p, p + size);
+        };
+        put(&footer, sizeof(footer));
+        put(offsets_.data(), n * sizeof(uint64_t));
+        put(sorted.data(), n * sizeof(uint32_t));
+        buffer_.resize(align_up(buffer_.size()), 0);
+        LibraryTrailer trailer{offset_, kTrailerMagic};
+        put(&trailer, sizeof(trailer));
+        write_all(buffer_.data(), buffer_.size());
+
+        ::fsync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+        if (std::rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot rename to " + path_);
+        }
+    }
+
+private:
+    void write_all(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd_, p, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "write to " + tmp_path_);
+            }
+            p += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    std::string path_;
+    std::string tmp_path_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    std::vector<uint8_t> buffer_;
+    std::vector<uint64_t> offsets_;
+    std::vector<std::string> names_;
+};
+
+// Zero-copy view of one stored circuit; valid while its library is open.
+// Obtained from CircuitLibrary, which has checked the record header.
+class CircuitView {
+public:
+    explicit CircuitView(const uint8_t* record)
+        : header_(reinterpret_cast<const library_format::RecordHeader*>(record)), record_(record) {}
+
+    // Whether the `available` bytes at `record` hold a well-formed record
+    static bool valid_record(const uint8_t* record, uint64_t available) {
+        using namespace library_format;
+        if (available < sizeof(RecordHeader)) {
+            return false;
+        }
+        const auto* header = reinterpret_cast<const RecordHeader*>(record);
+        if (header->magic != kRecordMagic || header->record_size < sizeof(RecordHeader) ||
+            header->record_size > available) {
+            return false;
+        }
+        const uint64_t size = header->record_size;
+        const uint64_t text_end = sizeof(RecordHeader) + uint64_t(header->name_len) + header->metadata_len;
+        if (header->ops_offset % 8 != 0 || header->ops_offset < text_end || header->ops_offset > size) {
+            return false;
+        }
+        const uint64_t rest = size - header->ops_offset;
+        if (header->num_ops > rest / sizeof(PackedOp)) {
+            return false;
+        }
+        return header->num_params <= (rest - header->num_ops * sizeof(PackedOp)) / sizeof(double);
+    }
+
+    std::string_view name() const {
+        return {reinterpret_cast<const char*>(record_ + sizeof(*header_)), header_->name_len};
+    }
+    std::string_view metadata() const {
+        return {reinterpret_cast<const char*>(record_ + sizeof(*header_) + header_->name_len),
+                header_->metadata_len};
+    }
+    uint32_t num_qubits() const { return header_->num_qubits; }
+    uint32_t num_clbits() const { return header_->num_clbits; }
+    size_t size() const { return header_->num_ops; }
+
+    Operation op(size_t i) const {
+        if (i >= size()) {
+            throw std::out_of_range("operation " + std::to_string(i) + " out of range");
+        }
+        const library_format::PackedOp& packed = ops()[i];
+        if (packed.kind > static_cast<uint8_t>(GateKind::Barrier)) {
+            throw std::runtime_error("corrupt circuit library: unknown gate kind " + std::to_string(packed.kind));
+        }
+        Operation op{};
+        op.kind = static_cast<GateKind>(packed.kind);
+        op.num_qubits = packed.num_qubits;
+        const bool arity_ok = is_two_qubit(op.kind)            ? op.num_qubits == 2
+                              : op.kind == GateKind::Barrier ? op.num_qubits <= 2
+                                                              : op.num_qubits == 1;
+        if (!arity_ok) {
+            throw std::runtime_error(std::string("corrupt circuit library: ") + gate_name(op.kind) + " on " +
+                                     std::to_string(op.num_qubits) + " qubits");
+        }
+        op.qubits[0] = packed.qubits[0];
+        op.qubits[1] = packed.qubits[1];
+        if (op.kind == GateKind::Measure) {
+            op.clbit = packed.extra;
+        } else {
+            if (uint64_t(packed.extra) + gate_num_params(op.kind) > header_->num_params) {
+                throw std::runtime_error("corrupt circuit library: parameter index out of range");
+            }
+            const double* params = this->params() + packed.extra;
+            for (uint32_t p = 0; p < gate_num_params(op.kind); p++) {
+                op.params[p] = params[p];
+            }
+        }
+        return op;
+    }
+
+    // The circuit as a LocalCircuit for the engines and the bridge; qubit
+    // and clbit indices are range-checked by LocalCircuit::append
+    LocalCircuit to_circuit() const {
+        LocalCircuit circ(num_qubits(), num_clbits());
+        circ.ops().reserve(size());
+        for (size_t i = 0; i < size(); i++) {
+            circ.append(op(i));
+        }
+        return circ;
+    }
+
+private:
+    const library_format::PackedOp* ops() const {
+        return reinterpret_cast<const library_format::PackedOp*>(record_ + header_->ops_offset);
+    }
+    const double* params() const {
+        return reinterpret_cast<const double*>(record_ + header_->ops_offset +
+                                               header_->num_ops * sizeof(library_format::PackedOp));
+    }
+
+    const library_format::RecordHeader* header_;
+    const uint8_t* record_;
+};
+
+class CircuitLibrary {
+public:
+    explicit CircuitLibrary(const std::string& path) : path_(path) {
+        using namespace library_format;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::system_error(errno, std::generic_category(), "cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ < sizeof(LibraryHeader) + sizeof(FooterHeader) + sizeof(LibraryTrailer)) {
+            ::close(fd);
+            throw std::runtime_error("not a circuit library: " + path);
+        }
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "cannot mmap " + path);
+        }
+        data_ = static_cast<const uint8_t*>(addr);
+
+        const auto* header = reinterpret_cast<const LibraryHeader*>(data_);
+        const auto* trailer = reinterpret_cast<const LibraryTrailer*>(data_ + size_ - sizeof(LibraryTrailer));
+        const FooterHeader* footer = nullptr;
+        if (header->magic == kLibraryMagic && header->version == kVersion && trailer->magic == kTrailerMagic &&
+            trailer->footer_offset <= size_ - sizeof(LibraryTrailer) - sizeof(FooterHeader)) {
+            footer = reinterpret_cast<const FooterHeader*>(data_ + trailer->footer_offset);
+        }
+        if (!footer || footer->magic != kFooterMagic || trailer->footer_offset < sizeof(LibraryHeader) ||
+            footer->num_records > (size_ - trailer->footer_offset - sizeof(FooterHeader)) / 12) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+            throw std::runtime_error("not a circuit library (or truncated): " + path);
+        }
+        records_end_ = trailer->footer_offset;
+        num_records_ = footer->num_records;
+        offsets_ = reinterpret_cast<const uint64_t*>(footer + 1);
+        sorted_ = reinterpret_cast<const uint32_t*>(offsets_ + num_records_);
+    }
+
+    CircuitLibrary(const CircuitLibrary&) = delete;
+    CircuitLibrary& operator=(const CircuitLibrary&) = delete;
+
+    ~CircuitLibrary() {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+
+    const std::string& path() const { return path_; }
+    size_t size() const { return num_records_; }
+
+    CircuitView operator[](size_t i) const {
+        if (i >= num_records_) {
+            throw std::out_of_range("no circuit " + std::to_string(i) + " in " + path_);
+        }
+        const uint64_t offset = offsets_[i];
+        if (offset < sizeof(library_format::LibraryHeader) || offset >= records_end_ ||
+            offset % library_format::kAlign != 0 ||
+            !CircuitView::valid_record(data_ + offset, records_end_ - offset)) {
+            throw std::runtime_error("corrupt circuit library: record " + std::to_string(i) + " in " + path_);
+        }
+        return CircuitView(data_ + offset);
+    }
+
+    // Position of the circuit called `name`, or -1
+    int64_t find(std::string_view name) const {
+        size_t lo = 0, hi = num_records_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            std::string_view probe = (*this)[sorted_[mid]].name();
+            if (probe == name) {
+                return sorted_[mid];
+            }
+            if (probe < name) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return -1;
+    }
+
+    CircuitView at(std::string_view name) const {
+        int64_t i = find(name);
+        if (i < 0) {
+            throw std::out_of_range("no circuit '" + std::string(name) + "' in " + path_);
+        }
+        return (*this)[static_cast<size_t>(i)];
+    }
+
+private:
+    std::string path_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    uint64_t records_end_ = 0;  // footer offset
+    uint64_t num_records_ = 0;
+    const uint64_t* offsets_ = nullptr;
+    const uint32_t* sorted_ = nullptr;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_CIRCUIT_LIBRARY_HPP
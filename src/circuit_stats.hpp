@@ -0,0 +1,169 @@
+/*
+ * Circuit statistics maintained while a circuit is built
+ *
+ * Layout and shot-budget decisions need the depth, the two-qubit gate count
+ * and how busy each qubit is. CircuitStats updates all of them per appended
+ * instruction in time proportional to its number of wires (at most three:
+ * two qubits, or a qubit and a clbit), so on a million-gate circuit they
+ * cost nothing to query instead of a pass over the instructions.
+ *
+ * Depth follows Qiskit's circuit.depth(): every instruction but a barrier
+ * counts one layer on the qubits and clbits it touches, and a barrier lines
+ * its wires up without adding a layer. A barrier over the whole circuit
+ * costs O(num_qubits).
+ *
+ * TrackedCircuit forwards gate calls to a QuantumCircuit or LocalCircuit
+ * and feeds the same calls to its CircuitStats.
+ */
+
+#ifndef QKX_CIRCUIT_STATS_HPP
+#define QKX_CIRCUIT_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "local_circuit.hpp"
+
+namespace qkx {
+
+class CircuitStats {
+public:
+    CircuitStats() = default;
+    CircuitStats(uint32_t num_qubits, uint32_t num_clbits)
+        : qubit_layer_(num_qubits, 0), clbit_layer_(num_clbits, 0), qubit_ops_(num_qubits, 0) {}
+
+    void add(const Operation& op) {
+        if (op.kind == GateKind::Barrier) {
+            barrier(op);
+            return;
+        }
+        uint32_t layer = 0;
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            layer = std::max(layer, qubit_layer_.at(op.qubits[i]));
+        }
+        if (op.kind == GateKind::Measure) {
+            layer = std::max(layer, clbit_layer_.at(op.clbit));
+            clbit_layer_[op.clbit] = layer + 1;
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            qubit_layer_[op.qubits[i]] = layer + 1;
+            qubit_ops_[op.qubits[i]]++;
+        }
+        depth_ = std::max(depth_, layer + 1);
+        kind_ops_[static_cast<size_t>(op.kind)]++;
+        size_++;
+        two_qubit_ += op.num_qubits == 2;
+    }
+
+    void add(GateKind kind, uint32_t q) {
+        Operation op{};
+        op.kind = kind;
+        op.num_qubits = 1;
+        op.qubits[0] = q;
+        add(op);
+    }
+
+    void add(GateKind kind, uint32_t a, uint32_t b) {
+        Operation op{};
+        op.kind = kind;
+        op.num_qubits = 2;
+        op.qubits[0] = a;
+        op.qubits[1] = b;
+        add(op);
+    }
+
+    void add_measure(uint32_t q, uint32_t c) {
+        Operation op{};
+        op.kind = GateKind::Measure;
+        op.num_qubits = 1;
+        op.qubits[0] = q;
+        op.clbit = c;
+        add(op);
+    }
+
+    uint32_t num_qubits() const { return static_cast<uint32_t>(qubit_layer_.size()); }
+    uint32_t depth() const { return depth_; }
+    // Instructions other than barriers
+    uint64_t size() const { return size_; }
+    uint64_t two_qubit_count() const { return two_qubit_; }
+    uint64_t count(GateKind kind) const { return kind_ops_[static_cast<size_t>(kind)]; }
+    // Instructions (gates, measurements and resets) on each qubit
+    const std::vector<uint64_t>& qubit_counts() const { return qubit_ops_; }
+    uint64_t qubit_count(uint32_t q) const { return qubit_ops_.at(q); }
+    // Layers on the qubit so far: its depth if the circuit ended here
+    uint32_t qubit_depth(uint32_t q) const { return qubit_layer_.at(q); }
+
+private:
+    void barrier(const Operation& op) {
+        uint32_t layer = 0;
+        if (op.num_qubits == 0) {
+            for (uint32_t l : qubit_layer_) {
+                layer = std::max(layer, l);
+            }
+            std::fill(qubit_layer_.begin(), qubit_layer_.end(), layer);
+            return;
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            layer = std::max(layer, qubit_layer_.at(op.qubits[i]));
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            qubit_layer_[op.qubits[i]] = layer;
+        }
+    }
+
+    std::vector<uint32_t> qubit_layer_;
+    std::vector<uint32_t> clbit_layer_;
+    std::vector<uint64_t> qubit_ops_;
+    std::array<uint64_t, static_cast<size_t>(GateKind::Barrier) + 1> kind_ops_{};
+    uint32_t depth_ = 0;
+    uint64_t size_ = 0;
+    uint64_t two_qubit_ = 0;
+};
+
+// Statistics of a circuit that was not built through a TrackedCircuit
+inline CircuitStats circuit_stats(const LocalCircuit& circ) {
+    CircuitStats stats(circ.num_qubits(), circ.num_clbits());
+    for (const Operation& op : circ.ops()) {
+        stats.add(op);
+    }
+    return stats;
+}
+
+// Gate calls forwarded to `circ` (a QuantumCircuit or a LocalCircuit) and
+// recorded in stats()
+template <typename Circuit>
+class TrackedCircuit {
+public:
+    TrackedCircuit(Circuit& circ, uint32_t num_qubits, uint32_t num_clbits)
+        : circ_(circ), stats_(num_qubits, num_clbits) {}
+
+    Circuit& circuit() { return circ_; }
+    const CircuitStats& stats() const { return stats_; }
+
+    void h(uint32_t q) { circ_.h(q); stats_.add(GateKind::H, q); }
+    void x(uint32_t q) { circ_.x(q); stats_.add(GateKind::X, q); }
+    void y(uint32_t q) { circ_.y(q); stats_.add(GateKind::Y, q); }
+    void z(uint32_t q) { circ_.z(q); stats_.add(GateKind::Z, q); }
+    void s(uint32_t q) { circ_.s(q); stats_.add(GateKind::S, q); }
+    void sdg(uint32_t q) { circ_.sdg(q); stats_.add(GateKind::Sdg, q); }
+    void sx(uint32_t q) { circ_.sx(q); stats_.add(GateKind::SX, q); }
+    void rx(double theta, uint32_t q) { circ_.rx(theta, q); stats_.add(GateKind::RX, q); }
+    void ry(double theta, uint32_t q) { circ_.ry(theta, q); stats_.add(GateKind::RY, q); }
+    void rz(double theta, uint32_t q) { circ_.rz(theta, q); stats_.add(GateKind::RZ, q); }
+    void cx(uint32_t c, uint32_t t) { circ_.cx(c, t); stats_.add(GateKind::CX, c, t); }
+    void cz(uint32_t a, uint32_t b) { circ_.cz(a, b); stats_.add(GateKind::CZ, a, b); }
+    void ecr(uint32_t a, uint32_t b) { circ_.ecr(a, b); stats_.add(GateKind::ECR, a, b); }
+    void swap(uint32_t a, uint32_t b) { circ_.swap(a, b); stats_.add(GateKind::Swap, a, b); }
+    void reset(uint32_t q) { circ_.reset(q); stats_.add(GateKind::Reset, q); }
+    void measure(uint32_t q, uint32_t c) { circ_.measure(q, c); stats_.add_measure(q, c); }
+
+private:
+    Circuit& circ_;
+    CircuitStats stats_;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_CIRCUIT_STATS_HPP
@@ -0,0 +1,198 @@
+/*
+ * Parameterized circuits, transpiled once and bound many times
+ *
+ * A CircuitTemplate is a LocalCircuit in which some RZ angles are slots
+ * scale·θ[k] + offset over free parameters θ. RX and RY slots are written
+ * as an RZ between Clifford gates, so every parameter ends up in a virtual
+ * Z rotation, which IBM backends run natively and the transpiler leaves
+ * alone once it is isolated.
+ *
+ * A sweep transpiles the template once: tagged() gives a copy in which each
+ * slot's RZ carries a unique tag angle and is fenced by barriers on its
+ * qubit, so the transpiler may route it to another physical qubit but not
+ * merge it with neighbouring gates. from_transpiled() finds the tags in the
+ * transpiled circuit and returns the template on physical qubits, and
+ * bind() fills in any number of parameter points by patching those angles.
+ * Fencing costs a few single-qubit gates the transpiler could otherwise
+ * have merged; the transpiler runs once instead of once per point.
+ */
+
+#ifndef QKX_CIRCUIT_TEMPLATE_HPP
+#define QKX_CIRCUIT_TEMPLATE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+
+namespace qkx {
+
+struct TemplateSlot {
+    size_t op;       // index of the RZ in the template circuit
+    uint32_t param;
+    double scale;
+    double offset;
+};
+
+class CircuitTemplate {
+public:
+    CircuitTemplate() = default;
+    CircuitTemplate(uint32_t num_qubits, uint32_t num_clbits, uint32_t num_params)
+        : circuit_(num_qubits, num_clbits), num_params_(num_params) {}
+
+    // Fixed gates are appended here directly
+    LocalCircuit& circuit() { return circuit_; }
+    const LocalCircuit& circuit() const { return circuit_; }
+    uint32_t num_params() const { return num_params_; }
+    const std::vector<TemplateSlot>& slots() const { return slots_; }
+
+    void rz(uint32_t param, uint32_t q, double scale = 1.0, double offset = 0.0) {
+        if (param >= num_params_) {
+            throw std::out_of_range("parameter index out of range");
+        }
+        circuit_.rz(offset, q);
+        slots_.push_back({circuit_.size() - 1, param, scale, offset});
+    }
+
+    // RX(θ) = H·RZ(θ)·H
+    void rx(uint32_t param, uint32_t q, double scale = 1.0, double offset = 0.0) {
+        circuit_.h(q);
+        rz(param, q, scale, offset);
+        circuit_.h(q);
+    }
+
+    // RY(θ) = S·RX(θ)·S†
+    void ry(uint32_t param, uint32_t q, double scale = 1.0, double offset = 0.0) {
+        circuit_.sdg(q);
+        rx(param, q, scale, offset);
+        circuit_.s(q);
+    }
+
+    // Tag angle of slot i out of n: distinct, inside (0, 2π) and not a
+    // multiple of π/4 that basis translation could produce
+    static double tag(size_t i, size_t n) {
+        return 0.25 + 5.75 * (static_cast<double>(i) + 0.5) / static_cast<double>(n) + 1e-7;
+    }
+
+    // The circuit to hand to the transpiler
+    LocalCircuit tagged() const {
+        LocalCircuit out(circuit_.num_qubits(), circuit_.num_clbits());
+        out.ops().reserve(circuit_.size() + 2 * slots_.size());
+        size_t next = 0;
+        for (size_t i = 0; i < circuit_.size(); i++) {
+            const Operation& op = circuit_.ops()[i];
+            if (next < slots_.size() && slots_[next].op == i) {
+                out.append(GateKind::Barrier, {op.qubits[0]});
+                out.rz(tag(next, slots_.size()), op.qubits[0]);
+                out.append(GateKind::Barrier, {op.qubits[0]});
+                next++;
+            } else {
+                out.append(op);
+            }
+        }
+        return out;
+    }
+
+    // The template on the transpiled circuit made from tagged(). Throws if
+    // a tag was rewritten or dropped by the transpiler.
+    static CircuitTemplate from_transpiled(const LocalCircuit& transpiled, const CircuitTemplate& logical) {
+        const size_t n = logical.slots_.size();
+        std::unordered_map<uint64_t, size_t> by_tag;
+        for (size_t i = 0; i < n; i++) {
+            by_tag.emplace(angle_bits(tag(i, n)), i);
+        }
+
+        CircuitTemplate out;
+        out.circuit_ = transpiled;
+        out.num_params_ = logical.num_params_;
+        out.slots_.resize(n, TemplateSlot{SIZE_MAX, 0, 0.0, 0.0});
+        const std::vector<Operation>& ops = out.circuit_.ops();
+        for (size_t i = 0; i < ops.size(); i++) {
+            if (ops[i].kind != GateKind::RZ) {
+                continue;
+            }
+            auto it = by_tag.find(angle_bits(ops[i].params[0]));
+            if (it == by_tag.end()) {
+                continue;
+            }
+            TemplateSlot& slot = out.slots_[it->second];
+            if (slot.op != SIZE_MAX) {
+                throw std::runtime_error("parameter slot duplicated by the transpiler");
+            }
+            slot = logical.slots_[it->second];
+            slot.op = i;
+        }
+        for (const TemplateSlot& slot : out.slots_) {
+            if (slot.op == SIZE_MAX) {
+                throw std::runtime_error("parameter slot lost in transpilation");
+            }
+        }
+        // bind() walks the slots in circuit order
+        std::sort(out.slots_.begin(), out.slots_.end(),
+                  [](const TemplateSlot& a, const TemplateSlot& b) { return a.op < b.op; });
+        return out;
+    }
+
+    LocalCircuit bind(const double* point) const {
+        LocalCircuit out = circuit_;
+        std::vector<Operation>& ops = out.ops();
+        for (const TemplateSlot& slot : slots_) {
+            ops[slot.op].params[0] = slot.scale * point[slot.param] + slot.offset;
+        }
+        return out;
+    }
+
+    // One circuit per parameter point; `values` holds the points one after
+    // another, num_params() values each. The angles for all points are
+    // computed slot by slot in one pass before the circuits are copied and
+    // patched in parallel.
+    std::vector<LocalCircuit> bind(const std::vector<double>& values, unsigned num_threads = 0) const {
+        if (num_params_ == 0 ? !values.empty() : values.size() % num_params_ != 0) {
+            throw std::invalid_argument("parameter values are not a whole number of points");
+        }
+        const size_t num_points = num_params_ ? values.size() / num_params_ : 0;
+        const size_t num_slots = slots_.size();
+        std::vector<double> angles(num_slots * num_points);
+        for (size_t s = 0; s < num_slots; s++) {
+            const TemplateSlot& slot = slots_[s];
+            const double* theta = values.data() + slot.param;
+            double* column = angles.data() + s * num_points;
+            for (size_t p = 0; p < num_points; p++) {
+                column[p] = slot.scale * theta[p * num_params_] + slot.offset;
+            }
+        }
+
+        std::vector<LocalCircuit> out(num_points);
+        parallel_for(num_points, default_num_threads(num_threads), 16, [&](size_t begin, size_t end, unsigned) {
+            for (size_t p = begin; p < end; p++) {
+                out[p] = circuit_;
+                std::vector<Operation>& ops = out[p].ops();
+                for (size_t s = 0; s < num_slots; s++) {
+                    ops[slots_[s].op].params[0] = angles[s * num_points + p];
+                }
+            }
+        });
+        return out;
+    }
+
+private:
+    static uint64_t angle_bits(double angle) {
+        uint64_t bits;
+        std::memcpy(&bits, &angle, sizeof(bits));
+        return bits;
+    }
+
+    LocalCircuit circuit_;
+    uint32_t num_params_ = 0;
+    std::vector<TemplateSlot> slots_;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_CIRCUIT_TEMPLATE_HPP
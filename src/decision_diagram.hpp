@@ -0,0 +1,597 @@
+/*
+ * Decision-diagram (QMDD) simulator
+ *
+ * Represents the state as a vector decision diagram: one level per qubit,
+ * from qubit n-1 at the root down to qubit 0, each node splitting on its
+ * qubit's value, with complex weights on the edges. Identical sub-vectors
+ * up to a factor share one node, so structured states stay small: the
+ * 127-qubit GHZ state has two nodes per level. Gates are matrix decision
+ * diagrams with four edges per node and are applied by DD multiplication.
+ *
+ * Nodes are normalized (the largest child weight is pulled up to the
+ * incoming edge) and hash-consed in a unique table per node kind, with
+ * weights snapped to a 2^-40 grid so that equal sub-vectors computed along
+ * different paths meet. Multiplication and addition results are memoized in
+ * direct-mapped compute tables. Nodes reachable from the state or the gate
+ * being applied are reference-counted; between gates, once the number of
+ * live nodes passes a threshold, unreferenced nodes are returned to a free
+ * list and the compute tables are cleared.
+ *
+ * Shots are drawn by walking from the root once per shot, choosing each
+ * branch with the probability given by its weight and the squared norm of
+ * its subtree, so sampling costs O(n) per shot however many amplitudes are
+ * nonzero. Only terminal measurements are supported.
+ */
+
+#ifndef QKX_DECISION_DIAGRAM_HPP
+#define QKX_DECISION_DIAGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+
+namespace qkx {
+
+struct DecisionDiagramOptions {
+    size_t gc_threshold = size_t(1) << 18;  // live nodes before collecting
+    uint32_t compute_table_bits = 16;       // entries per compute table, log2
+    unsigned num_threads = 0;               // 0 = hardware concurrency
+    uint64_t seed = 0xdd;
+};
+
+struct DecisionDiagramStats {
+    size_t num_gates = 0;
+    size_t state_nodes = 0;   // nodes of the final state
+    size_t peak_nodes = 0;    // live vector + matrix nodes, at most
+    size_t num_collections = 0;
+    size_t memory_bytes = 0;  // node storage, unique and compute tables, at peak
+    double compute_hit_rate = 0.0;
+};
+
+namespace detail {
+
+struct DdEdge {
+    uint32_t node;  // 0 is the terminal
+    cplx w;
+};
+
+inline bool dd_is_zero(const DdEdge& e) {
+    return e.w == 0.0;
+}
+
+// Weights on a 2^-40 grid; anything smaller is zero
+inline double dd_snap(double x) {
+    double s = std::nearbyint(x * 0x1p40) * 0x1p-40;
+    return s == 0.0 ? 0.0 : s;
+}
+
+inline cplx dd_snap(cplx w) {
+    return cplx(dd_snap(w.real()), dd_snap(w.imag()));
+}
+
+inline uint64_t dd_bits(double x) {
+    uint64_t b;
+    std::memcpy(&b, &x, sizeof(b));
+    return b;
+}
+
+inline uint64_t dd_mix(uint64_t h, uint64_t x) {
+    h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+// Nodes with N outgoing edges (2: vector, 4: matrix), their unique table
+// and free list
+template <int N>
+class DdNodeTable {
+public:
+    static constexpr uint32_t kDead = UINT32_MAX;
+
+    struct Node {
+        uint32_t var;
+        uint32_t ref;
+        DdEdge e[N];
+    };
+
+    DdNodeTable() {
+        Node terminal{};
+        terminal.var = kDead - 1;
+        terminal.ref = 1;
+        nodes_.push_back(terminal);
+    }
+
+    const Node& operator[](uint32_t id) const { return nodes_[id]; }
+    size_t live() const { return live_; }
+
+    size_t memory_bytes() const {
+        return nodes_.capacity() * sizeof(Node) + free_.capacity() * sizeof(uint32_t) +
+               unique_.bucket_count() * sizeof(void*) + unique_.size() * (sizeof(Key) + 2 * sizeof(void*) + 8);
+    }
+
+    // Normalized, shared node for (var, e); the returned edge carries the
+    // factor pulled out of the children
+    DdEdge make(uint32_t var, const DdEdge (&e)[N]) {
+        int k = -1;
+        double best = 0.0;
+        for (int i = 0; i < N; i++) {
+            double mag = std::norm(e[i].w);
+            if (mag > best * (1.0 + 1e-12)) {
+                best = mag;
+                k = i;
+            }
+        }
+        if (k < 0) {
+            return DdEdge{0, 0.0};
+        }
+        const cplx norm = e[k].w;
+        Key key;
+        key.var = var;
+        for (int i = 0; i < N; i++) {
+            cplx w = i == k ? cplx(1.0) : dd_snap(e[i].w / norm);
+            key.e[i] = w == 0.0 ? DdEdge{0, 0.0} : DdEdge{e[i].node, w};
+        }
+        auto it = unique_.find(key);
+        if (it != unique_.end()) {
+            return DdEdge{it->second, norm};
+        }
+
+        uint32_t id;
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+        } else {
+            id = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[id].var = var;
+        nodes_[id].ref = 0;
+        std::copy(key.e, key.e + N, nodes_[id].e);
+        unique_.emplace(key, id);
+        live_++;
+        return DdEdge{id, norm};
+    }
+
+    void inc_ref(uint32_t id) {
+        if (id != 0 && nodes_[id].ref++ == 0) {
+            for (const DdEdge& c : nodes_[id].e) {
+                inc_ref(c.node);
+            }
+        }
+    }
+
+    void dec_ref(uint32_t id) {
+        if (id != 0 && --nodes_[id].ref == 0) {
+            for (const DdEdge& c : nodes_[id].e) {
+                dec_ref(c.node);
+            }
+        }
+    }
+
+    // Free every unreferenced node
+    size_t collect() {
+        size_t freed = 0;
+        for (uint32_t id = 1; id < nodes_.size(); id++) {
+            Node& n = nodes_[id];
+            if (n.var == kDead || n.ref != 0) {
+                continue;
+            }
+            Key key;
+            key.var = n.var;
+            std::copy(n.e, n.e + N, key.e);
+            unique_.erase(key);
+            n.var = kDead;
+            free_.push_back(id);
+            freed++;
+        }
+        live_ -= freed;
+        return freed;
+    }
+
+private:
+    struct Key {
+        uint32_t var;
+        DdEdge e[N];
+
+        bool operator==(const Key& o) const {
+            if (var != o.var) {
+                return false;
+            }
+            for (int i = 0; i < N; i++) {
+                if (e[i].node != o.e[i].node || e[i].w != o.e[i].w) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            uint64_t h = k.var;
+            for (int i = 0; i < N; i++) {
+                h = dd_mix(h, k.e[i].node);
+                h = dd_mix(h, dd_bits(k.e[i].w.real()));
+                h = dd_mix(h, dd_bits(k.e[i].w.imag()));
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    std::unordered_map<Key, uint32_t, KeyHash> unique_;
+    size_t live_ = 0;
+};
+
+// Lossy memo of (a, b, c) -> edge, one entry per slot
+class DdComputeTable {
+public:
+    explicit DdComputeTable(uint32_t bits) : mask_((size_t(1) << bits) - 1), slots_(mask_ + 1) {}
+
+    bool find(uint32_t a, uint32_t b, cplx c, DdEdge& out) {
+        lookups_++;
+        const Slot& s = slots_[index(a, b, c)];
+        if (s.valid && s.a == a && s.b == b && s.c == c) {
+            hits_++;
+            out = s.result;
+            return true;
+        }
+        return false;
+    }
+
+    void insert(uint32_t a, uint32_t b, cplx c, const DdEdge& result) {
+        Slot& s = slots_[index(a, b, c)];
+        s.valid = true;
+        s.a = a;
+        s.b = b;
+        s.c = c;
+        s.result = result;
+    }
+
+    void clear() {
+        for (Slot& s : slots_) {
+            s.valid = false;
+        }
+    }
+
+    size_t memory_bytes() const { return slots_.size() * sizeof(Slot); }
+    size_t lookups() const { return lookups_; }
+    size_t hits() const { return hits_; }
+
+private:
+    struct Slot {
+        bool valid = false;
+        uint32_t a = 0, b = 0;
+        cplx c;
+        DdEdge result{0, 0.0};
+    };
+
+    size_t index(uint32_t a, uint32_t b, cplx c) const {
+        uint64_t h = dd_mix(dd_mix(dd_mix(a, b), dd_bits(c.real())), dd_bits(c.imag()));
+        return static_cast<size_t>(h * 0x9e3779b97f4a7c15ULL >> 20) & mask_;
+    }
+
+    size_t mask_;
+    std::vector<Slot> slots_;
+    size_t lookups_ = 0, hits_ = 0;
+};
+
+}  // namespace detail
+
+class DecisionDiagramSimulator {
+public:
+    explicit DecisionDiagramSimulator(uint32_t num_qubits,
+                                      DecisionDiagramOptions options = DecisionDiagramOptions())
+        : num_qubits_(num_qubits), options_(options), multiply_table_(options.compute_table_bits),
+          add_table_(options.compute_table_bits) {
+        if (num_qubits == 0) {
+            throw std::invalid_argument("decision diagram needs at least one qubit");
+        }
+        options_.num_threads = default_num_threads(options_.num_threads);
+        gc_threshold_ = options_.gc_threshold;
+
+        // |0...0>: every level takes the 0 branch
+        detail::DdEdge e{0, 1.0};
+        for (uint32_t q = 0; q < num_qubits; q++) {
+            detail::DdEdge children[2] = {e, {0, 0.0}};
+            e = vectors_.make(q, children);
+        }
+        state_ = e;
+        vectors_.inc_ref(state_.node);
+        update_peak();
+    }
+
+    const DecisionDiagramStats& stats() const { return stats_; }
+
+    void run(const LocalCircuit& circ) {
+        if (circ.num_qubits() != num_qubits_) {
+            throw std::invalid_argument("circuit width does not match simulator");
+        }
+        for (const Operation& op : circ.ops()) {
+            if (op.kind == GateKind::Reset) {
+                throw std::invalid_argument("decision-diagram engine does not support reset");
+            }
+            if (!is_unitary(op.kind) || op.kind == GateKind::I) {
+                continue;
+            }
+            apply(op);
+        }
+        stats_.state_nodes = count_nodes(state_.node);
+        size_t lookups = multiply_table_.lookups() + add_table_.lookups();
+        stats_.compute_hit_rate =
+            lookups ? static_cast<double>(multiply_table_.hits() + add_table_.hits()) / lookups : 0.0;
+    }
+
+    void apply(const Operation& op) {
+        detail::DdEdge gate = gate_dd(op);
+        matrices_.inc_ref(gate.node);
+        detail::DdEdge next = multiply(gate, state_);
+        vectors_.inc_ref(next.node);
+        vectors_.dec_ref(state_.node);
+        matrices_.dec_ref(gate.node);
+        state_ = next;
+        stats_.num_gates++;
+        update_peak();
+
+        if (vectors_.live() + matrices_.live() > gc_threshold_) {
+            vectors_.collect();
+            matrices_.collect();
+            multiply_table_.clear();
+            add_table_.clear();
+            stats_.num_collections++;
+            // Most nodes still live: collect less often
+            if (vectors_.live() + matrices_.live() > gc_threshold_ / 2) {
+                gc_threshold_ *= 2;
+            }
+        }
+    }
+
+    // Amplitude of basis state `index` (bit q = qubit q), for n <= 64
+    cplx amplitude(uint64_t index) const {
+        detail::DdEdge e = state_;
+        cplx w = e.w;
+        for (uint32_t q = num_qubits_; q-- > 0 && w != 0.0;) {
+            e = vectors_[e.node].e[(index >> q) & 1];
+            w *= e.w;
+        }
+        return w;
+    }
+
+    // Shots of the measured qubits of `circ`, each written into its clbit
+    PackedShots sample(const LocalCircuit& circ, size_t shots) const {
+        auto measured = terminal_measurements(circ);
+        std::vector<int64_t> clbit(num_qubits_, -1);
+        for (const auto& m : measured) {
+            clbit[m.first] = m.second;
+        }
+
+        // Branch probabilities of every node of the state, renumbered
+        // densely so the walk does not hash
+        std::unordered_map<uint32_t, double> norm2;
+        norm2[0] = 1.0;
+        subtree_norm(state_.node, norm2);
+        std::unordered_map<uint32_t, uint32_t> dense;
+        for (const auto& entry : norm2) {
+            dense.emplace(entry.first, static_cast<uint32_t>(dense.size()));
+        }
+        struct Branch {
+            uint32_t child[2];
+            double p1;  // probability of the 1 branch
+        };
+        std::vector<Branch> branch(dense.size());
+        for (const auto& entry : norm2) {
+            if (entry.first == 0) {
+                continue;
+            }
+            const auto& n = vectors_[entry.first];
+            double w0 = std::norm(n.e[0].w) * norm2[n.e[0].node];
+            double w1 = std::norm(n.e[1].w) * norm2[n.e[1].node];
+            branch[dense[entry.first]] = Branch{{dense[n.e[0].node], dense[n.e[1].node]}, w1 / (w0 + w1)};
+        }
+        const uint32_t root = dense[state_.node];
+
+        PackedShots out(circ.num_clbits(), shots);
+        Xoshiro256 base(options_.seed);
+        parallel_for(shots, options_.num_threads, 4096, [&](size_t begin, size_t end, unsigned t) {
+            Xoshiro256 rng = base.stream(t);
+            for (size_t s = begin; s < end; s++) {
+                uint64_t* row = out.shot(s);
+                uint32_t node = root;
+                for (uint32_t q = num_qubits_; q-- > 0;) {
+                    const Branch& b = branch[node];
+                    int bit = rng.uniform() < b.p1 ? 1 : 0;
+                    if (bit && clbit[q] >= 0) {
+                        row[clbit[q] >> 6] |= 1ULL << (clbit[q] & 63);
+                    }
+                    node = b.child[bit];
+                }
+            }
+        });
+        return out;
+    }
+
+private:
+    using VectorTable = detail::DdNodeTable<2>;
+    using MatrixTable = detail::DdNodeTable<4>;
+
+    // Gate as a matrix DD over all n levels; edge 2r + c of a node is the
+    // (row r, column c) block for its qubit
+    detail::DdEdge gate_dd(const Operation& op) {
+        const detail::DdEdge zero{0, 0.0};
+        auto identity = [&](uint32_t var, const detail::DdEdge& below) {
+            detail::DdEdge e[4] = {below, zero, zero, below};
+            return matrices_.make(var, e);
+        };
+
+        detail::DdEdge e{0, 1.0};
+        if (op.num_qubits == 1) {
+            Matrix2 u = unitary_1q(op);
+            for (uint32_t q = 0; q < num_qubits_; q++) {
+                if (q == op.qubits[0]) {
+                    detail::DdEdge c[4];
+                    for (int i = 0; i < 4; i++) {
+                        c[i] = detail::DdEdge{e.node, u[i] * e.w};
+                    }
+                    e = matrices_.make(q, c);
+                } else {
+                    e = identity(q, e);
+                }
+            }
+            return e;
+        }
+
+        // Two qubits: below the upper qubit, one partial DD per (row,
+        // column) bit of the upper qubit, joined at its level
+        Matrix4 u = unitary_2q(op);
+        const uint32_t lo = std::min(op.qubits[0], op.qubits[1]);
+        const uint32_t hi = std::max(op.qubits[0], op.qubits[1]);
+        const bool lo_first = op.qubits[0] == lo;
+        auto index = [&](uint32_t b_lo, uint32_t b_hi) { return lo_first ? b_lo + 2 * b_hi : b_hi + 2 * b_lo; };
+
+        for (uint32_t q = 0; q < lo; q++) {
+            e = identity(q, e);
+        }
+        detail::DdEdge part[4];
+        for (uint32_t rh = 0; rh < 2; rh++) {
+            for (uint32_t ch = 0; ch < 2; ch++) {
+                detail::DdEdge c[4];
+                for (uint32_t rl = 0; rl < 2; rl++) {
+                    for (uint32_t cl = 0; cl < 2; cl++) {
+                        c[2 * rl + cl] = detail::DdEdge{e.node, u[index(rl, rh) * 4 + index(cl, ch)] * e.w};
+                    }
+                }
+                detail::DdEdge p = matrices_.make(lo, c);
+                for (uint32_t q = lo + 1; q < hi; q++) {
+                    p = dd_is_zero(p) ? p : scaled(identity(q, detail::DdEdge{p.node, 1.0}), p.w);
+                }
+                part[2 * rh + ch] = p;
+            }
+        }
+        e = matrices_.make(hi, part);
+        for (uint32_t q = hi + 1; q < num_qubits_; q++) {
+            e = identity(q, e);
+        }
+        return e;
+    }
+
+    static detail::DdEdge scaled(const detail::DdEdge& e, cplx w) {
+        return detail::DdEdge{e.node, e.w * w};
+    }
+
+    // Matrix edge times vector edge, both rooted at the same level
+    detail::DdEdge multiply(const detail::DdEdge& m, const detail::DdEdge& v) {
+        if (dd_is_zero(m) || dd_is_zero(v)) {
+            return detail::DdEdge{0, 0.0};
+        }
+        const cplx w = m.w * v.w;
+        if (m.node == 0) {
+            return detail::DdEdge{0, w};
+        }
+        detail::DdEdge r;
+        if (!multiply_table_.find(m.node, v.node, 0.0, r)) {
+            const MatrixTable::Node mn = matrices_[m.node];
+            const VectorTable::Node vn = vectors_[v.node];
+            detail::DdEdge c[2];
+            for (int i = 0; i < 2; i++) {
+                c[i] = add(multiply(mn.e[2 * i], vn.e[0]), multiply(mn.e[2 * i + 1], vn.e[1]));
+            }
+            r = vectors_.make(vn.var, c);
+            multiply_table_.insert(m.node, v.node, 0.0, r);
+        }
+        return scaled(r, w);
+    }
+
+    detail::DdEdge add(const detail::DdEdge& a, const detail::DdEdge& b) {
+        if (dd_is_zero(a)) {
+            return b;
+        }
+        if (dd_is_zero(b)) {
+            return a;
+        }
+        if (a.node == b.node) {
+            cplx w = a.w + b.w;
+            return std::norm(w) < 0x1p-80 ? detail::DdEdge{0, 0.0} : detail::DdEdge{a.node, w};
+        }
+        // a + b = a.w (A + (b.w / a.w) B)
+        const cplx ratio = detail::dd_snap(b.w / a.w);
+        detail::DdEdge r;
+        if (!add_table_.find(a.node, b.node, ratio, r)) {
+            const VectorTable::Node an = vectors_[a.node];
+            const VectorTable::Node bn = vectors_[b.node];
+            detail::DdEdge c[2];
+            for (int i = 0; i < 2; i++) {
+                c[i] = add(an.e[i], scaled(bn.e[i], ratio));
+            }
+            r = vectors_.make(an.var, c);
+            add_table_.insert(a.node, b.node, ratio, r);
+        }
+        return scaled(r, a.w);
+    }
+
+    double subtree_norm(uint32_t node, std::unordered_map<uint32_t, double>& memo) const {
+        auto it = memo.find(node);
+        if (it != memo.end()) {
+            return it->second;
+        }
+        const auto& n = vectors_[node];
+        double s = 0.0;
+        for (const detail::DdEdge& c : n.e) {
+            if (!dd_is_zero(c)) {
+                s += std::norm(c.w) * subtree_norm(c.node, memo);
+            }
+        }
+        memo[node] = s;
+        return s;
+    }
+
+    size_t count_nodes(uint32_t root) const {
+        std::unordered_map<uint32_t, double> seen;
+        seen[0] = 1.0;
+        subtree_norm(root, seen);
+        return seen.size() - 1;
+    }
+
+    void update_peak() {
+        size_t live = vectors_.live() + matrices_.live();
+        if (live > stats_.peak_nodes) {
+            stats_.peak_nodes = live;
+            stats_.memory_bytes = vectors_.memory_bytes() + matrices_.memory_bytes() +
+                                  multiply_table_.memory_bytes() + add_table_.memory_bytes();
+        }
+    }
+
+    uint32_t num_qubits_;
+    DecisionDiagramOptions options_;
+    VectorTable vectors_;
+    MatrixTable matrices_;
+    detail::DdComputeTable multiply_table_;
+    detail::DdComputeTable add_table_;
+    detail::DdEdge state_{0, 0.0};
+    size_t gc_threshold_ = 0;
+    DecisionDiagramStats stats_;
+};
+
+inline PackedShots run_decision_diagram(const LocalCircuit& circ, size_t shots,
+                                        DecisionDiagramOptions options = DecisionDiagramOptions(),
+                                        DecisionDiagramStats* stats = nullptr) {
+    DecisionDiagramSimulator sim(circ.num_qubits(), options);
+    sim.run(circ);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return sim.sample(circ, shots);
+}
+
+}  // namespace qkx
+
+#endif  // QKX_DECISION_DIAGRAM_HPP
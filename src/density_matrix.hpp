@@ -0,0 +1,405 @@
+/*
+ * Density-matrix noisy simulator
+ *
+ * Evolves the full 2^n x 2^n density matrix, so outcome probabilities are
+ * exact rather than estimated from shots; 4^n amplitudes limit it to about
+ * 12 qubits. Every gate becomes one superoperator: the gate itself, then
+ * thermal relaxation of its qubits over the gate duration (T1/T2), then a
+ * depolarizing channel sized so that the total average infidelity equals
+ * the reported gate error. Readout assignment errors are applied to the
+ * exact outcome distribution at the end.
+ *
+ * The matrix is stored with row and column bits interleaved (bit 2q is the
+ * row bit of qubit q, bit 2q+1 its column bit), so a channel on qubit q is
+ * a dense 2-bit "gate" on adjacent bits 2q, 2q+1 and reuses the statevector
+ * kernel. Channels on low qubits stay inside aligned blocks of the matrix;
+ * consecutive such channels are applied block by block, each block staying
+ * in cache while the whole run of channels passes over it.
+ *
+ * Only terminal measurements are supported.
+ */
+
+#ifndef QKX_DENSITY_MATRIX_HPP
+#define QKX_DENSITY_MATRIX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "alias_sampler.hpp"
+#include "bitstring.hpp"
+#include "gate_fusion.hpp"
+#include "local_circuit.hpp"
+#include "noise_model.hpp"
+#include "parallel.hpp"
+#include "statevector.hpp"
+
+namespace qkx {
+
+struct DensityMatrixOptions {
+    uint32_t max_qubits = 12;
+    uint32_t block_bits = 14;  // 256 KiB blocks of the matrix
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+    uint64_t seed = 0xd3a5;
+};
+
+struct DensityMatrixStats {
+    size_t num_channels = 0;  // one per gate
+    size_t num_passes = 0;    // sweeps over the whole matrix
+    double purity = 1.0;    // Tr(rho^2) of the final state
+};
+
+namespace detail {
+
+// Spread the bits of x to the even bit positions
+inline size_t spread_bits(size_t x) {
+    size_t out = 0;
+    for (int b = 0; x >> b; b++) {
+        out |= ((x >> b) & 1) << (2 * b);
+    }
+    return out;
+}
+
+// Superoperator of rho -> U rho U^dagger on k qubits, interleaved indices
+inline std::vector<cplx> unitary_superop(const std::vector<cplx>& u, uint32_t k) {
+    const size_t d = size_t(1) << k;
+    const size_t D = d * d;
+    std::vector<cplx> s(D * D, 0.0);
+    for (size_t r = 0; r < d; r++) {
+        for (size_t c = 0; c < d; c++) {
+            size_t out = spread_bits(r) | (spread_bits(c) << 1);
+            for (size_t a = 0; a < d; a++) {
+                if (u[r * d + a] == 0.0) {
+                    continue;
+                }
+                for (size_t b = 0; b < d; b++) {
+                    size_t in = spread_bits(a) | (spread_bits(b) << 1);
+                    s[out * D + in] = u[r * d + a] * std::conj(u[c * d + b]);
+                }
+            }
+        }
+    }
+    return s;
+}
+
+// Amplitude damping with phase damping on one qubit for `t` seconds
+inline std::vector<cplx> relaxation_superop(const QubitCoherence& q, double t) {
+    std::vector<cplx> s(16, 0.0);
+    double t1 = q.t1, t2 = std::min(q.t2, 2.0 * q.t1);
+    double reset = std::isinf(t1) ? 0.0 : 1.0 - std::exp(-t / t1);
+    double dephase = std::isinf(t2) ? 1.0 : std::exp(-t / t2);
+    // index r + 2c
+    s[0 * 4 + 0] = 1.0;
+    s[0 * 4 + 3] = reset;
+    s[3 * 4 + 3] = 1.0 - reset;
+    s[1 * 4 + 1] = dephase;
+    s[2 * 4 + 2] = dephase;
+    return s;
+}
+
+// rho -> (1 - lambda) rho + lambda Tr(rho) I / d on k qubits
+inline std::vector<cplx> depolarizing_superop(double lambda, uint32_t k) {
+    const size_t d = size_t(1) << k;
+    const size_t D = d * d;
+    std::vector<cplx> s(D * D, 0.0);
+    for (size_t i = 0; i < D; i++) {
+        s[i * D + i] = 1.0 - lambda;
+    }
+    for (size_t r = 0; r < d; r++) {
+        size_t out = spread_bits(r) * 3;  // row and column bits equal
+        for (size_t a = 0; a < d; a++) {
+            size_t in = spread_bits(a) * 3;
+            s[out * D + in] += lambda / static_cast<double>(d);
+        }
+    }
+    return s;
+}
+
+// a (4x4, qubit in bits 0-1) tensor b (4x4, qubit in bits 2-3)
+inline std::vector<cplx> tensor_superop(const std::vector<cplx>& a, const std::vector<cplx>& b) {
+    std::vector<cplx> s(256);
+    for (size_t i = 0; i < 16; i++) {
+        for (size_t j = 0; j < 16; j++) {
+            s[i * 16 + j] = a[(i & 3) * 4 + (j & 3)] * b[(i >> 2) * 4 + (j >> 2)];
+        }
+    }
+    return s;
+}
+
+inline std::vector<cplx> multiply(const std::vector<cplx>& a, const std::vector<cplx>& b, size_t D) {
+    std::vector<cplx> c(D * D, 0.0);
+    for (size_t i = 0; i < D; i++) {
+        for (size_t k = 0; k < D; k++) {
+            if (a[i * D + k] == 0.0) {
+                continue;
+            }
+            for (size_t j = 0; j < D; j++) {
+                c[i * D + j] += a[i * D + k] * b[k * D + j];
+            }
+        }
+    }
+    return c;
+}
+
+// Average gate infidelity of a channel given by its superoperator
+inline double channel_infidelity(const std::vector<cplx>& s, uint32_t k) {
+    const double d = static_cast<double>(size_t(1) << k);
+    const size_t D = size_t(1) << (2 * k);
+    double trace = 0.0;
+    for (size_t i = 0; i < D; i++) {
+        trace += s[i * D + i].real();
+    }
+    double process_fidelity = trace / (d * d);
+    return 1.0 - (d * process_fidelity + 1.0) / (d + 1.0);
+}
+
+}  // namespace detail
+
+class DensityMatrixSimulator {
+public:
+    DensityMatrixSimulator(uint32_t num_qubits, NoiseModel noise,
+                           DensityMatrixOptions options = DensityMatrixOptions())
+        : num_qubits_(num_qubits), noise_(std::move(noise)), options_(options) {
+        if (num_qubits > options_.max_qubits) {
+            throw std::invalid_argument("density-matrix engine limited to " +
+                                        std::to_string(options_.max_qubits) + " qubits");
+        }
+        options_.num_threads = default_num_threads(options_.num_threads);
+        rho_.assign(size_t(1) << (2 * num_qubits), 0.0);
+        rho_[0] = 1.0;
+    }
+
+    const DensityMatrixStats& stats() const { return stats_; }
+
+    void run(const LocalCircuit& circ) {
+        if (circ.num_qubits() != num_qubits_) {
+            throw std::invalid_argument("circuit width does not match simulator");
+        }
+        terminal_measurements(circ);
+
+        // Channels on a subset of the neighbouring channel's qubits are
+        // folded into it, which absorbs the 1q chains around each 2q gate
+        std::vector<FusedGate> fused;
+        for (const Operation& op : circ.ops()) {
+            if (!is_unitary(op.kind) || (op.kind == GateKind::I && noise_.gate_duration(op) == 0.0)) {
+                continue;
+            }
+            FusedGate g = channel(op);
+            stats_.num_channels++;
+            if (fused.empty() || !merge(fused.back(), g)) {
+                fused.push_back(std::move(g));
+            }
+        }
+        std::vector<detail::PreparedGate> channels;
+        for (const FusedGate& g : fused) {
+            channels.push_back(detail::prepare_gate(g));
+        }
+
+        // Runs of channels confined to one block are applied block by block
+        const uint32_t total_bits = 2 * num_qubits_;
+        const uint32_t block_bits = std::min(options_.block_bits, total_bits);
+        double* amp = reinterpret_cast<double*>(rho_.data());
+        size_t i = 0;
+        while (i < channels.size()) {
+            size_t j = i;
+            while (j < channels.size() && channels[j].qubits.back() < block_bits) {
+                j++;
+            }
+            if (j > i) {
+                const size_t num_blocks = rho_.size() >> block_bits;
+                parallel_for(num_blocks, options_.num_threads, 1, [&](size_t begin, size_t end, unsigned) {
+                    for (size_t b = begin; b < end; b++) {
+                        for (size_t c = i; c < j; c++) {
+                            const size_t per_block = size_t(1) << (block_bits - channels[c].k);
+                            detail::apply_groups(amp, channels[c], b * per_block, (b + 1) * per_block);
+                        }
+                    }
+                });
+                stats_.num_passes++;
+                i = j;
+            } else {
+                const detail::PreparedGate& g = channels[i];
+                parallel_for(rho_.size() >> g.k, options_.num_threads, size_t(1) << (14 - g.k),
+                             [&](size_t begin, size_t end, unsigned) { detail::apply_groups(amp, g, begin, end); });
+                stats_.num_passes++;
+                i++;
+            }
+        }
+        stats_.purity = purity();
+    }
+
+    // P(basis state), before readout errors
+    std::vector<double> diagonal() const {
+        std::vector<double> p(size_t(1) << num_qubits_);
+        for (size_t x = 0; x < p.size(); x++) {
+            p[x] = std::max(0.0, rho_[detail::spread_bits(x) * 3].real());
+        }
+        return p;
+    }
+
+    double purity() const {
+        double sum = 0.0;
+        for (const cplx& a : rho_) {
+            sum += std::norm(a);
+        }
+        return sum;
+    }
+
+    // Exact distribution over the clbit outcomes of `circ`, including
+    // readout errors; entry y is the probability of clbit value y
+    std::vector<double> outcome_probabilities(const LocalCircuit& circ) const {
+        if (circ.num_clbits() > 24) {
+            throw std::invalid_argument("too many clbits for a dense outcome distribution");
+        }
+        auto measured = terminal_measurements(circ);
+        std::vector<double> p = diagonal();
+        std::vector<double> out(size_t(1) << circ.num_clbits(), 0.0);
+        for (size_t x = 0; x < p.size(); x++) {
+            size_t y = 0;
+            for (const auto& m : measured) {
+                y |= ((x >> m.first) & 1) << m.second;
+            }
+            out[y] += p[x];
+        }
+        for (const auto& m : measured) {
+            QubitReadoutError e = noise_.readout_error(m.first);
+            const size_t bit = size_t(1) << m.second;
+            for (size_t y = 0; y < out.size(); y++) {
+                if (y & bit) {
+                    continue;
+                }
+                double p0 = out[y], p1 = out[y | bit];
+                out[y] = (1.0 - e.p01) * p0 + e.p10 * p1;
+                out[y | bit] = e.p01 * p0 + (1.0 - e.p10) * p1;
+            }
+        }
+        return out;
+    }
+
+    PackedShots sample(const LocalCircuit& circ, size_t shots) const {
+        AliasTable table(outcome_probabilities(circ));
+        PackedShots out(circ.num_clbits(), shots);
+        SamplingOptions sampling;
+        sampling.num_threads = options_.num_threads;
+        sampling.seed = options_.seed;
+        table.sample(shots, sampling, [&out](size_t shot, uint64_t y) { out.shot(shot)[0] = y; });
+        return out;
+    }
+
+private:
+    // Gate, relaxation over its duration, then depolarizing noise, as one
+    // superoperator on the row/column bits of the gate's qubits (ascending)
+    FusedGate channel(const Operation& op) const {
+        const uint32_t k = op.num_qubits;
+        uint32_t lo = op.qubits[0], hi = k == 2 ? op.qubits[1] : op.qubits[0];
+        const bool swapped = k == 2 && lo > hi;
+        if (swapped) {
+            std::swap(lo, hi);
+        }
+
+        const size_t d = size_t(1) << k;
+        std::vector<cplx> u(d * d);
+        if (k == 1) {
+            Matrix2 m = unitary_1q(op);
+            std::copy(m.begin(), m.end(), u.begin());
+        } else {
+            Matrix4 m = unitary_2q(op);
+            for (size_t r = 0; r < 4; r++) {
+                for (size_t c = 0; c < 4; c++) {
+                    // Reorder to index b(lo) + 2 b(hi)
+                    size_t rr = swapped ? ((r & 1) << 1) | (r >> 1) : r;
+                    size_t cc = swapped ? ((c & 1) << 1) | (c >> 1) : c;
+                    u[r * 4 + c] = m[rr * 4 + cc];
+                }
+            }
+        }
+
+        const size_t D = d * d;
+        std::vector<cplx> s = detail::unitary_superop(u, k);
+        const double duration = noise_.gate_duration(op);
+        double relax_infidelity = 0.0;
+        if (duration > 0.0) {
+            std::vector<cplx> relax = detail::relaxation_superop(noise_.coherence(lo), duration);
+            if (k == 2) {
+                relax = detail::tensor_superop(relax, detail::relaxation_superop(noise_.coherence(hi), duration));
+            }
+            relax_infidelity = detail::channel_infidelity(relax, k);
+            s = detail::multiply(relax, s, D);
+        }
+        const double depolarizing = std::max(0.0, noise_.gate_error(op) - relax_infidelity);
+        if (depolarizing > 0.0) {
+            double lambda = std::min(1.0, depolarizing * static_cast<double>(d) / static_cast<double>(d - 1));
+            s = detail::multiply(detail::depolarizing_superop(lambda, k), s, D);
+        }
+
+        FusedGate g;
+        g.qubits = {2 * lo, 2 * lo + 1};
+        if (k == 2) {
+            g.qubits.push_back(2 * hi);
+            g.qubits.push_back(2 * hi + 1);
+        }
+        g.matrix = std::move(s);
+        g.num_gates = 1;
+        return g;
+    }
+
+    // prev := next * prev when one channel's qubits cover the other's
+    static bool merge(FusedGate& prev, const FusedGate& next) {
+        auto widen = [](const FusedGate& narrow, const FusedGate& wide) {
+            std::vector<cplx> id = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+            return narrow.qubits[0] == wide.qubits[0] ? detail::tensor_superop(narrow.matrix, id)
+                                                      : detail::tensor_superop(id, narrow.matrix);
+        };
+        const size_t D = size_t(1) << next.qubits.size();
+        if (next.qubits == prev.qubits) {
+            prev.matrix = detail::multiply(next.matrix, prev.matrix, D);
+        } else if (prev.qubits.size() == 4 && next.qubits.size() == 2 &&
+                   (next.qubits[0] == prev.qubits[0] || next.qubits[0] == prev.qubits[2])) {
+            prev.matrix = detail::multiply(widen(next, prev), prev.matrix, 16);
+        } else if (prev.qubits.size() == 2 && next.qubits.size() == 4 &&
+                   (prev.qubits[0] == next.qubits[0] || prev.qubits[0] == next.qubits[2])) {
+            prev.matrix = detail::multiply(next.matrix, widen(prev, next), 16);
+            prev.qubits = next.qubits;
+        } else {
+            return false;
+        }
+        prev.num_gates += next.num_gates;
+        return true;
+    }
+
+    uint32_t num_qubits_;
+    NoiseModel noise_;
+    DensityMatrixOptions options_;
+    std::vector<cplx> rho_;
+    DensityMatrixStats stats_;
+};
+
+// Exact noisy distribution over the clbit outcomes of `circ`
+inline std::vector<double> density_matrix_probabilities(const LocalCircuit& circ, const NoiseModel& noise,
+                                                        DensityMatrixOptions options = DensityMatrixOptions(),
+                                                        DensityMatrixStats* stats = nullptr) {
+    DensityMatrixSimulator sim(circ.num_qubits(), noise, options);
+    sim.run(circ);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return sim.outcome_probabilities(circ);
+}
+
+inline PackedShots run_density_matrix(const LocalCircuit& circ, size_t shots, const NoiseModel& noise,
+                                      DensityMatrixOptions options = DensityMatrixOptions(),
+                                      DensityMatrixStats* stats = nullptr) {
+    DensityMatrixSimulator sim(circ.num_qubits(), noise, options);
+    sim.run(circ);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return sim.sample(circ, shots);
+}
+
+}  // namespace qkx
+
+#endif  // QKX_DENSITY_MATRIX_HPP
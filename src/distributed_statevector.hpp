@@ -0,0 +1,519 @@
+/*
+ * Multi-process distributed statevector
+ *
+ * Splits the 2^n amplitudes across P = 2^g worker processes on one machine,
+ * so 32-36 qubit circuits use the memory bandwidth of every socket rather
+ * than that of the threads of one process. The top g bits of the physical
+ * amplitude index select the process ("global" qubits); the low n - g bits
+ * index its slice ("local" qubits). Slices live in one shared anonymous
+ * mapping, and each process only touches its own slice except during an
+ * exchange.
+ *
+ * Gates are fused as for the statevector engine and applied to local
+ * qubits only, in place, with the same kernel. Before a gate that acts on a
+ * global qubit, that qubit is swapped with a local one: every pair of
+ * processes differing in the global bit exchanges the half of their slices
+ * in which the local bit differs, directly through shared memory, and the
+ * logical-to-physical layout is updated instead of moving data back. The
+ * local qubit evicted is the one whose next use is farthest away, and the
+ * initial layout keeps the least-used qubits global, so circuits with
+ * locality exchange rarely.
+ *
+ * The schedule is planned once in the calling process; workers are
+ * fork()ed per phase, run it with a shared-memory barrier around each
+ * exchange and allocate nothing, so forking from a process that runs other
+ * threads (the runtime client) is safe with the default of one thread per
+ * worker. Shots are drawn per process by a single sorted scan of its slice.
+ */
+
+#ifndef QKX_DISTRIBUTED_STATEVECTOR_HPP
+#define QKX_DISTRIBUTED_STATEVECTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "alias_sampler.hpp"
+#include "bitstring.hpp"
+#include "gate_fusion.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include "statevector.hpp"
+
+namespace qkx {
+
+struct DistributedOptions {
+    unsigned num_processes = 4;      // power of two
+    unsigned threads_per_process = 1;
+    uint32_t max_qubits = 36;        // 1 TiB of amplitudes
+    uint64_t seed = 0xd157;
+    FusionOptions fusion;
+};
+
+struct DistributedStats {
+    unsigned num_processes = 0;
+    size_t num_passes = 0;        // fused gates applied
+    size_t num_exchanges = 0;     // global/local qubit swaps
+    double exchanged_bytes = 0.0;  // amplitude bytes moved between processes
+};
+
+namespace detail {
+
+// Anonymous MAP_SHARED memory, inherited by fork()ed workers
+class SharedMapping {
+public:
+    explicit SharedMapping(size_t bytes) : bytes_(std::max<size_t>(bytes, 1)) {
+        addr_ = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (addr_ == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "cannot map shared memory");
+        }
+    }
+    ~SharedMapping() { ::munmap(addr_, bytes_); }
+    SharedMapping(const SharedMapping&) = delete;
+    SharedMapping& operator=(const SharedMapping&) = delete;
+
+    void* data() const { return addr_; }
+
+private:
+    void* addr_;
+    size_t bytes_;
+};
+
+// Barrier across processes, placed in shared memory
+struct ProcessBarrier {
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "barrier needs lock-free atomics");
+
+    std::atomic<uint32_t> arrived{0};
+    std::atomic<uint32_t> generation{0};
+    uint32_t count = 0;
+
+    void wait() {
+        uint32_t gen = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+        } else {
+            while (generation.load(std::memory_order_acquire) == gen) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+// Run fn(rank) for ranks 1..n-1 in fork()ed children and rank 0 here. An
+// exception never unwinds a child into the caller's code: the child exits
+// with status 1 instead. If rank 0 throws, the children are killed and
+// reaped before the exception propagates.
+template <typename Fn>
+void run_ranks(unsigned num_ranks, Fn&& fn) {
+    std::vector<pid_t> children;
+    auto kill_children = [&children] {
+        for (pid_t child : children) {
+            ::kill(child, SIGKILL);
+        }
+        for (pid_t child : children) {
+            while (::waitpid(child, nullptr, 0) < 0 && errno == EINTR) {
+            }
+        }
+    };
+    for (unsigned r = 1; r < num_ranks; r++) {
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            try {
+                fn(r);
+            } catch (...) {
+                ::_exit(1);
+            }
+            ::_exit(0);
+        }
+        if (pid < 0) {
+            int err = errno;
+            kill_children();
+            throw std::system_error(err, std::generic_category(), "cannot fork statevector worker");
+        }
+        children.push_back(pid);
+    }
+    try {
+        fn(0u);
+    } catch (...) {
+        kill_children();
+        throw;
+    }
+    bool ok = true;
+    for (pid_t child : children) {
+        int status = 0;
+        while (::waitpid(child, &status, 0) < 0 && errno == EINTR) {
+        }
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    if (!ok) {
+        throw std::runtime_error("distributed statevector worker failed");
+    }
+}
+
+// `gate` with matrix bit j moved to bit position[gate.qubits[j]], and its
+// qubits sorted as the amplitude kernel expects
+inline FusedGate place_gate(const FusedGate& gate, const std::vector<uint32_t>& position) {
+    const uint32_t k = static_cast<uint32_t>(gate.qubits.size());
+    std::vector<uint32_t> order(k);
+    for (uint32_t j = 0; j < k; j++) {
+        order[j] = j;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return position[gate.qubits[a]] < position[gate.qubits[b]];
+    });
+
+    FusedGate out;
+    out.num_gates = gate.num_gates;
+    for (uint32_t t = 0; t < k; t++) {
+        out.qubits.push_back(position[gate.qubits[order[t]]]);
+    }
+    const size_t dim = size_t(1) << k;
+    auto remap = [&](size_t x) {
+        size_t y = 0;
+        for (uint32_t t = 0; t < k; t++) {
+            y |= ((x >> order[t]) & 1) << t;
+        }
+        return y;
+    };
+    out.matrix.resize(dim * dim);
+    for (size_t r = 0; r < dim; r++) {
+        for (size_t c = 0; c < dim; c++) {
+            out.matrix[remap(r) * dim + remap(c)] = gate.matrix[r * dim + c];
+        }
+    }
+    return out;
+}
+
+}  // namespace detail
+
+class DistributedStatevector {
+public:
+    explicit DistributedStatevector(uint32_t num_qubits, DistributedOptions options = DistributedOptions())
+        : num_qubits_(num_qubits), options_(options) {
+        if (num_qubits > options_.max_qubits) {
+            throw std::invalid_argument("distributed statevector limited to " +
+                                        std::to_string(options_.max_qubits) + " qubits");
+        }
+        unsigned p = options_.num_processes;
+        if (p == 0 || (p & (p - 1)) != 0) {
+            throw std::invalid_argument("number of processes must be a power of two");
+        }
+        // Keep at least 5 local qubits so fused gates and exchanges fit
+        global_bits_ = 0;
+        while ((1u << (global_bits_ + 1)) <= p && global_bits_ + 1 + 5 <= num_qubits) {
+            global_bits_++;
+        }
+        local_bits_ = num_qubits - global_bits_;
+        options_.threads_per_process = default_num_threads(options_.threads_per_process);
+        options_.fusion.max_qubits = std::min({options_.fusion.max_qubits, 5u, local_bits_});
+        options_.fusion.width = std::min({options_.fusion.width, 5u, local_bits_});
+        stats_.num_processes = 1u << global_bits_;
+
+        control_.reset(new detail::SharedMapping(kMassOffset + stats_.num_processes * sizeof(double)));
+        new (control_->data()) detail::ProcessBarrier();
+        barrier()->count = stats_.num_processes;
+        amplitudes_.reset(new detail::SharedMapping(sizeof(cplx) << num_qubits));
+        amp()[0] = 1.0;
+
+        position_.resize(num_qubits);
+        for (uint32_t q = 0; q < num_qubits; q++) {
+            position_[q] = q;
+        }
+        planned_layout_ = false;
+    }
+
+    uint32_t num_qubits() const { return num_qubits_; }
+    const DistributedStats& stats() const { return stats_; }
+
+    // Physical amplitude index bit holding logical qubit q
+    const std::vector<uint32_t>& layout() const { return position_; }
+
+    void run(const LocalCircuit& circ) {
+        if (circ.num_qubits() != num_qubits_) {
+            throw std::invalid_argument("circuit width does not match simulator");
+        }
+        for (const Operation& op : circ.ops()) {
+            if (op.kind == GateKind::Reset) {
+                throw std::invalid_argument("distributed statevector does not support reset");
+            }
+        }
+        std::vector<Step> steps = plan(fuse(circ, options_.fusion));
+
+        detail::ProcessBarrier* sync = barrier();
+        double* masses = mass();
+        cplx* state = amp();
+        const size_t slice = size_t(1) << local_bits_;
+        const unsigned threads = options_.threads_per_process;
+        detail::run_ranks(stats_.num_processes, [&](unsigned rank) {
+            cplx* mine = state + rank * slice;
+            double* raw = reinterpret_cast<double*>(mine);
+            for (const Step& s : steps) {
+                if (s.exchange) {
+                    sync->wait();
+                    exchange(state, rank, s.global_bit, s.local_bit);
+                    sync->wait();
+                } else {
+                    parallel_for(slice >> s.gate.k, threads, size_t(1) << (14 - s.gate.k),
+                                 [&](size_t begin, size_t end, unsigned) {
+                                     detail::apply_groups(raw, s.gate, begin, end);
+                                 });
+                }
+            }
+            double total = 0.0;
+            for (size_t i = 0; i < slice; i++) {
+                total += std::norm(mine[i]);
+            }
+            masses[rank] = total;
+        });
+    }
+
+    // Shots of the measured qubits of `circ`, each written into its clbit
+    PackedShots sample(const LocalCircuit& circ, size_t shots) const {
+        auto measured = terminal_measurements(circ);
+        const unsigned num_ranks = stats_.num_processes;
+        const double* masses = mass();
+
+        // Shots per process, then offsets into the shared outcome buffer
+        Xoshiro256 rng(options_.seed);
+        AliasTable ranks(std::vector<double>(masses, masses + num_ranks));
+        std::vector<size_t> begin(num_ranks + 1, 0);
+        for (size_t s = 0; s < shots; s++) {
+            begin[ranks(rng) + 1]++;
+        }
+        for (unsigned r = 0; r < num_ranks; r++) {
+            begin[r + 1] += begin[r];
+        }
+
+        // Each process writes sorted uniform positions into its range of
+        // the buffer, then overwrites them with the indices they fall on
+        detail::SharedMapping buffer(shots * sizeof(uint64_t));
+        unsigned char* slots = static_cast<unsigned char*>(buffer.data());
+        const cplx* state = amp();
+        const size_t slice = size_t(1) << local_bits_;
+        const uint32_t local_bits = local_bits_;
+        detail::run_ranks(num_ranks, [&](unsigned rank) {
+            Xoshiro256 local = rng.stream(rank);
+            unsigned char* out = slots + begin[rank] * sizeof(uint64_t);
+            const size_t count = begin[rank + 1] - begin[rank];
+            if (count == 0) {
+                return;
+            }
+            // Cumulative exponential spacings give sorted uniforms in O(count)
+            double sum = 0.0;
+            for (size_t k = 0; k < count; k++) {
+                sum -= std::log1p(-local.uniform());
+                std::memcpy(out + k * sizeof(double), &sum, sizeof(double));
+            }
+            const double scale = masses[rank] / (sum - std::log1p(-local.uniform()));
+            const cplx* mine = state + rank * slice;
+            double cumulative = 0.0;
+            size_t k = 0;
+            uint64_t last = 0;
+            for (size_t i = 0; i < slice && k < count; i++) {
+                double p = std::norm(mine[i]);
+                if (p == 0.0) {
+                    continue;
+                }
+                cumulative += p;
+                last = (uint64_t(rank) << local_bits) | i;
+                double u;
+                while (k < count && (std::memcpy(&u, out + k * sizeof(double), sizeof(double)),
+                                     u * scale < cumulative)) {
+                    std::memcpy(out + k * sizeof(uint64_t), &last, sizeof(uint64_t));
+                    k++;
+                }
+            }
+            for (; k < count; k++) {
+                std::memcpy(out + k * sizeof(uint64_t), &last, sizeof(uint64_t));
+            }
+        });
+
+        // Shuffle so shot order carries no index order, then map the
+        // physical index bits to clbits through the final layout
+        std::vector<uint64_t> index(shots);
+        std::memcpy(index.data(), slots, shots * sizeof(uint64_t));
+        for (size_t s = shots; s > 1; s--) {
+            std::swap(index[s - 1], index[rng.below(s)]);
+        }
+        PackedShots out(circ.num_clbits(), shots);
+        for (size_t s = 0; s < shots; s++) {
+            uint64_t* row = out.shot(s);
+            for (const auto& m : measured) {
+                if ((index[s] >> position_[m.first]) & 1) {
+                    row[m.second >> 6] |= 1ULL << (m.second & 63);
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    // Control mapping: the barrier, then one probability mass per process
+    static constexpr size_t kMassOffset = 64;
+    static_assert(sizeof(detail::ProcessBarrier) <= kMassOffset, "barrier overlaps masses");
+
+    struct Step {
+        bool exchange = false;
+        uint32_t global_bit = 0, local_bit = 0;
+        detail::PreparedGate gate;
+    };
+
+    detail::ProcessBarrier* barrier() const { return static_cast<detail::ProcessBarrier*>(control_->data()); }
+    double* mass() const {
+        return reinterpret_cast<double*>(static_cast<unsigned char*>(control_->data()) + kMassOffset);
+    }
+    cplx* amp() { return static_cast<cplx*>(amplitudes_->data()); }
+    const cplx* amp() const { return static_cast<const cplx*>(amplitudes_->data()); }
+
+    // Gates at physical positions, with the exchanges that make each one local
+    std::vector<Step> plan(const std::vector<FusedGate>& gates) {
+        const uint32_t n = num_qubits_;
+        std::vector<std::vector<size_t>> uses(n);
+        for (size_t i = 0; i < gates.size(); i++) {
+            for (uint32_t q : gates[i].qubits) {
+                uses[q].push_back(i);
+            }
+        }
+
+        // On the first run, the most-used qubits start local
+        if (!planned_layout_) {
+            std::vector<uint32_t> by_use(n);
+            for (uint32_t q = 0; q < n; q++) {
+                by_use[q] = q;
+            }
+            std::stable_sort(by_use.begin(), by_use.end(),
+                             [&](uint32_t a, uint32_t b) { return uses[a].size() > uses[b].size(); });
+            std::vector<uint32_t> local(by_use.begin(), by_use.begin() + local_bits_);
+            std::vector<uint32_t> global(by_use.begin() + local_bits_, by_use.end());
+            std::sort(local.begin(), local.end());
+            std::sort(global.begin(), global.end());
+            uint32_t p = 0;
+            for (uint32_t q : local) {
+                position_[q] = p++;
+            }
+            for (uint32_t q : global) {
+                position_[q] = p++;
+            }
+            planned_layout_ = true;
+        }
+        std::vector<uint32_t> logical(n);
+        for (uint32_t q = 0; q < n; q++) {
+            logical[position_[q]] = q;
+        }
+
+        std::vector<size_t> cursor(n, 0);
+        std::vector<char> in_gate(n, 0);
+        std::vector<Step> steps;
+        for (size_t i = 0; i < gates.size(); i++) {
+            const FusedGate& g = gates[i];
+            for (uint32_t q : g.qubits) {
+                in_gate[q] = 1;
+            }
+            for (uint32_t q : g.qubits) {
+                if (position_[q] < local_bits_) {
+                    continue;
+                }
+                // Evict the local qubit needed again last (Belady)
+                uint32_t victim = 0;
+                size_t farthest = 0;
+                for (uint32_t p = 0; p < local_bits_; p++) {
+                    uint32_t v = logical[p];
+                    if (in_gate[v]) {
+                        continue;
+                    }
+                    size_t next = cursor[v] < uses[v].size() ? uses[v][cursor[v]]
+                                                              : std::numeric_limits<size_t>::max();
+                    if (next > farthest) {
+                        farthest = next;
+                        victim = p;
+                    }
+                }
+                Step s;
+                s.exchange = true;
+                s.global_bit = position_[q] - local_bits_;
+                s.local_bit = victim;
+                steps.push_back(std::move(s));
+                uint32_t v = logical[victim];
+                std::swap(position_[q], position_[v]);
+                logical[position_[q]] = q;
+                logical[position_[v]] = v;
+                stats_.num_exchanges++;
+                stats_.exchanged_bytes += static_cast<double>(sizeof(cplx) << (n - 1));
+            }
+            Step s;
+            s.gate = detail::prepare_gate(detail::place_gate(g, position_));
+            steps.push_back(std::move(s));
+            stats_.num_passes++;
+            for (uint32_t q : g.qubits) {
+                in_gate[q] = 0;
+                cursor[q]++;
+            }
+        }
+        return steps;
+    }
+
+    // Swap global bit `global_bit` with local bit `local_bit`: the lower
+    // process of each pair trades its amplitudes with the local bit set for
+    // its partner's with it clear; each of the two does half the pairs
+    void exchange(cplx* state, unsigned rank, uint32_t global_bit, uint32_t local_bit) const {
+        const size_t slice = size_t(1) << local_bits_;
+        const unsigned partner = rank ^ (1u << global_bit);
+        const bool lower = rank < partner;
+        cplx* lo = state + std::min(rank, partner) * slice;
+        cplx* hi = state + std::max(rank, partner) * slice;
+        const size_t pairs = slice / 2;
+        const size_t bit = size_t(1) << local_bit;
+        const size_t first = lower ? 0 : pairs / 2;
+        const size_t last = lower ? pairs / 2 : pairs;
+        parallel_for(last - first, options_.threads_per_process, size_t(1) << 14,
+                     [&](size_t begin, size_t end, unsigned) {
+                         for (size_t t = first + begin; t < first + end; t++) {
+                             size_t i = ((t >> local_bit) << (local_bit + 1)) | (t & (bit - 1));
+                             std::swap(lo[i | bit], hi[i]);
+                         }
+                     });
+    }
+
+    uint32_t num_qubits_;
+    DistributedOptions options_;
+    uint32_t global_bits_ = 0;
+    uint32_t local_bits_ = 0;
+    std::unique_ptr<detail::SharedMapping> control_;
+    std::unique_ptr<detail::SharedMapping> amplitudes_;
+    std::vector<uint32_t> position_;
+    bool planned_layout_ = false;
+    DistributedStats stats_;
+};
+
+inline PackedShots run_distributed(const LocalCircuit& circ, size_t shots,
+                                   DistributedOptions options = DistributedOptions(),
+                                   DistributedStats* stats = nullptr) {
+    DistributedStatevector sim(circ.num_qubits(), options);
+    sim.run(circ);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return sim.sample(circ, shots);
+}
+
+}  // namespace qkx
+
+#endif  // QKX_DISTRIBUTED_STATEVECTOR_HPP
@@ -0,0 +1,258 @@
+/*
+ * Gate fusion for the statevector engine
+ *
+ * Applying a gate streams the whole statevector through memory, so a long
+ * sequence of small gates (the cx(0, i) fan-out of a GHZ circuit, or the
+ * rz/sx chains a transpiler emits) is bound by memory bandwidth. Fusion
+ * groups gates acting on a small set of qubits into one dense k-qubit
+ * unitary, trading one memory pass per gate for one pass per group and
+ * 2^k multiply-adds per amplitude.
+ *
+ * Groups are formed greedily: starting from the first unfused gate, later
+ * gates join the group while the group spans at most k qubits, and a gate
+ * may be pulled forward only past gates on disjoint qubits. The width k is
+ * picked by a cost model, per amplitude:
+ *
+ *     cost(group) = pass + mac * 2^k
+ *
+ * where `pass` is the price of one read-modify-write of an amplitude and
+ * `mac` that of one complex multiply-add. Every k up to max_qubits is
+ * tried and the cheapest grouping wins. A statevector that fits in the
+ * last-level cache makes passes cheap and favours small groups.
+ */
+
+#ifndef QKX_GATE_FUSION_HPP
+#define QKX_GATE_FUSION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "local_circuit.hpp"
+
+namespace qkx {
+
+struct FusionCostModel {
+    double pass = 1.0;     // one amplitude read and written, out of cache
+    double mac = 0.0625;   // one complex multiply-add
+    double cached_pass = 0.25;
+    size_t cache_bytes = size_t(32) << 20;
+
+    double group_cost(uint32_t num_qubits, uint32_t k) const {
+        double bytes = 16.0 * static_cast<double>(uint64_t(1) << num_qubits);
+        double p = bytes <= static_cast<double>(cache_bytes) ? cached_pass : pass;
+        return static_cast<double>(uint64_t(1) << num_qubits) * (p + mac * static_cast<double>(1u << k));
+    }
+};
+
+struct FusionOptions {
+    bool enabled = true;
+    uint32_t max_qubits = 5;   // widest group the cost model may choose
+    uint32_t width = 0;        // fixed group width; 0 = chosen by the cost model
+    size_t window = 256;       // gates scanned ahead when growing a group
+    FusionCostModel cost;
+};
+
+// Dense unitary on `qubits` (ascending); matrix bit j is qubits[j]
+struct FusedGate {
+    std::vector<uint32_t> qubits;
+    std::vector<cplx> matrix;  // 2^k x 2^k, row-major
+    size_t num_gates = 0;
+};
+
+namespace detail {
+
+// Apply `op` to every column of the 2^k x 2^k matrix m, where op's qubits
+// are given as positions within the group
+inline void apply_to_columns(std::vector<cplx>& m, uint32_t k, const Operation& op, const uint32_t* pos) {
+    const size_t dim = size_t(1) << k;
+    if (op.num_qubits == 1) {
+        Matrix2 u = unitary_1q(op);
+        const size_t bit = size_t(1) << pos[0];
+        for (size_t r = 0; r < dim; r++) {
+            if (r & bit) {
+                continue;
+            }
+            for (size_t c = 0; c < dim; c++) {
+                cplx a0 = m[r * dim + c], a1 = m[(r | bit) * dim + c];
+                m[r * dim + c] = u[0] * a0 + u[1] * a1;
+                m[(r | bit) * dim + c] = u[2] * a0 + u[3] * a1;
+            }
+        }
+    } else {
+        Matrix4 u = unitary_2q(op);
+        const size_t b0 = size_t(1) << pos[0], b1 = size_t(1) << pos[1];
+        for (size_t r = 0; r < dim; r++) {
+            if (r & (b0 | b1)) {
+                continue;
+            }
+            const size_t rows[4] = {r, r | b0, r | b1, r | b0 | b1};
+            for (size_t c = 0; c < dim; c++) {
+                cplx in[4];
+                for (int j = 0; j < 4; j++) {
+                    in[j] = m[rows[j] * dim + c];
+                }
+                for (int i = 0; i < 4; i++) {
+                    m[rows[i] * dim + c] = u[i * 4] * in[0] + u[i * 4 + 1] * in[1] +
+                                           u[i * 4 + 2] * in[2] + u[i * 4 + 3] * in[3];
+                }
+            }
+        }
+    }
+}
+
+}  // namespace detail
+
+// Group of gate indices to fused matrix
+inline FusedGate fuse_gates(const std::vector<Operation>& ops, const std::vector<size_t>& group) {
+    FusedGate g;
+    for (size_t i : group) {
+        for (uint32_t q = 0; q < ops[i].num_qubits; q++) {
+            g.qubits.push_back(ops[i].qubits[q]);
+        }
+    }
+    std::sort(g.qubits.begin(), g.qubits.end());
+    g.qubits.erase(std::unique(g.qubits.begin(), g.qubits.end()), g.qubits.end());
+
+    const uint32_t k = static_cast<uint32_t>(g.qubits.size());
+    const size_t dim = size_t(1) << k;
+    g.matrix.assign(dim * dim, 0.0);
+    for (size_t i = 0; i < dim; i++) {
+        g.matrix[i * dim + i] = 1.0;
+    }
+    for (size_t i : group) {
+        uint32_t pos[2];
+        for (uint32_t q = 0; q < ops[i].num_qubits; q++) {
+            pos[q] = static_cast<uint32_t>(
+                std::lower_bound(g.qubits.begin(), g.qubits.end(), ops[i].qubits[q]) - g.qubits.begin());
+        }
+        detail::apply_to_columns(g.matrix, k, ops[i], pos);
+    }
+    g.num_gates = group.size();
+    return g;
+}
+
+// Greedy grouping of the unitary gates of `circ` into groups of at most
+// `width` qubits (a wider single gate forms its own group)
+inline std::vector<std::vector<size_t>> fusion_groups(const LocalCircuit& circ, uint32_t width,
+                                                      size_t window = 256) {
+    const auto& ops = circ.ops();
+    std::vector<size_t> gates;
+    for (size_t i = 0; i < ops.size(); i++) {
+        if (is_unitary(ops[i].kind) && ops[i].kind != GateKind::I) {
+            gates.push_back(i);
+        }
+    }
+
+    std::vector<std::vector<size_t>> groups;
+    std::vector<char> used(gates.size(), 0);
+    std::vector<char> in_group(circ.num_qubits(), 0), blocked(circ.num_qubits(), 0);
+    for (size_t a = 0; a < gates.size(); a++) {
+        if (used[a]) {
+            continue;
+        }
+        std::vector<size_t> group;
+        std::vector<uint32_t> span;
+        auto take = [&](size_t idx) {
+            const Operation& op = ops[gates[idx]];
+            for (uint32_t q = 0; q < op.num_qubits; q++) {
+                if (!in_group[op.qubits[q]]) {
+                    in_group[op.qubits[q]] = 1;
+                    span.push_back(op.qubits[q]);
+                }
+            }
+            used[idx] = 1;
+            group.push_back(gates[idx]);
+        };
+        take(a);
+
+        std::vector<uint32_t> touched;
+        size_t num_blocked = 0;
+        for (size_t b = a + 1; b < gates.size() && b <= a + window; b++) {
+            if (used[b]) {
+                continue;
+            }
+            const Operation& op = ops[gates[b]];
+            bool free = true;
+            uint32_t extra = 0;
+            for (uint32_t q = 0; q < op.num_qubits; q++) {
+                free = free && !blocked[op.qubits[q]];
+                extra += !in_group[op.qubits[q]];
+            }
+            if (free && span.size() + extra <= width) {
+                take(b);
+                continue;
+            }
+            // Later gates on these qubits may not move past this one
+            for (uint32_t q = 0; q < op.num_qubits; q++) {
+                if (!blocked[op.qubits[q]]) {
+                    blocked[op.qubits[q]] = 1;
+                    touched.push_back(op.qubits[q]);
+                    num_blocked++;
+                }
+            }
+            if (num_blocked == circ.num_qubits()) {
+                break;
+            }
+        }
+
+        for (uint32_t q : touched) {
+            blocked[q] = 0;
+        }
+        for (uint32_t q : span) {
+            in_group[q] = 0;
+        }
+        groups.push_back(std::move(group));
+    }
+    return groups;
+}
+
+// Estimated cost of running `groups` on an n-qubit statevector
+inline double fusion_cost(const LocalCircuit& circ, const std::vector<std::vector<size_t>>& groups,
+                          const FusionCostModel& model) {
+    double total = 0.0;
+    std::vector<uint32_t> qubits;
+    for (const auto& group : groups) {
+        qubits.clear();
+        for (size_t i : group) {
+            const Operation& op = circ.ops()[i];
+            qubits.insert(qubits.end(), op.qubits, op.qubits + op.num_qubits);
+        }
+        std::sort(qubits.begin(), qubits.end());
+        uint32_t k = static_cast<uint32_t>(std::unique(qubits.begin(), qubits.end()) - qubits.begin());
+        total += model.group_cost(circ.num_qubits(), k);
+    }
+    return total;
+}
+
+// Fused gates for `circ`; with fusion disabled every gate is its own group
+inline std::vector<FusedGate> fuse(const LocalCircuit& circ, const FusionOptions& options = FusionOptions()) {
+    std::vector<std::vector<size_t>> best;
+    if (!options.enabled) {
+        best = fusion_groups(circ, 0, 0);
+    } else if (options.width > 0) {
+        best = fusion_groups(circ, options.width, options.window);
+    } else {
+        double best_cost = std::numeric_limits<double>::infinity();
+        for (uint32_t k = 1; k <= std::max(1u, options.max_qubits); k++) {
+            auto groups = fusion_groups(circ, k, options.window);
+            double cost = fusion_cost(circ, groups, options.cost);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best = std::move(groups);
+            }
+        }
+    }
+
+    std::vector<FusedGate> fused;
+    fused.reserve(best.size());
+    for (const auto& group : best) {
+        fused.push_back(fuse_gates(circ.ops(), group));
+    }
+    return fused;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_GATE_FUSION_HPP
@@ -2,25 +2,54 @@
  * Qiskit C++ Example - N-Qubit GHZ State with Runtime Sampler
  *
  * This program creates an N-qubit GHZ (Greenberger-Horne-Zeilinger) state
- * and runs it on IBM Quantum hardware using the Qiskit C++ interface.
+ * and runs it on IBM Quantum hardware using the Qiskit C++ interface, or
+ * on a local simulator when the backend is named "local:<engine>".
  *
  * GHZ state: |GHZ⟩ = (|00...0⟩ + |11...1⟩) / √2
  *
- * Usage: ghz_20q <num_qubits> <backend> [shots]
+ * Usage: ghz_20q <num_qubits> <backend> [shots] [--mitigate] [--predict]
+ *                [--store DIR] [--max-bond N] [--truncation EPS] [--qasm FILE]
+ *                [--parity-sweep K] [--dynamic] [--cut W] [--twirl M]
  */
 
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <map>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
 
 #include "circuit/quantumcircuit.hpp"
 #include "primitives/backend_sampler_v2.hpp"
 #include "service/qiskit_runtime_service.hpp"
 #include "compiler/transpiler.hpp"
 
+#include "bitstring.hpp"
+#include "bootstrap.hpp"
+#include "circuit_cutting.hpp"
+#include "circuit_stats.hpp"
+#include "ghz_dynamic.hpp"
+#include "ghz_profile.hpp"
+#include "ghz_witness.hpp"
+#include "local_backend.hpp"
+#include "pauli_twirl.hpp"
+#include "qasm_writer.hpp"
+#include "qiskit_bridge.hpp"
+#include "readout_calibration.hpp"
+#include "readout_mitigation.hpp"
+#ifndef _WIN32
+#include "result_store.hpp"
+#endif
+#include "top_k.hpp"
+
 using namespace Qiskit;
 using namespace Qiskit::circuit;
 using namespace Qiskit::providers;
@@ -31,33 +60,229 @@ using namespace Qiskit::compiler;
 using Sampler = BackendSamplerV2;
 
 void print_usage(const char* program_name) {
-    std::cerr << "Usage: " << program_name << " <num_qubits> <backend> [shots]" << std::endl;
+    std::cerr << "Usage: " << program_name << " <num_qubits> <backend> [shots] [options]" << std::endl;
     std::cerr << std::endl;
     std::cerr << "Arguments:" << std::endl;
-    std::cerr << "  num_qubits  Number of qubits in the GHZ state (2-127)" << std::endl;
-    std::cerr << "  backend     IBM Quantum backend name (e.g., ibm_fez, ibm_torino)" << std::endl;
+    std::cerr << "  num_qubits  Number of qubits in the GHZ state (2-127, any with --cut)" << std::endl;
+    std::cerr << "  backend     IBM Quantum backend name (e.g., ibm_fez, ibm_torino)," << std::endl;
+    std::cerr << "              or a local simulator (" << qkx::local_engine_names() << ")" << std::endl;
     std::cerr << "  shots       Number of shots (default: 1024)" << std::endl;
     std::cerr << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --mitigate  Apply readout-error mitigation (calibration cached per backend)" << std::endl;
+    std::cerr << "  --predict   Transpile for the backend but sample locally with its" << std::endl;
+    std::cerr << "              calibrated gate and readout errors (Clifford circuits)" << std::endl;
+    std::cerr << "  --store DIR Append shots and metadata to the result store in DIR" << std::endl;
+    std::cerr << "  --max-bond N       local:mps bond dimension limit (default: 256)" << std::endl;
+    std::cerr << "  --truncation EPS   local:mps discarded weight per SVD (default: 1e-12)" << std::endl;
+#ifndef _WIN32
+    std::cerr << "  --processes N      local:distributed worker processes (default: 4)" << std::endl;
+#endif
+    std::cerr << "  --no-analytic      Run the local engine even though GHZ has a closed form" << std::endl;
+    std::cerr << "  --qasm FILE        Write the circuit as OpenQASM 3 to FILE (- for stdout)" << std::endl;
+    std::cerr << "  --parity-sweep K   Also measure K parity-oscillation points (one transpiled" << std::endl;
+    std::cerr << "                     template, submitted with the GHZ circuit) for the fidelity" << std::endl;
+    std::cerr << "  --dynamic          Constant-depth preparation on 2N-1 qubits: ancilla parity" << std::endl;
+    std::cerr << "                     measurements, corrections applied to the results (N <= 64)" << std::endl;
+    std::cerr << "  --cut W            Cut the GHZ chain into fragments of at most W qubits, run" << std::endl;
+    std::cerr << "                     their variants as one job and reconstruct <Z Z> observables" << std::endl;
+    std::cerr << "  --twirl M          Split the shots over M Pauli-twirled instances of the" << std::endl;
+    std::cerr << "                     transpiled circuit, one job, readout flips undone" << std::endl;
+    std::cerr << std::endl;
     std::cerr << "Examples:" << std::endl;
     std::cerr << "  " << program_name << " 20 ibm_fez" << std::endl;
     std::cerr << "  " << program_name << " 50 ibm_torino 2048" << std::endl;
+    std::cerr << "  " << program_name << " 100 ibm_torino 4096 --mitigate" << std::endl;
+    std::cerr << "  " << program_name << " 127 local:mps 100000" << std::endl;
+    std::cerr << "  " << program_name << " 100 ibm_torino 1000000 --predict" << std::endl;
+    std::cerr << "  " << program_name << " 400 ibm_fez 8192 --cut 100" << std::endl;
+}
+
+// --cut: the chain H(0), CX(i,i+1) split into fragments of at most
+// cut_width qubits. Every distinct fragment circuit runs once (all in one
+// job on hardware) and <Z_i Z_j> and the parity are reconstructed from them.
+int run_cut(int num_qubits, const std::string& backend_name, int num_shots, uint32_t cut_width,
+            const qkx::LocalBackendOptions& local_options) {
+    qkx::GhzCutting cut(num_qubits, cut_width);
+    std::cout << "Cut into " << cut.num_fragments() << " fragments of at most " << cut_width
+              << " qubits: " << cut.circuits().size() << " distinct circuits" << std::endl;
+
+    std::vector<qkx::PackedShots> results;
+    try {
+        if (qkx::is_local_backend(backend_name)) {
+            for (const qkx::LocalCircuit& fragment : cut.circuits()) {
+                results.push_back(qkx::run_local(backend_name, fragment, num_shots, local_options).shots);
+            }
+            std::cout << "Simulated locally" << std::endl;
+        } else {
+            auto service = QiskitRuntimeService();
+            auto backend = service.backend(backend_name);
+            std::vector<SamplerPub> pubs;
+            for (const qkx::LocalCircuit& fragment : cut.circuits()) {
+                auto logical = qkx::to_quantum_circuit(fragment);
+                pubs.emplace_back(transpile(logical, backend));
+            }
+
+            // Every fragment variant in one job
+            auto sampler = Sampler(backend, num_shots);
+            auto job = sampler.run(pubs);
+            if (job == nullptr) {
+                std::cerr << "Error: Failed to submit job" << std::endl;
+                return -1;
+            }
+            std::cout << "Job submitted (" << pubs.size() << " PUBs). Waiting for results..." << std::endl;
+            auto result = job->result();
+            for (size_t i = 0; i < pubs.size(); i++) {
+                results.push_back(qkx::PackedShots::from_strings(
+                    result[i].data("meas").get_bitstrings(), cut.circuits()[i].num_qubits()));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Neighbour pairs, the two ends and the full parity
+    const uint32_t n = static_cast<uint32_t>(num_qubits);
+    std::vector<std::vector<uint32_t>> observables;
+    for (uint32_t q = 0; q + 1 < n; q++) {
+        observables.push_back({q, q + 1});
+    }
+    observables.push_back({0, n - 1});
+    observables.emplace_back(n);
+    std::iota(observables.back().begin(), observables.back().end(), 0u);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> values;
+    try {
+        cut.load_results(results);
+        values = cut.expectations(observables);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto worst = std::min_element(values.begin(), values.begin() + (n - 1));
+    double mean = std::accumulate(values.begin(), values.begin() + (n - 1), 0.0) / (n - 1);
+    std::cout << std::endl << "Reconstructed observables (ideal in parentheses):" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  <Z_i Z_i+1> mean: " << mean << " (1), lowest " << *worst << " at i = "
+              << (worst - values.begin()) << std::endl;
+    std::cout << "  <Z_0 Z_" << n - 1 << ">: " << values[n - 1] << " (1)" << std::endl;
+    std::cout << "  Parity <Z...Z>: " << values[n] << " (" << (n % 2 ? 0 : 1) << ")" << std::endl;
+    std::cout << "  (" << observables.size() << " observables reconstructed in " << std::setprecision(1)
+              << ms << " ms)" << std::endl;
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
+    // Separate --options from positional arguments
+    std::vector<std::string> args;
+    bool mitigate = false;
+    bool predict = false;
+    std::string store_dir;
+    std::string qasm_path;
+    uint32_t sweep_points = 0;
+    bool dynamic = false;
+    uint32_t cut_width = 0;
+    uint32_t twirl_instances = 0;
+    qkx::LocalBackendOptions local_options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mitigate") {
+            mitigate = true;
+        } else if (arg == "--predict") {
+            predict = true;
+        } else if (arg == "--store" && i + 1 < argc) {
+            store_dir = argv[++i];
+        } else if (arg == "--qasm" && i + 1 < argc) {
+            qasm_path = argv[++i];
+        } else if (arg == "--dynamic") {
+            dynamic = true;
+        } else if (arg == "--twirl" && i + 1 < argc) {
+            twirl_instances = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--cut" && i + 1 < argc) {
+            cut_width = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--parity-sweep" && i + 1 < argc) {
+            sweep_points = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--max-bond" && i + 1 < argc) {
+            local_options.mps.max_bond = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--truncation" && i + 1 < argc) {
+            local_options.mps.truncation = std::atof(argv[++i]);
+        } else if (arg == "--no-analytic") {
+            local_options.analytic = false;
+        }
+#ifndef _WIN32
+        else if (arg == "--processes" && i + 1 < argc) {
+            local_options.distributed.num_processes = static_cast<unsigned>(std::atoi(argv[++i]));
+        }
+#endif
+        else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
     // Check for required arguments
-    if (argc < 3) {
+    if (args.size() < 2) {
         print_usage(argv[0]);
         return 1;
     }
 
     // Parse command line arguments
-    int num_qubits = std::atoi(argv[1]);
-    std::string backend_name = argv[2];
-    int num_shots = (argc > 3) ? std::atoi(argv[3]) : 1024;
+    int num_qubits = std::atoi(args[0].c_str());
+    std::string backend_name = args[1];
+    int num_shots = (args.size() > 2) ? std::atoi(args[2].c_str()) : 1024;
 
     // Validate num_qubits
-    if (num_qubits < 2 || num_qubits > 127) {
-        std::cerr << "Error: num_qubits must be between 2 and 127" << std::endl;
+    if (num_qubits < 2 || (num_qubits > 127 && !cut_width)) {
+        std::cerr << "Error: num_qubits must be between 2 and 127 (or at least 2 with --cut)" << std::endl;
+        return 1;
+    }
+
+    const bool local = qkx::is_local_backend(backend_name);
+#ifdef _WIN32
+    if (!store_dir.empty()) {
+        // The result store maps its segments with mmap
+        std::cerr << "Error: --store is not available on Windows" << std::endl;
+        return 1;
+    }
+#endif
+    if ((local || predict) && mitigate) {
+        std::cerr << "Error: --mitigate needs results from hardware" << std::endl;
+        return 1;
+    }
+    if (local && predict) {
+        std::cerr << "Error: --predict needs a hardware backend to take error rates from" << std::endl;
+        return 1;
+    }
+    if (sweep_points && predict) {
+        std::cerr << "Error: --parity-sweep is not Clifford, so --predict cannot sample it" << std::endl;
+        return 1;
+    }
+    if (sweep_points && sweep_points < 3) {
+        std::cerr << "Error: --parity-sweep needs at least 3 points" << std::endl;
+        return 1;
+    }
+    if (dynamic && (num_qubits > 64 || mitigate || sweep_points)) {
+        // Readout errors on the ancillas propagate through the corrections,
+        // which the per-qubit mitigation model does not describe
+        std::cerr << "Error: --dynamic needs at most 64 qubits and no --mitigate or --parity-sweep" << std::endl;
+        return 1;
+    }
+    if (twirl_instances && (local || cut_width || num_shots < static_cast<int>(twirl_instances))) {
+        // Twirling acts on the transpiled circuit, which local runs skip
+        std::cerr << "Error: --twirl needs a hardware backend, no --cut and at least one shot per instance"
+                  << std::endl;
+        return 1;
+    }
+    if (cut_width && (cut_width < 2 || mitigate || predict || sweep_points || dynamic || !store_dir.empty())) {
+        std::cerr << "Error: --cut needs a width of at least 2 and none of --mitigate, --predict,"
+                  << " --parity-sweep, --dynamic or --store" << std::endl;
         return 1;
     }
 
@@ -67,64 +292,288 @@ int main(int argc, char* argv[]) {
     std::cout << "Shots: " << num_shots << std::endl;
     std::cout << "Qubits: " << num_qubits << std::endl << std::endl;
 
-    // Create an N-qubit circuit
-    QuantumRegister qr(num_qubits);
-    ClassicalRegister cr(num_qubits, std::string("meas"));
+    if (cut_width) {
+        return run_cut(num_qubits, backend_name, num_shots, cut_width, local_options);
+    }
+
+    // Create an N-qubit circuit (2N-1 with the ancillas of --dynamic)
+    const int width = dynamic ? static_cast<int>(qkx::dynamic_ghz_width(num_qubits)) : num_qubits;
+    QuantumRegister qr(width);
+    ClassicalRegister cr(width, std::string("meas"));
     QuantumCircuit circ(
         std::vector<QuantumRegister>({qr}),
         std::vector<ClassicalRegister>({cr})
     );
 
-    // Build GHZ state: |GHZ⟩ = (|00...0⟩ + |11...1⟩) / √2
-    // Step 1: Hadamard on qubit 0 to create superposition
-    circ.h(0);
+    // Gates go through a tracker that keeps depth and gate counts as they
+    // are appended
+    qkx::TrackedCircuit<QuantumCircuit> builder(circ, width, width);
 
-    // Step 2: CNOT cascade from qubit 0 to all others
-    for (int i = 1; i < num_qubits; i++) {
-        circ.cx(0, i);
-    }
+    if (dynamic) {
+        // Data qubits 0, 2, 4, ... joined by ancilla parity measurements
+        qkx::append_dynamic_ghz(builder, num_qubits);
+    } else {
+        // Build GHZ state: |GHZ⟩ = (|00...0⟩ + |11...1⟩) / √2
+        // Step 1: Hadamard on qubit 0 to create superposition
+        builder.h(0);
 
-    // Measure all qubits
-    circ.measure(qr, cr);
+        // Step 2: CNOT cascade from qubit 0 to all others
+        for (int i = 1; i < num_qubits; i++) {
+            builder.cx(0, i);
+        }
 
-    // Print circuit info
-    std::cout << "Circuit: H(0)";
-    for (int i = 1; i < num_qubits; i++) {
-        std::cout << ", CX(0," << i << ")";
+        // Measure all qubits
+        for (int i = 0; i < num_qubits; i++) {
+            builder.measure(i, i);
+        }
     }
-    std::cout << ", Measure" << std::endl << std::endl;
 
-    // Print the circuit in QASM3 format (only for small circuits)
-    if (num_qubits <= 10) {
+    // Print circuit info
+    const qkx::CircuitStats& stats = builder.stats();
+    const auto& per_qubit = stats.qubit_counts();
+    auto busiest = std::max_element(per_qubit.begin(), per_qubit.end());
+    std::cout << "Circuit: "
+              << (dynamic ? "H on data qubits, CX into ancillas, measure ancillas, Measure"
+                          : "H(0), CX(0,i) fan-out, Measure")
+              << std::endl;
+    std::cout << "  depth " << stats.depth() << ", " << stats.size() << " instructions ("
+              << stats.two_qubit_count() << " two-qubit), busiest qubit " << (busiest - per_qubit.begin())
+              << " with " << *busiest << std::endl << std::endl;
+
+    // Print the circuit in QASM3 format (only for small circuits unless
+    // --qasm asks for it). The streaming writer never holds the program
+    // text, so any size can be written to a file.
+    if (!qasm_path.empty()) {
+        try {
+            if (qasm_path == "-") {
+                qkx::write_qasm3(qkx::from_quantum_circuit(circ), std::cout);
+                std::cout << std::endl;
+            } else {
+                std::ofstream qasm_file(qasm_path);
+                if (!qasm_file) {
+                    throw std::runtime_error("cannot write " + qasm_path);
+                }
+                qkx::write_qasm3(qkx::from_quantum_circuit(circ), qasm_file);
+                std::cout << "Circuit written to " << qasm_path << " (QASM3)" << std::endl << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    } else if (num_qubits <= 10) {
         std::cout << "Circuit (QASM3):" << std::endl;
-        std::cout << circ.to_qasm3() << std::endl;
+        qkx::write_qasm3(qkx::from_quantum_circuit(circ), std::cout);
+        std::cout << std::endl;
     } else {
-        std::cout << "(QASM3 output suppressed for circuits > 10 qubits)" << std::endl << std::endl;
+        std::cout << "(QASM3 output suppressed for circuits > 10 qubits; use --qasm FILE)" << std::endl << std::endl;
     }
 
-    // Connect to IBM Quantum Runtime
-    auto service = QiskitRuntimeService();
-    auto backend = service.backend(backend_name);
+    // Outcomes, packed shots and the physical qubit measured into each clbit
+    std::unordered_map<std::string, uint64_t> counts;
+    qkx::PackedShots shots;
+    std::vector<uint32_t> physical_qubits;
+    qkx::ReadoutCalibration calibration;
+
+    // Parity-oscillation sweep: one template, bound at every angle
+    qkx::CircuitTemplate sweep_template;
+    std::vector<double> sweep_angles, sweep_parities;
+    if (sweep_points) {
+        sweep_template = qkx::ghz_parity_template(num_qubits);
+        sweep_angles = qkx::ghz_parity_angles(num_qubits, sweep_points);
+    }
+
+    if (local) {
+        // Simulate in-process; qubits are not mapped onto a device
+        qkx::LocalResult run;
+        try {
+            run = qkx::run_local(backend_name, qkx::from_quantum_circuit(circ), num_shots, local_options);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Simulated locally (" << run.details << ")" << std::endl;
+        shots = std::move(run.shots);
+        counts = qkx::counts_from_shots(shots);
+        physical_qubits.resize(width);
+        std::iota(physical_qubits.begin(), physical_qubits.end(), 0u);
+        if (dynamic) {
+            for (int i = 0; i < num_qubits; i++) {
+                physical_qubits[i] = 2 * i;
+            }
+        }
+
+        if (sweep_points) {
+            try {
+                for (const qkx::LocalCircuit& point : sweep_template.bind(sweep_angles)) {
+                    auto point_run = qkx::run_local(backend_name, point, num_shots, local_options);
+                    sweep_parities.push_back(qkx::parity_expectation(qkx::histogram_from_counts(
+                        qkx::counts_from_shots(point_run.shots), num_qubits)));
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+    } else {
+        // Connect to IBM Quantum Runtime
+        auto service = QiskitRuntimeService();
+        auto backend = service.backend(backend_name);
+
+        // Transpile circuit for the target backend
+        auto transpiled_circ = transpile(circ, backend);
+
+        physical_qubits = qkx::measured_qubits(transpiled_circ);
+
+        // One pass over the transpiled circuit, which was not built through the
+        // tracker. If it holds an instruction the local form lacks, only the
+        // statistics line is skipped, unless twirling or prediction need it.
+        qkx::LocalCircuit transpiled_local;
+        try {
+            transpiled_local = qkx::from_quantum_circuit(transpiled_circ);
+            qkx::CircuitStats transpiled_stats = qkx::circuit_stats(transpiled_local);
+            std::cout << "Transpiled: depth " << transpiled_stats.depth() << ", " << transpiled_stats.size()
+                      << " instructions (" << transpiled_stats.two_qubit_count() << " two-qubit)" << std::endl;
+        } catch (const std::exception& e) {
+            if (twirl_instances || predict) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+
+        // Twirled instances are generated from the transpiled circuit in
+        // parallel and share the shots equally
+        std::vector<qkx::TwirledCircuit> twirled;
+        int instance_shots = num_shots;
+        if (twirl_instances) {
+            auto start = std::chrono::steady_clock::now();
+            twirled = qkx::PauliTwirler(transpiled_local).generate(twirl_instances);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            instance_shots = num_shots / static_cast<int>(twirl_instances);
+            num_shots = instance_shots * static_cast<int>(twirl_instances);
+            std::cout << "Twirled: " << twirl_instances << " instances of " << instance_shots << " shots ("
+                      << num_shots << " total), generated in " << std::fixed << std::setprecision(1) << ms
+                      << " ms" << std::endl;
+        }
+        // Appends one instance's shots with its readout flips undone
+        auto add_instance_shots = [&](qkx::PackedShots instance, size_t index) {
+            qkx::untwirl(instance, twirled[index].flips);
+            size_t offset = shots.num_shots();
+            shots.resize(offset + instance.num_shots());
+            std::copy(instance.data(), instance.data() + instance.num_shots() * instance.words_per_shot(),
+                      shots.shot(offset));
+        };
+
+        if (predict) {
+            // Pauli-frame sampling with the backend's reported error rates;
+            // a cached readout calibration refines the symmetric target values
+            local_options.noise = qkx::noise_model_from_target(backend.target());
+            qkx::ReadoutCalibration cached;
+            if (qkx::ReadoutCalibrationCache().load(backend_name, cached) && cached.covers(physical_qubits)) {
+                for (uint32_t q : physical_qubits) {
+                    local_options.noise.set_readout_error(q, cached.qubits.at(q));
+                }
+            }
+            if (twirl_instances) {
+                shots = qkx::PackedShots(width);
+                for (size_t i = 0; i < twirled.size(); i++) {
+                    add_instance_shots(qkx::run_local("local:pauli_frame", twirled[i].circuit, instance_shots,
+                                                      local_options).shots, i);
+                }
+                std::cout << "Predicted from " << backend_name << " calibration" << std::endl;
+            } else {
+                auto run = qkx::run_local("local:pauli_frame", transpiled_local, num_shots, local_options);
+                std::cout << "Predicted from " << backend_name << " calibration (" << run.details << ")"
+                          << std::endl;
+                shots = std::move(run.shots);
+            }
+            counts = qkx::counts_from_shots(shots);
+        } else {
+            std::vector<SamplerPub> pubs;
+            if (twirl_instances) {
+                for (const qkx::TwirledCircuit& instance : twirled) {
+                    pubs.emplace_back(qkx::to_quantum_circuit(instance.circuit), instance_shots);
+                }
+            } else {
+                pubs.emplace_back(transpiled_circ);
+            }
+            const size_t first_sweep = pubs.size();
+            if (sweep_points) {
+                // Transpile the template once and bind every angle into its own PUB
+                try {
+                    auto tagged = qkx::to_quantum_circuit(sweep_template.tagged());
+                    auto transpiled_tagged = transpile(tagged, backend);
+                    auto physical_template = qkx::CircuitTemplate::from_transpiled(
+                        qkx::from_quantum_circuit(transpiled_tagged), sweep_template);
+                    for (const qkx::LocalCircuit& point : physical_template.bind(sweep_angles)) {
+                        pubs.emplace_back(qkx::to_quantum_circuit(point));
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    return 1;
+                }
+            }
+
+            // Create sampler and run the circuit (and the sweep) as one job
+            auto sampler = Sampler(backend, num_shots);
+            auto job = sampler.run(pubs);
 
-    // Transpile circuit for the target backend
-    auto transpiled_circ = transpile(circ, backend);
+            if (job == nullptr) {
+                std::cerr << "Error: Failed to submit job" << std::endl;
+                return -1;
+            }
 
-    // Create sampler and run the circuit
-    auto sampler = Sampler(backend, num_shots);
-    auto job = sampler.run({SamplerPub(transpiled_circ)});
+            std::cout << "Job submitted. Waiting for results..." << std::endl;
 
-    if (job == nullptr) {
-        std::cerr << "Error: Failed to submit job" << std::endl;
-        return -1;
+            // Get results
+            auto result = job->result();
+            if (twirl_instances) {
+                shots = qkx::PackedShots(width);
+                for (size_t i = 0; i < twirled.size(); i++) {
+                    add_instance_shots(
+                        qkx::PackedShots::from_strings(result[i].data("meas").get_bitstrings(), width), i);
+                }
+                counts = qkx::counts_from_shots(shots);
+            } else {
+                auto pub_result = result[0];
+                auto meas_bits = pub_result.data("meas");
+                counts = meas_bits.get_counts();
+                shots = qkx::PackedShots::from_strings(meas_bits.get_bitstrings(), width);
+            }
+            for (uint32_t k = 0; k < sweep_points; k++) {
+                sweep_parities.push_back(qkx::parity_expectation(qkx::histogram_from_counts(
+                    result[first_sweep + k].data("meas").get_counts(), num_qubits)));
+            }
+
+            // Readout calibration for the measured qubits (cached per backend)
+            if (mitigate) {
+                calibration = qkx::get_readout_calibration(
+                    sampler, backend_name, transpiled_circ.num_qubits(), physical_qubits);
+            }
+        }
     }
 
-    std::cout << "Job submitted. Waiting for results..." << std::endl;
+    if (dynamic) {
+        // The feed-forward X corrections, applied to the data bits
+        shots = qkx::fold_dynamic_ghz(shots, num_qubits);
+        counts = qkx::counts_from_shots(shots);
+        physical_qubits.resize(num_qubits);
+    }
 
-    // Get results
-    auto result = job->result();
-    auto pub_result = result[0];
-    auto meas_bits = pub_result.data("meas");
-    auto counts = meas_bits.get_counts();
+#ifndef _WIN32
+    // Keep the raw shots for later analysis
+    if (!store_dir.empty()) {
+        qkx::ResultMetadata meta;
+        meta.backend = backend_name;
+        meta.layout = physical_qubits;
+        meta.metadata = nlohmann::json{
+            {"circuit", dynamic ? "ghz_dynamic" : "ghz"}, {"num_qubits", num_qubits}, {"shots", num_shots}, {"predicted", predict},
+            {"twirl_instances", twirl_instances}
+        }.dump();
+        qkx::ResultStoreWriter store(store_dir);
+        store.append(meta, shots);
+        std::cout << "Shots stored in " << store.path() << std::endl;
+    }
+#endif
 
     // Print measurement results
     std::cout << std::endl << "Measurement Results:" << std::endl;
@@ -153,14 +602,18 @@ int main(int argc, char* argv[]) {
         } else {
             count_other += c.second;
         }
+    }
 
-        // Print top results (> 1%)
+    // Print top results (> 1%); at most 100 outcomes can pass the threshold,
+    // so a bounded heap avoids walking a sorted copy of every outcome
+    for (const auto& c : qkx::top_k(counts, 100)) {
         double percentage = (100.0 * c.second) / num_shots;
-        if (percentage > 1.0) {
-            std::cout << "  |" << c.first << "⟩: " << c.second
-                      << " (" << std::fixed << std::setprecision(1)
-                      << percentage << "%)" << std::endl;
+        if (percentage <= 1.0) {
+            break;
         }
+        std::cout << "  |" << c.first << "⟩: " << c.second
+                  << " (" << std::fixed << std::setprecision(1)
+                  << percentage << "%)" << std::endl;
     }
 
     std::cout << std::endl << "Summary:" << std::endl;
@@ -174,6 +627,96 @@ int main(int argc, char* argv[]) {
               << std::fixed << std::setprecision(1)
               << (100.0 * count_other / num_shots) << "%)" << std::endl;
 
+    // Packed outcomes for the analysis stages below
+    auto histogram = qkx::histogram_from_counts(counts, num_qubits);
+
+    // 95% bootstrap confidence intervals for the GHZ observables
+    auto ghz_ci = qkx::ghz_intervals(histogram, num_qubits);
+    std::cout << std::endl << "95% confidence intervals (bootstrap):" << std::endl;
+    std::cout << "  GHZ population: " << std::fixed << std::setprecision(1)
+              << (100.0 * ghz_ci.population.estimate) << "% ["
+              << (100.0 * ghz_ci.population.lower) << ", "
+              << (100.0 * ghz_ci.population.upper) << "]" << std::endl;
+    std::cout << "  Parity <Z...Z>: " << std::fixed << std::setprecision(3)
+              << ghz_ci.parity.estimate << " ["
+              << ghz_ci.parity.lower << ", "
+              << ghz_ci.parity.upper << "]" << std::endl;
+
+    // Coherence from the parity oscillation, and with the populations a
+    // fidelity estimate
+    if (sweep_points) {
+        std::cout << std::endl << "Parity oscillation <X...X>(phi):" << std::endl;
+        for (uint32_t k = 0; k < sweep_points; k++) {
+            std::cout << "  phi " << std::fixed << std::setprecision(4) << sweep_angles[k] << ": "
+                      << std::setprecision(3) << std::showpos << sweep_parities[k] << std::noshowpos
+                      << "  (ideal " << std::showpos << std::cos(num_qubits * sweep_angles[k])
+                      << std::noshowpos << ")" << std::endl;
+        }
+        double coherence = qkx::ghz_coherence(num_qubits, sweep_angles, sweep_parities);
+        std::cout << "  Coherence C: " << std::setprecision(3) << coherence << std::endl;
+        std::cout << "  Fidelity (P0 + P1 + C) / 2: " << (ghz_ci.population.estimate + coherence) / 2
+                  << std::endl;
+    }
+
+    // Error profile: distance to the nearest GHZ branch and per-qubit flips
+    qkx::GhzProfile profile(num_qubits);
+    profile.add(histogram);
+
+    std::cout << std::endl << "Distance to nearest GHZ branch:" << std::endl;
+    const auto& distances = profile.distance_histogram();
+    for (size_t d = 0; d < distances.size(); d++) {
+        if (distances[d] > 0) {
+            std::cout << "  " << std::setw(3) << d << ": " << distances[d] << " ("
+                      << std::fixed << std::setprecision(1)
+                      << (100.0 * distances[d] / num_shots) << "%)" << std::endl;
+        }
+    }
+    std::cout << "  mean: " << std::fixed << std::setprecision(2)
+              << profile.mean_distance() << std::endl;
+
+    std::cout << std::endl << "Most frequently flipped qubits:" << std::endl;
+    for (uint32_t q : profile.worst_qubits(5)) {
+        std::cout << "  clbit " << std::setw(3) << q
+                  << " (physical " << std::setw(3) << physical_qubits[q] << "): "
+                  << std::fixed << std::setprecision(2)
+                  << (100.0 * profile.flip_frequency(q)) << "%" << std::endl;
+    }
+
+    // Readout-error mitigation on the observed outcomes
+    if (mitigate) {
+        // Twirled measurements turn the calibrated rates into their mean
+        std::vector<qkx::QubitReadoutError> errors = calibration.for_qubits(physical_qubits);
+        qkx::ReadoutMitigator mitigator(twirl_instances ? qkx::twirled_readout_errors(errors) : errors);
+
+        qkx::MitigationStats stats;
+        auto quasi = mitigator.apply(histogram, &stats);
+
+        double mitigated_zeros = 0.0;
+        double mitigated_ones = 0.0;
+        double mitigated_other = 0.0;
+        for (size_t i = 0; i < quasi.outcomes.size(); i++) {
+            int weight = quasi.outcomes[i].hamming_weight();
+            if (weight == 0) {
+                mitigated_zeros += quasi.values[i];
+            } else if (weight == num_qubits) {
+                mitigated_ones += quasi.values[i];
+            } else {
+                mitigated_other += quasi.values[i];
+            }
+        }
+
+        std::cout << std::endl << "Readout-mitigated:" << std::endl;
+        std::cout << "  All 0s: " << std::fixed << std::setprecision(1)
+                  << (100.0 * mitigated_zeros) << "%" << std::endl;
+        std::cout << "  All 1s: " << std::fixed << std::setprecision(1)
+                  << (100.0 * mitigated_ones) << "%" << std::endl;
+        std::cout << "  Other (noise): " << std::fixed << std::setprecision(1)
+                  << (100.0 * mitigated_other) << "%" << std::endl;
+        std::cout << "  (" << quasi.outcomes.size() << " outcomes, "
+                  << stats.iterations << " GMRES iterations, overhead "
+                  << std::setprecision(2) << quasi.mitigation_overhead() << ")" << std::endl;
+    }
+
     std::cout << std::endl;
     std::cout << "Expected: ~50% all-0s and ~50% all-1s" << std::endl;
     std::cout << "(Other results indicate decoherence/noise)" << std::endl;
@@ -0,0 +1,101 @@
+/*
+ * Analytical sampler for GHZ and Bell circuits
+ *
+ * The circuits built by main.cpp and ghz_20q.cpp (H on one qubit, CX gates
+ * spreading it to fresh qubits, then measurements) prepare
+ * (|0...0> + |1...1>) / sqrt(2) on the qubits reached by the CX tree. Every
+ * ideal shot is therefore one of two fixed bit patterns, and a shot costs
+ * one random bit and a copy of num_words(num_clbits) words: 64 shots per
+ * random draw, at memory bandwidth. run_local takes this path for noiseless
+ * runs before dispatching to an engine.
+ */
+
+#ifndef QKX_GHZ_ANALYTIC_HPP
+#define QKX_GHZ_ANALYTIC_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+
+namespace qkx {
+
+struct GhzPattern {
+    std::vector<uint32_t> qubits;  // entangled qubits, root first
+    std::vector<uint64_t> ones;    // clbit pattern of the all-ones branch
+};
+
+// Whether `circ` is H(root), CX fan-out from entangled to untouched qubits
+// and terminal measurements (barriers anywhere); fills `pattern` if so
+inline bool recognize_ghz(const LocalCircuit& circ, GhzPattern& pattern) {
+    std::vector<char> entangled(circ.num_qubits(), 0);
+    pattern.qubits.clear();
+    pattern.ones.assign(num_words(circ.num_clbits()), 0);
+    bool measuring = false;
+    for (const Operation& op : circ.ops()) {
+        if (op.kind == GateKind::Barrier) {
+            continue;
+        }
+        if (op.kind == GateKind::Measure) {
+            measuring = true;
+            uint64_t bit = 1ULL << (op.clbit & 63);
+            if (entangled[op.qubits[0]]) {
+                pattern.ones[op.clbit >> 6] |= bit;
+            } else {
+                pattern.ones[op.clbit >> 6] &= ~bit;
+            }
+            continue;
+        }
+        if (measuring) {
+            return false;
+        }
+        if (pattern.qubits.empty()) {
+            if (op.kind != GateKind::H) {
+                return false;
+            }
+            entangled[op.qubits[0]] = 1;
+            pattern.qubits.push_back(op.qubits[0]);
+        } else if (op.kind == GateKind::CX && entangled[op.qubits[0]] && !entangled[op.qubits[1]]) {
+            entangled[op.qubits[1]] = 1;
+            pattern.qubits.push_back(op.qubits[1]);
+        } else {
+            return false;
+        }
+    }
+    return !pattern.qubits.empty();
+}
+
+// Ideal shots of a recognized circuit
+inline PackedShots sample_ghz(const LocalCircuit& circ, const GhzPattern& pattern, size_t shots,
+                              uint64_t seed = 0x6a2, unsigned num_threads = 0) {
+    PackedShots out(circ.num_clbits(), shots);
+    const uint32_t words = out.words_per_shot();
+    const uint64_t* ones = pattern.ones.data();
+    uint64_t* data = out.data();
+    Xoshiro256 base(seed);
+    // Chunks of whole 64-shot blocks, so each thread's draws are its own
+    const size_t blocks = (shots + 63) / 64;
+    parallel_for(blocks, default_num_threads(num_threads), 1024, [&](size_t begin, size_t end, unsigned t) {
+        Xoshiro256 rng = base.stream(t);
+        for (size_t b = begin; b < end; b++) {
+            uint64_t branch = rng();
+            size_t first = b * 64, last = std::min(shots, first + 64);
+            for (size_t s = first; s < last; s++, branch >>= 1) {
+                uint64_t mask = 0 - (branch & 1);
+                uint64_t* row = data + s * words;
+                for (uint32_t w = 0; w < words; w++) {
+                    row[w] = ones[w] & mask;
+                }
+            }
+        }
+    });
+    return out;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_GHZ_ANALYTIC_HPP
@@ -0,0 +1,86 @@
+/*
+ * Constant-depth GHZ preparation with mid-circuit measurement
+ *
+ * The CX fan-out from qubit 0 is N-1 layers deep, and so is the time the
+ * first qubit spends decohering. Measuring parities instead gives a GHZ
+ * state after a fixed number of layers at any N (Bäumer et al., "Efficient
+ * long-range entanglement using dynamic circuits"). On a line of 2N-1
+ * qubits with data qubits d_i = 2i and ancillas a_i = 2i+1 between them:
+ *
+ *   1. H on every data qubit,
+ *   2. CX(d_i, a_i), then CX(d_{i+1}, a_i): a_i holds d_i ⊕ d_{i+1},
+ *   3. measure every ancilla into m_i.
+ *
+ * The data qubits are now in a GHZ state up to X on every d_j whose prefix
+ * parity p_j = m_0 ⊕ ... ⊕ m_{j-1} is 1. On hardware with feed-forward that
+ * X would be applied conditionally; since the data qubits are only measured
+ * in Z afterwards, the X commutes into a classical bit flip, and
+ * fold_dynamic_ghz() applies it to the recorded shots instead. So the
+ * circuit needs no classical control flow and runs on any backend, and on
+ * the local engines (the ancillas are not touched after their measurement,
+ * so it counts as terminal).
+ *
+ * Clbits 0..N-1 hold the data qubits and N..2N-2 the ancillas.
+ */
+
+#ifndef QKX_GHZ_DYNAMIC_HPP
+#define QKX_GHZ_DYNAMIC_HPP
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "bitstring.hpp"
+
+namespace qkx {
+
+inline uint32_t dynamic_ghz_width(uint32_t num_qubits) {
+    return 2 * num_qubits - 1;
+}
+
+// Appends the preparation and all measurements to a LocalCircuit, a
+// QuantumCircuit or a TrackedCircuit of dynamic_ghz_width(n) qubits and clbits
+template <typename Circuit>
+void append_dynamic_ghz(Circuit& circ, uint32_t num_qubits) {
+    for (uint32_t i = 0; i < num_qubits; i++) {
+        circ.h(2 * i);
+    }
+    for (uint32_t i = 0; i + 1 < num_qubits; i++) {
+        circ.cx(2 * i, 2 * i + 1);
+    }
+    for (uint32_t i = 0; i + 1 < num_qubits; i++) {
+        circ.cx(2 * i + 2, 2 * i + 1);
+    }
+    for (uint32_t i = 0; i + 1 < num_qubits; i++) {
+        circ.measure(2 * i + 1, num_qubits + i);
+    }
+    for (uint32_t i = 0; i < num_qubits; i++) {
+        circ.measure(2 * i, i);
+    }
+}
+
+// The N corrected data bits of each shot: data bit j flipped by the
+// parity of ancilla bits 0..j-1
+inline PackedShots fold_dynamic_ghz(const PackedShots& raw, uint32_t num_qubits) {
+    if (raw.num_bits() != dynamic_ghz_width(num_qubits)) {
+        throw std::invalid_argument("shots do not come from a dynamic GHZ circuit of this size");
+    }
+    PackedShots out(num_qubits, raw.num_shots());
+    for (size_t s = 0; s < raw.num_shots(); s++) {
+        const uint64_t* in = raw.shot(s);
+        uint64_t* bits = out.shot(s);
+        uint64_t prefix = 0;
+        for (uint32_t j = 0; j < num_qubits; j++) {
+            if (j > 0) {
+                uint32_t a = num_qubits + j - 1;
+                prefix ^= (in[a >> 6] >> (a & 63)) & 1ULL;
+            }
+            uint64_t bit = ((in[j >> 6] >> (j & 63)) & 1ULL) ^ prefix;
+            bits[j >> 6] |= bit << (j & 63);
+        }
+    }
+    return out;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_GHZ_DYNAMIC_HPP
@@ -0,0 +1,158 @@
+/*
+ * Error profile of GHZ measurement results
+ *
+ * Every outcome of an N-qubit GHZ run is attributed to the nearer of the
+ * two ideal branches |0...0⟩ and |1...1⟩. In a single pass over packed
+ * outcomes this accumulates
+ *   - the distribution of Hamming distances to the nearest branch, and
+ *   - for each qubit, how often it disagrees with that branch,
+ * which separates a few bad qubits (high, uneven flip rates) from
+ * collective decoherence (wide distance distribution).
+ *
+ * Outcomes exactly halfway between the branches (possible for even N)
+ * cannot be attributed; they are counted in `ties` and excluded from the
+ * per-qubit flip counts.
+ */
+
+#ifndef QKX_GHZ_PROFILE_HPP
+#define QKX_GHZ_PROFILE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "bitstring.hpp"
+
+namespace qkx {
+
+class GhzProfile {
+public:
+    explicit GhzProfile(uint32_t num_qubits)
+        : num_qubits_(num_qubits),
+          words_(num_words(num_qubits)),
+          distance_(num_qubits / 2 + 1, 0),
+          flips_(num_qubits, 0) {
+        // Mask of valid bits in the last word, used to complement outcomes
+        uint32_t tail = num_qubits % 64;
+        last_mask_ = tail ? (1ULL << tail) - 1 : ~0ULL;
+    }
+
+    uint32_t num_qubits() const { return num_qubits_; }
+    uint64_t shots() const { return shots_; }
+    uint64_t near_zeros() const { return near_zeros_; }
+    uint64_t near_ones() const { return near_ones_; }
+    uint64_t ties() const { return ties_; }
+
+    // distance_histogram()[d] = shots at distance d from the nearest branch
+    const std::vector<uint64_t>& distance_histogram() const { return distance_; }
+    const std::vector<uint64_t>& flip_counts() const { return flips_; }
+
+    double flip_frequency(uint32_t qubit) const {
+        uint64_t attributed = shots_ - ties_;
+        return attributed ? static_cast<double>(flips_[qubit]) / static_cast<double>(attributed) : 0.0;
+    }
+
+    double mean_distance() const {
+        double sum = 0.0;
+        for (size_t d = 0; d < distance_.size(); d++) {
+            sum += static_cast<double>(d) * static_cast<double>(distance_[d]);
+        }
+        return shots_ ? sum / static_cast<double>(shots_) : 0.0;
+    }
+
+    // Account for `count` shots of one packed outcome
+    void add(const uint64_t* outcome, uint64_t count = 1) {
+        int weight = 0;
+        for (uint32_t w = 0; w < words_; w++) {
+            weight += popcount64(outcome[w]);
+        }
+        int distance = std::min<int>(weight, static_cast<int>(num_qubits_) - weight);
+        distance_[distance] += count;
+        shots_ += count;
+
+        if (2 * weight == static_cast<int>(num_qubits_)) {
+            ties_ += count;
+            return;
+        }
+        // Flipped qubits are the set bits near |0...0⟩, the clear bits near |1...1⟩
+        bool ones = 2 * weight > static_cast<int>(num_qubits_);
+        if (ones) {
+            near_ones_ += count;
+        } else {
+            near_zeros_ += count;
+        }
+        for (uint32_t w = 0; w < words_; w++) {
+            uint64_t flipped = ones ? ~outcome[w] : outcome[w];
+            if (w == words_ - 1) {
+                flipped &= last_mask_;
+            }
+            while (flipped) {
+                flips_[(w << 6) + ctz64(flipped)] += count;
+                flipped &= flipped - 1;
+            }
+        }
+    }
+
+    void add(const Histogram& hist) {
+        for (const auto& h : hist) {
+            check_width(h.first.num_bits());
+            add(h.first.data(), h.second);
+        }
+    }
+
+    void add(const PackedShots& shots) {
+        check_width(shots.num_bits());
+        for (size_t i = 0; i < shots.num_shots(); i++) {
+            add(shots.shot(i));
+        }
+    }
+
+    // Combine with a profile accumulated over another part of the data
+    void merge(const GhzProfile& other) {
+        check_width(other.num_qubits_);
+        for (size_t d = 0; d < distance_.size(); d++) {
+            distance_[d] += other.distance_[d];
+        }
+        for (uint32_t q = 0; q < num_qubits_; q++) {
+            flips_[q] += other.flips_[q];
+        }
+        shots_ += other.shots_;
+        near_zeros_ += other.near_zeros_;
+        near_ones_ += other.near_ones_;
+        ties_ += other.ties_;
+    }
+
+    // Indices of the k qubits with the highest flip counts, worst first
+    std::vector<uint32_t> worst_qubits(size_t k) const {
+        std::vector<uint32_t> order(num_qubits_);
+        std::iota(order.begin(), order.end(), 0);
+        k = std::min<size_t>(k, order.size());
+        std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                          [this](uint32_t a, uint32_t b) { return flips_[a] > flips_[b]; });
+        order.resize(k);
+        return order;
+    }
+
+private:
+    void check_width(uint32_t num_bits) const {
+        if (num_bits != num_qubits_) {
+            throw std::invalid_argument("outcome width does not match GHZ profile");
+        }
+    }
+
+    uint32_t num_qubits_;
+    uint32_t words_;
+    uint64_t last_mask_;
+    std::vector<uint64_t> distance_;
+    std::vector<uint64_t> flips_;
+    uint64_t shots_ = 0;
+    uint64_t near_zeros_ = 0;
+    uint64_t near_ones_ = 0;
+    uint64_t ties_ = 0;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_GHZ_PROFILE_HPP
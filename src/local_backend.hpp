@@ -0,0 +1,145 @@
+/*
+ * Local simulation backends
+ *
+ * Backend names of the form "local:<engine>" run a circuit in-process
+ * instead of on IBM Quantum hardware, so the examples can be exercised at
+ * full width without a service account. Every engine returns packed shots
+ * indexed by clbit, the same layout the hardware path builds from counts.
+ * Noisy engines take their error rates from options.noise, which is empty
+ * (noiseless) unless filled from a backend target. Noiseless GHZ and Bell
+ * circuits are sampled analytically (ghz_analytic.hpp) whatever the engine,
+ * unless options.analytic is cleared. local:distributed forks worker
+ * processes and is not available on Windows.
+ */
+
+#ifndef QKX_LOCAL_BACKEND_HPP
+#define QKX_LOCAL_BACKEND_HPP
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "bitstring.hpp"
+#include "decision_diagram.hpp"
+#include "density_matrix.hpp"
+#ifndef _WIN32
+#include "distributed_statevector.hpp"
+#endif
+#include "ghz_analytic.hpp"
+#include "local_circuit.hpp"
+#include "mps_simulator.hpp"
+#include "noise_model.hpp"
+#include "pauli_frame.hpp"
+#include "statevector.hpp"
+
+namespace qkx {
+
+struct LocalBackendOptions {
+    DecisionDiagramOptions decision_diagram;
+    DensityMatrixOptions density_matrix;
+#ifndef _WIN32
+    DistributedOptions distributed;
+#endif
+    MpsOptions mps;
+    PauliFrameOptions pauli_frame;
+    StatevectorOptions statevector;
+    NoiseModel noise;
+    bool analytic = true;  // sample recognized GHZ circuits without simulating
+};
+
+struct LocalResult {
+    PackedShots shots;
+    std::string details;  // one-line engine report for the console
+};
+
+inline bool is_local_backend(const std::string& name) {
+    return name.rfind("local:", 0) == 0;
+}
+
+inline const char* local_engine_names() {
+#ifndef _WIN32
+    return "local:decision_diagram, local:density_matrix, local:distributed, local:mps, "
+           "local:pauli_frame, local:statevector";
+#else
+    return "local:decision_diagram, local:density_matrix, local:mps, local:pauli_frame, local:statevector";
+#endif
+}
+
+inline bool is_local_engine(const std::string& engine) {
+    static const char* engines[] = {"decision_diagram", "density_matrix",
+#ifndef _WIN32
+                                    "distributed",
+#endif
+                                    "mps", "pauli_frame", "statevector"};
+    for (const char* e : engines) {
+        if (engine == e) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline LocalResult run_local(const std::string& backend, const LocalCircuit& circ, size_t shots,
+                             const LocalBackendOptions& options = LocalBackendOptions()) {
+    std::string engine = backend.substr(backend.find(':') + 1);
+    LocalResult result;
+    std::ostringstream details;
+
+    GhzPattern ghz;
+    if (options.analytic && options.noise.empty() && is_local_engine(engine) && recognize_ghz(circ, ghz)) {
+        result.shots = sample_ghz(circ, ghz, shots);
+        details << "analytic: " << ghz.qubits.size() << "-qubit GHZ circuit recognized, " << engine
+                << " not run";
+        result.details = details.str();
+        return result;
+    }
+
+    if (engine == "decision_diagram") {
+        DecisionDiagramStats stats;
+        result.shots = run_decision_diagram(circ, shots, options.decision_diagram, &stats);
+        details << "decision diagram: " << stats.num_gates << " gates, " << stats.state_nodes
+                << " nodes in the final state, peak " << stats.peak_nodes << " nodes ("
+                << stats.memory_bytes / double(1 << 20) << " MiB), " << stats.num_collections
+                << " collections, compute-table hit rate " << stats.compute_hit_rate;
+    } else if (engine == "density_matrix") {
+        DensityMatrixStats stats;
+        result.shots = run_density_matrix(circ, shots, options.noise, options.density_matrix, &stats);
+        details << "density matrix: " << stats.num_channels << " noisy gates in " << stats.num_passes
+                << " passes, final purity " << stats.purity;
+    }
+#ifndef _WIN32
+    else if (engine == "distributed") {
+        DistributedStats stats;
+        result.shots = run_distributed(circ, shots, options.distributed, &stats);
+        details << "distributed statevector: " << stats.num_processes << " processes, " << stats.num_passes
+                << " passes, " << stats.num_exchanges << " exchanges ("
+                << stats.exchanged_bytes / double(1 << 30) << " GiB moved)";
+    }
+#endif
+    else if (engine == "mps") {
+        MpsStats stats;
+        result.shots = run_mps(circ, shots, options.mps, &stats);
+        details << "MPS: max bond " << stats.max_bond << ", " << stats.num_swaps
+                << " swaps, truncation error " << stats.truncation_error;
+    } else if (engine == "pauli_frame") {
+        PauliFrameStats stats;
+        result.shots = run_pauli_frame(circ, shots, options.noise, options.pauli_frame, &stats);
+        details << "Pauli frames: " << stats.num_gates << " gates, " << stats.num_noisy_gates
+                << " noisy, " << stats.expected_gate_errors << " gate errors per shot";
+    } else if (engine == "statevector") {
+        StatevectorStats stats;
+        result.shots = run_statevector(circ, shots, options.statevector, &stats);
+        details << "statevector: " << stats.num_gates << " gates fused into " << stats.num_passes
+                << " passes of up to " << stats.max_fused_qubits << " qubits";
+    } else {
+        throw std::invalid_argument("unknown local engine '" + engine + "' (available: " +
+                                    local_engine_names() + ")");
+    }
+
+    result.details = details.str();
+    return result;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_LOCAL_BACKEND_HPP
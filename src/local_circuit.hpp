@@ -0,0 +1,305 @@
+/*
+ * Gate-list representation used by the local simulation engines
+ *
+ * The engines need random access to a flat, cheap-to-copy instruction list
+ * with fixed gate kinds and their matrices. LocalCircuit provides that
+ * independently of the Qiskit headers; qiskit_bridge.hpp converts to and
+ * from QuantumCircuit.
+ */
+
+#ifndef QKX_LOCAL_CIRCUIT_HPP
+#define QKX_LOCAL_CIRCUIT_HPP
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace qkx {
+
+using cplx = std::complex<double>;
+
+// M_PI is not standard C++ (MSVC needs _USE_MATH_DEFINES)
+constexpr double kPi = 3.14159265358979323846;
+
+enum class GateKind : uint8_t {
+    I, H, X, Y, Z, S, Sdg, T, Tdg, SX, SXdg, RX, RY, RZ, P, U,  // one qubit
+    CX, CY, CZ, ECR, Swap,                                      // two qubits
+    Measure, Reset, Barrier
+};
+
+struct Operation {
+    GateKind kind;
+    uint32_t num_qubits;
+    uint32_t qubits[2];
+    uint32_t clbit;        // Measure only
+    double params[3];
+};
+
+inline bool is_two_qubit(GateKind k) {
+    return k >= GateKind::CX && k <= GateKind::Swap;
+}
+
+inline bool is_unitary(GateKind k) {
+    return k < GateKind::Measure;
+}
+
+// Lower-case Qiskit gate name
+inline const char* gate_name(GateKind k) {
+    static const char* names[] = {
+        "id", "h", "x", "y", "z", "s", "sdg", "t", "tdg", "sx", "sxdg", "rx", "ry", "rz", "p", "u",
+        "cx", "cy", "cz", "ecr", "swap", "measure", "reset", "barrier"
+    };
+    return names[static_cast<int>(k)];
+}
+
+inline bool gate_kind_from_name(const std::string& name, GateKind& kind) {
+    for (int k = 0; k <= static_cast<int>(GateKind::Barrier); k++) {
+        if (name == gate_name(static_cast<GateKind>(k))) {
+            kind = static_cast<GateKind>(k);
+            return true;
+        }
+    }
+    if (name == "u3") {
+        kind = GateKind::U;
+        return true;
+    }
+    if (name == "u1") {
+        kind = GateKind::P;
+        return true;
+    }
+    return false;
+}
+
+inline uint32_t gate_num_params(GateKind k) {
+    switch (k) {
+        case GateKind::RX:
+        case GateKind::RY:
+        case GateKind::RZ:
+        case GateKind::P:
+            return 1;
+        case GateKind::U:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+class LocalCircuit {
+public:
+    LocalCircuit() = default;
+    LocalCircuit(uint32_t num_qubits, uint32_t num_clbits)
+        : num_qubits_(num_qubits), num_clbits_(num_clbits) {}
+
+    uint32_t num_qubits() const { return num_qubits_; }
+    uint32_t num_clbits() const { return num_clbits_; }
+    const std::vector<Operation>& ops() const { return ops_; }
+    std::vector<Operation>& ops() { return ops_; }
+    size_t size() const { return ops_.size(); }
+
+    void append(GateKind kind, std::initializer_list<uint32_t> qubits,
+                std::initializer_list<double> params = {}) {
+        Operation op{};
+        op.kind = kind;
+        op.num_qubits = static_cast<uint32_t>(qubits.size());
+        if (op.num_qubits > 2 || params.size() > 3) {
+            throw std::invalid_argument("unsupported operation arity");
+        }
+        uint32_t i = 0;
+        for (uint32_t q : qubits) {
+            check_qubit(q);
+            op.qubits[i++] = q;
+        }
+        i = 0;
+        for (double p : params) {
+            op.params[i++] = p;
+        }
+        ops_.push_back(op);
+    }
+
+    void append(const Operation& op) {
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            check_qubit(op.qubits[i]);
+        }
+        if (op.kind == GateKind::Measure && op.clbit >= num_clbits_) {
+            throw std::out_of_range("clbit out of range");
+        }
+        ops_.push_back(op);
+    }
+
+    void h(uint32_t q) { append(GateKind::H, {q}); }
+    void x(uint32_t q) { append(GateKind::X, {q}); }
+    void y(uint32_t q) { append(GateKind::Y, {q}); }
+    void z(uint32_t q) { append(GateKind::Z, {q}); }
+    void s(uint32_t q) { append(GateKind::S, {q}); }
+    void sdg(uint32_t q) { append(GateKind::Sdg, {q}); }
+    void sx(uint32_t q) { append(GateKind::SX, {q}); }
+    void rx(double theta, uint32_t q) { append(GateKind::RX, {q}, {theta}); }
+    void ry(double theta, uint32_t q) { append(GateKind::RY, {q}, {theta}); }
+    void rz(double theta, uint32_t q) { append(GateKind::RZ, {q}, {theta}); }
+    void cx(uint32_t c, uint32_t t) { append(GateKind::CX, {c, t}); }
+    void cz(uint32_t a, uint32_t b) { append(GateKind::CZ, {a, b}); }
+    void ecr(uint32_t a, uint32_t b) { append(GateKind::ECR, {a, b}); }
+    void swap(uint32_t a, uint32_t b) { append(GateKind::Swap, {a, b}); }
+    void reset(uint32_t q) { append(GateKind::Reset, {q}); }
+
+    void measure(uint32_t q, uint32_t c) {
+        Operation op{};
+        op.kind = GateKind::Measure;
+        op.num_qubits = 1;
+        op.qubits[0] = q;
+        op.clbit = c;
+        append(op);
+    }
+
+    void measure_all() {
+        for (uint32_t q = 0; q < num_qubits_ && q < num_clbits_; q++) {
+            measure(q, q);
+        }
+    }
+
+private:
+    void check_qubit(uint32_t q) const {
+        if (q >= num_qubits_) {
+            throw std::out_of_range("qubit out of range");
+        }
+    }
+
+    uint32_t num_qubits_ = 0;
+    uint32_t num_clbits_ = 0;
+    std::vector<Operation> ops_;
+};
+
+// (qubit, clbit) pairs of a circuit whose measurements all come after its
+// last gate on the measured qubit. Engines that sample a final state use
+// this to reject circuits that need mid-circuit collapse.
+inline std::vector<std::pair<uint32_t, uint32_t>> terminal_measurements(const LocalCircuit& circ) {
+    std::vector<std::pair<uint32_t, uint32_t>> measured;
+    std::vector<char> done(circ.num_qubits(), 0);
+    for (const Operation& op : circ.ops()) {
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            if (done[op.qubits[i]] && op.kind != GateKind::Measure) {
+                throw std::invalid_argument("circuit uses mid-circuit measurement");
+            }
+        }
+        if (op.kind == GateKind::Measure) {
+            done[op.qubits[0]] = 1;
+            measured.emplace_back(op.qubits[0], op.clbit);
+        } else if (op.kind == GateKind::Reset) {
+            throw std::invalid_argument("circuit uses reset");
+        }
+    }
+    return measured;
+}
+
+// The circuit restricted to the qubits it uses, renumbered in ascending
+// order; physical[i] receives the original index of new qubit i. Transpiled
+// circuits span the whole device, which the dense engines cannot afford.
+inline LocalCircuit compact_qubits(const LocalCircuit& circ, std::vector<uint32_t>& physical) {
+    std::vector<uint32_t> local(circ.num_qubits(), UINT32_MAX);
+    for (const Operation& op : circ.ops()) {
+        if (op.kind == GateKind::Barrier) {
+            continue;
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            local[op.qubits[i]] = 0;
+        }
+    }
+    physical.clear();
+    for (uint32_t q = 0; q < circ.num_qubits(); q++) {
+        if (local[q] == 0) {
+            local[q] = static_cast<uint32_t>(physical.size());
+            physical.push_back(q);
+        }
+    }
+    LocalCircuit out(static_cast<uint32_t>(physical.size()), circ.num_clbits());
+    for (Operation op : circ.ops()) {
+        if (op.kind == GateKind::Barrier) {
+            continue;
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            op.qubits[i] = local[op.qubits[i]];
+        }
+        out.append(op);
+    }
+    return out;
+}
+
+using Matrix2 = std::array<cplx, 4>;    // row-major
+using Matrix4 = std::array<cplx, 16>;   // row-major, basis |q1 q0⟩ with qubits[0] as q0
+
+inline Matrix2 unitary_1q(const Operation& op) {
+    const double r = 1.0 / std::sqrt(2.0);
+    const cplx i(0.0, 1.0);
+    const double* p = op.params;
+    switch (op.kind) {
+        case GateKind::I: return {1, 0, 0, 1};
+        case GateKind::H: return {r, r, r, -r};
+        case GateKind::X: return {0, 1, 1, 0};
+        case GateKind::Y: return {0, -i, i, 0};
+        case GateKind::Z: return {1, 0, 0, -1};
+        case GateKind::S: return {1, 0, 0, i};
+        case GateKind::Sdg: return {1, 0, 0, -i};
+        case GateKind::T: return {1, 0, 0, std::polar(1.0, kPi / 4)};
+        case GateKind::Tdg: return {1, 0, 0, std::polar(1.0, -kPi / 4)};
+        case GateKind::SX: return {cplx(0.5, 0.5), cplx(0.5, -0.5), cplx(0.5, -0.5), cplx(0.5, 0.5)};
+        case GateKind::SXdg: return {cplx(0.5, -0.5), cplx(0.5, 0.5), cplx(0.5, 0.5), cplx(0.5, -0.5)};
+        case GateKind::RX: return {std::cos(p[0] / 2), -i * std::sin(p[0] / 2),
+                                   -i * std::sin(p[0] / 2), std::cos(p[0] / 2)};
+        case GateKind::RY: return {std::cos(p[0] / 2), -std::sin(p[0] / 2),
+                                   std::sin(p[0] / 2), std::cos(p[0] / 2)};
+        case GateKind::RZ: return {std::polar(1.0, -p[0] / 2), 0, 0, std::polar(1.0, p[0] / 2)};
+        case GateKind::P: return {1, 0, 0, std::polar(1.0, p[0])};
+        case GateKind::U: return {std::cos(p[0] / 2), -std::polar(1.0, p[2]) * std::sin(p[0] / 2),
+                                  std::polar(1.0, p[1]) * std::sin(p[0] / 2),
+                                  std::polar(1.0, p[1] + p[2]) * std::cos(p[0] / 2)};
+        default:
+            throw std::invalid_argument(std::string("not a one-qubit gate: ") + gate_name(op.kind));
+    }
+}
+
+// Row/column index b0 + 2*b1, where b0 is the state of op.qubits[0]
+inline Matrix4 unitary_2q(const Operation& op) {
+    const cplx i(0.0, 1.0);
+    const double r = 1.0 / std::sqrt(2.0);
+    Matrix4 m{};
+    switch (op.kind) {
+        case GateKind::CX:  // control qubits[0], target qubits[1]
+            m[0] = m[2 * 4 + 2] = 1;
+            m[1 * 4 + 3] = m[3 * 4 + 1] = 1;
+            return m;
+        case GateKind::CY:
+            m[0] = m[2 * 4 + 2] = 1;
+            m[1 * 4 + 3] = -i;
+            m[3 * 4 + 1] = i;
+            return m;
+        case GateKind::CZ:
+            m[0] = m[5] = m[10] = 1;
+            m[15] = -1;
+            return m;
+        case GateKind::Swap:
+            m[0] = m[15] = 1;
+            m[1 * 4 + 2] = m[2 * 4 + 1] = 1;
+            return m;
+        case GateKind::ECR: {
+            // Qiskit ECR with qubits[0] as the first (control-like) qubit:
+            // (1/√2) [[0, 1, 0, i], [1, 0, -i, 0], [0, i, 0, 1], [-i, 0, 1, 0]]
+            // in Qiskit's little-endian basis
+            const cplx e[16] = {0, 1, 0, i, 1, 0, -i, 0, 0, i, 0, 1, -i, 0, 1, 0};
+            for (int k = 0; k < 16; k++) {
+                m[k] = r * e[k];
+            }
+            return m;
+        }
+        default:
+            throw std::invalid_argument(std::string("not a two-qubit gate: ") + gate_name(op.kind));
+    }
+}
+
+}  // namespace qkx
+
+#endif  // QKX_LOCAL_CIRCUIT_HPP
@@ -10,14 +10,24 @@
 
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <string>
 #include <cstdlib>
+#include <vector>
+
+#include <nlohmann/json.hpp>
 
 #include "circuit/quantumcircuit.hpp"
 #include "primitives/backend_sampler_v2.hpp"
 #include "service/qiskit_runtime_service.hpp"
 #include "compiler/transpiler.hpp"
 
+#include "bitstring.hpp"
+#include "bootstrap.hpp"
+#include "density_matrix.hpp"
+#include "qiskit_bridge.hpp"
+#include "readout_calibration.hpp"
+
 using namespace Qiskit;
 using namespace Qiskit::circuit;
 using namespace Qiskit::providers;
@@ -32,12 +42,27 @@ int main(int argc, char* argv[]) {
     std::string backend_name = "ibm_torino";  // Default backend
     int num_shots = 1024;
 
-    // Parse command line arguments
-    if (argc > 1) {
-        backend_name = argv[1];
+    bool exact = false;              // Print the exact noisy prediction
+    std::string properties_file;     // Backend properties JSON (T1/T2)
+
+    // Parse command line arguments: [backend] [shots] [--exact] [--properties FILE]
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--exact") {
+            exact = true;
+        } else if (arg == "--properties" && i + 1 < argc) {
+            properties_file = argv[++i];
+            exact = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() > 0) {
+        backend_name = positional[0];
     }
-    if (argc > 2) {
-        num_shots = std::atoi(argv[2]);
+    if (positional.size() > 1) {
+        num_shots = std::atoi(positional[1].c_str());
     }
 
     std::cout << "Bell State Circuit Example" << std::endl;
@@ -71,6 +96,36 @@ int main(int argc, char* argv[]) {
     // Transpile circuit for the target backend
     auto transpiled_circ = transpile(circ, backend);
 
+    // Exact outcome distribution of the transpiled circuit under the
+    // backend's reported noise, on the qubits it actually uses
+    std::vector<double> predicted;
+    if (exact) {
+        qkx::NoiseModel noise = qkx::noise_model_from_target(backend.target());
+        if (!properties_file.empty()) {
+            std::ifstream in(properties_file);
+            if (!in) {
+                std::cerr << "Error: cannot read " << properties_file << std::endl;
+                return -1;
+            }
+            qkx::add_backend_properties(noise, nlohmann::json::parse(in));
+        }
+        qkx::ReadoutCalibration cached;
+        auto measured = qkx::measured_qubits(transpiled_circ);
+        if (qkx::ReadoutCalibrationCache().load(backend_name, cached) && cached.covers(measured)) {
+            for (uint32_t q : measured) {
+                noise.set_readout_error(q, cached.qubits.at(q));
+            }
+        }
+
+        std::vector<uint32_t> physical;
+        qkx::LocalCircuit local = qkx::compact_qubits(qkx::from_quantum_circuit(transpiled_circ), physical);
+        qkx::DensityMatrixStats stats;
+        predicted = qkx::density_matrix_probabilities(local, noise.remap(physical),
+                                                      qkx::DensityMatrixOptions(), &stats);
+        std::cout << "Exact noisy prediction: " << stats.num_channels << " noisy gates on "
+                  << physical.size() << " qubits, final purity " << stats.purity << std::endl;
+    }
+
     // Create sampler and run the circuit
     auto sampler = Sampler(backend, num_shots);
     auto job = sampler.run({SamplerPub(transpiled_circ)});
@@ -88,14 +143,26 @@ int main(int argc, char* argv[]) {
     auto meas_bits = pub_result.data("meas");
     auto counts = meas_bits.get_counts();
 
+    // 95% bootstrap confidence intervals, in the same order as counts
+    auto intervals = qkx::probability_intervals(counts);
+
     // Print measurement results
     std::cout << std::endl << "Measurement Results:" << std::endl;
     std::cout << "-------------------" << std::endl;
+    size_t i = 0;
     for (const auto& c : counts) {
         double percentage = (100.0 * c.second) / num_shots;
         std::cout << "  |" << c.first << "⟩: " << c.second
                   << " (" << std::fixed << std::setprecision(1)
-                  << percentage << "%)" << std::endl;
+                  << percentage << "%, 95% CI "
+                  << (100.0 * intervals[i].lower) << "–"
+                  << (100.0 * intervals[i].upper) << "%)";
+        if (!predicted.empty()) {
+            uint64_t outcome = qkx::Bitstring::from_string(c.first, 2).words()[0];
+            std::cout << ", predicted " << (100.0 * predicted[outcome]) << "%";
+        }
+        std::cout << std::endl;
+        i++;
     }
 
     std::cout << std::endl;
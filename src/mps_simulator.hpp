@@ -0,0 +1,511 @@
+/*
+ * Matrix-product-state simulator
+ *
+ * The state is a chain of rank-3 tensors A[site](l, s, r). Two-qubit gates
+ * on neighbouring sites contract the pair, apply the gate and split it
+ * again with an SVD, keeping at most `max_bond` singular values and
+ * discarding a tail whose weight is below `truncation`. Memory is
+ * O(n * chi^2), so a 127-qubit GHZ state (chi = 2) takes a few kilobytes.
+ *
+ * Gates on non-neighbouring qubits are brought together with SWAPs. The
+ * qubit-to-site assignment is kept between gates instead of swapping back:
+ * whichever operand is used again sooner is the one moved, so the
+ * cx(0, i) fan-out of ghz_20q costs one SWAP per gate and qubit 0 simply
+ * walks along the chain.
+ *
+ * The orthogonality centre is tracked, so every SVD truncation is optimal
+ * and sampling starts from a right-canonical chain: each shot walks the
+ * sites once, O(n * chi^2) per shot. Shots are split across threads with
+ * independent random streams; contractions on large bonds are split
+ * across threads as well.
+ *
+ * Only terminal measurements are supported.
+ */
+
+#ifndef QKX_MPS_SIMULATOR_HPP
+#define QKX_MPS_SIMULATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+
+namespace qkx {
+
+struct MpsOptions {
+    size_t max_bond = 256;     // maximum bond dimension chi
+    double truncation = 1e-12; // discarded weight allowed per SVD
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+    uint64_t seed = 0x4d5053;
+};
+
+struct MpsStats {
+    size_t max_bond = 1;
+    size_t num_swaps = 0;
+    double truncation_error = 0.0;  // summed discarded weight
+};
+
+// Thin SVD A = U diag(S) Vh of a row-major m x n matrix by one-sided
+// Jacobi rotations. Singular values are returned in descending order.
+struct Svd {
+    size_t rank = 0;
+    std::vector<cplx> u;    // m x rank, row-major
+    std::vector<double> s;  // rank
+    std::vector<cplx> vh;   // rank x n, row-major
+};
+
+inline Svd svd(size_t m, size_t n, const std::vector<cplx>& a) {
+    // Work on the transpose-conjugate when the matrix is wide, so the
+    // rotated columns are never more numerous than their length
+    const bool wide = n > m;
+    const size_t rows = wide ? n : m;
+    const size_t cols = wide ? m : n;
+
+    // Column-major working copy B (rows x cols) and V (cols x cols)
+    std::vector<cplx> b(rows * cols), v(cols * cols, 0.0);
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (wide) {
+                b[i * rows + j] = std::conj(a[i * n + j]);
+            } else {
+                b[j * rows + i] = a[i * n + j];
+            }
+        }
+    }
+    for (size_t j = 0; j < cols; j++) {
+        v[j * cols + j] = 1.0;
+    }
+
+    const double eps = 1e-15;
+    for (int sweep = 0; sweep < 60; sweep++) {
+        bool rotated = false;
+        for (size_t p = 0; p + 1 < cols; p++) {
+            for (size_t q = p + 1; q < cols; q++) {
+                cplx* bp = &b[p * rows];
+                cplx* bq = &b[q * rows];
+                double alpha = 0.0, beta = 0.0;
+                cplx gamma = 0.0;
+                for (size_t i = 0; i < rows; i++) {
+                    alpha += std::norm(bp[i]);
+                    beta += std::norm(bq[i]);
+                    gamma += std::conj(bp[i]) * bq[i];
+                }
+                double g = std::abs(gamma);
+                if (g <= eps * std::sqrt(alpha * beta) || g == 0.0) {
+                    continue;
+                }
+                rotated = true;
+                cplx phase = gamma / g;
+                double zeta = (beta - alpha) / (2.0 * g);
+                double t = (zeta >= 0.0 ? 1.0 : -1.0) / (std::fabs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                double c = 1.0 / std::sqrt(1.0 + t * t);
+                double s = c * t;
+                cplx sp = s * std::conj(phase);
+                for (size_t i = 0; i < rows; i++) {
+                    cplx x = bp[i], y = bq[i] * std::conj(phase);
+                    bp[i] = c * x - s * y;
+                    bq[i] = s * x + c * y;
+                }
+                cplx* vp = &v[p * cols];
+                cplx* vq = &v[q * cols];
+                for (size_t i = 0; i < cols; i++) {
+                    cplx x = vp[i], y = vq[i];
+                    vp[i] = c * x - sp * y;
+                    vq[i] = s * x + c * std::conj(phase) * y;
+                }
+            }
+        }
+        if (!rotated) {
+            break;
+        }
+    }
+
+    std::vector<double> sigma(cols);
+    for (size_t j = 0; j < cols; j++) {
+        double nrm = 0.0;
+        for (size_t i = 0; i < rows; i++) {
+            nrm += std::norm(b[j * rows + i]);
+        }
+        sigma[j] = std::sqrt(nrm);
+    }
+    std::vector<size_t> order(cols);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&sigma](size_t x, size_t y) { return sigma[x] > sigma[y]; });
+
+    // B = U' S with U' = B / S, and B = B0 V, so B0 = U' S V^H
+    Svd out;
+    out.rank = cols;
+    out.s.resize(cols);
+    std::vector<cplx> left(rows * cols), right(cols * cols);  // left: rows x k, right: k x cols (V^H)
+    for (size_t k = 0; k < cols; k++) {
+        size_t j = order[k];
+        out.s[k] = sigma[j];
+        double inv = sigma[j] > 0.0 ? 1.0 / sigma[j] : 0.0;
+        for (size_t i = 0; i < rows; i++) {
+            left[i * cols + k] = b[j * rows + i] * inv;
+        }
+        for (size_t i = 0; i < cols; i++) {
+            right[k * cols + i] = std::conj(v[j * cols + i]);
+        }
+    }
+
+    if (!wide) {
+        out.u = std::move(left);
+        out.vh = std::move(right);
+    } else {
+        // A^H = L S R  =>  A = R^H S L^H
+        out.u.resize(m * cols);
+        out.vh.resize(cols * n);
+        for (size_t i = 0; i < m; i++) {
+            for (size_t k = 0; k < cols; k++) {
+                out.u[i * cols + k] = std::conj(right[k * cols + i]);
+            }
+        }
+        for (size_t k = 0; k < cols; k++) {
+            for (size_t j = 0; j < n; j++) {
+                out.vh[k * n + j] = std::conj(left[j * cols + k]);
+            }
+        }
+    }
+    return out;
+}
+
+class MpsSimulator {
+public:
+    explicit MpsSimulator(uint32_t num_qubits, MpsOptions options = MpsOptions())
+        : num_qubits_(num_qubits), options_(options), sites_(num_qubits),
+          site_of_(num_qubits), qubit_at_(num_qubits) {
+        options_.num_threads = default_num_threads(options_.num_threads);
+        options_.max_bond = std::max<size_t>(1, options_.max_bond);
+        for (uint32_t q = 0; q < num_qubits; q++) {
+            sites_[q].dl = sites_[q].dr = 1;
+            sites_[q].a = {1.0, 0.0};
+            site_of_[q] = qubit_at_[q] = q;
+        }
+    }
+
+    const MpsStats& stats() const { return stats_; }
+
+    // Apply every gate of the circuit; measurements are left to sample()
+    void run(const LocalCircuit& circ) {
+        if (circ.num_qubits() != num_qubits_) {
+            throw std::invalid_argument("circuit width does not match simulator");
+        }
+        const auto& ops = circ.ops();
+
+        // next_use[i][k]: index of the next op after i touching ops[i].qubits[k]
+        std::vector<size_t> last(num_qubits_, std::numeric_limits<size_t>::max());
+        std::vector<std::array<size_t, 2>> next_use(ops.size());
+        for (size_t i = ops.size(); i > 0; i--) {
+            const Operation& op = ops[i - 1];
+            for (uint32_t k = 0; k < op.num_qubits; k++) {
+                next_use[i - 1][k] = last[op.qubits[k]];
+            }
+            for (uint32_t k = 0; k < op.num_qubits; k++) {
+                last[op.qubits[k]] = i - 1;
+            }
+        }
+
+        for (size_t i = 0; i < ops.size(); i++) {
+            const Operation& op = ops[i];
+            if (op.kind == GateKind::Measure || op.kind == GateKind::Barrier || op.kind == GateKind::I) {
+                continue;
+            }
+            if (op.kind == GateKind::Reset) {
+                throw std::invalid_argument("MPS engine does not support reset");
+            }
+            if (op.num_qubits == 1) {
+                apply_1q(site_of_[op.qubits[0]], unitary_1q(op));
+            } else {
+                bring_together(op.qubits[0], op.qubits[1], next_use[i][0] <= next_use[i][1]);
+                apply_2q(op.qubits[0], op.qubits[1], unitary_2q(op));
+            }
+        }
+    }
+
+    // Draw shots of the qubits measured by `circ`, writing each into its clbit
+    PackedShots sample(const LocalCircuit& circ, size_t shots) {
+        auto measured = terminal_measurements(circ);
+        move_center(0);
+
+        PackedShots out(circ.num_clbits(), shots);
+        Xoshiro256 base(options_.seed);
+        parallel_for(shots, options_.num_threads, 64, [&](size_t begin, size_t end, unsigned t) {
+            Xoshiro256 rng = base.stream(t);
+            std::vector<uint8_t> config(num_qubits_);
+            std::vector<cplx> v, w0, w1;
+            for (size_t shot = begin; shot < end; shot++) {
+                v.assign(1, 1.0);
+                for (uint32_t site = 0; site < num_qubits_; site++) {
+                    const Site& A = sites_[site];
+                    w0.assign(A.dr, 0.0);
+                    w1.assign(A.dr, 0.0);
+                    for (size_t l = 0; l < A.dl; l++) {
+                        const cplx* row0 = &A.a[(l * 2) * A.dr];
+                        const cplx* row1 = &A.a[(l * 2 + 1) * A.dr];
+                        for (size_t r = 0; r < A.dr; r++) {
+                            w0[r] += v[l] * row0[r];
+                            w1[r] += v[l] * row1[r];
+                        }
+                    }
+                    double p0 = 0.0, p1 = 0.0;
+                    for (size_t r = 0; r < A.dr; r++) {
+                        p0 += std::norm(w0[r]);
+                        p1 += std::norm(w1[r]);
+                    }
+                    bool one = rng.uniform() * (p0 + p1) >= p0;
+                    config[qubit_at_[site]] = one;
+                    double scale = 1.0 / std::sqrt(one ? p1 : p0);
+                    v.resize(A.dr);
+                    for (size_t r = 0; r < A.dr; r++) {
+                        v[r] = (one ? w1[r] : w0[r]) * scale;
+                    }
+                }
+                uint64_t* row = out.shot(shot);
+                for (const auto& m : measured) {
+                    if (config[m.first]) {
+                        row[m.second >> 6] |= 1ULL << (m.second & 63);
+                    } else {
+                        row[m.second >> 6] &= ~(1ULL << (m.second & 63));
+                    }
+                }
+            }
+        });
+        return out;
+    }
+
+private:
+    struct Site {
+        size_t dl = 1, dr = 1;
+        std::vector<cplx> a;  // (l, s, r) at (l * 2 + s) * dr + r
+    };
+
+    void apply_1q(uint32_t site, const Matrix2& u) {
+        Site& A = sites_[site];
+        for (size_t l = 0; l < A.dl; l++) {
+            cplx* row0 = &A.a[(l * 2) * A.dr];
+            cplx* row1 = &A.a[(l * 2 + 1) * A.dr];
+            for (size_t r = 0; r < A.dr; r++) {
+                cplx x0 = row0[r], x1 = row1[r];
+                row0[r] = u[0] * x0 + u[1] * x1;
+                row1[r] = u[2] * x0 + u[3] * x1;
+            }
+        }
+    }
+
+    // Move qubits a and b onto neighbouring sites by swapping one of them
+    // along the chain
+    void bring_together(uint32_t a, uint32_t b, bool move_a) {
+        uint32_t mover = move_a ? a : b;
+        uint32_t anchor = move_a ? b : a;
+        while (true) {
+            uint32_t sm = site_of_[mover], sa = site_of_[anchor];
+            if (sm + 1 == sa || sa + 1 == sm) {
+                return;
+            }
+            uint32_t next = sm < sa ? sm + 1 : sm - 1;
+            Operation swap{};
+            swap.kind = GateKind::Swap;
+            swap.num_qubits = 2;
+            swap.qubits[0] = mover;
+            swap.qubits[1] = qubit_at_[next];
+            apply_2q(swap.qubits[0], swap.qubits[1], unitary_2q(swap));
+            std::swap(qubit_at_[sm], qubit_at_[next]);
+            site_of_[qubit_at_[sm]] = sm;
+            site_of_[qubit_at_[next]] = next;
+            stats_.num_swaps++;
+        }
+    }
+
+    // Two-qubit gate on qubits at neighbouring sites
+    void apply_2q(uint32_t q0, uint32_t q1, const Matrix4& u) {
+        uint32_t left = std::min(site_of_[q0], site_of_[q1]);
+        bool q0_left = site_of_[q0] == left;
+        move_center(left);
+
+        Site& A = sites_[left];
+        Site& B = sites_[left + 1];
+        const size_t dl = A.dl, dm = A.dr, dr = B.dr;
+
+        // theta[(l, s), (t, r)] = sum_m A(l, s, m) B(m, t, r)
+        std::vector<cplx> theta(dl * 2 * 2 * dr, 0.0);
+        parallel_for(dl * 2, options_.num_threads, contraction_grain(dm * 2 * dr), [&](size_t begin, size_t end, unsigned) {
+            for (size_t ls = begin; ls < end; ls++) {
+                cplx* out = &theta[ls * 2 * dr];
+                for (size_t m = 0; m < dm; m++) {
+                    cplx x = A.a[ls * dm + m];
+                    if (x == 0.0) {
+                        continue;
+                    }
+                    const cplx* brow = &B.a[m * 2 * dr];
+                    for (size_t tr = 0; tr < 2 * dr; tr++) {
+                        out[tr] += x * brow[tr];
+                    }
+                }
+            }
+        });
+
+        // Apply the gate on the (s, t) indices; gate index is b(q0) + 2 b(q1)
+        parallel_for(dl, options_.num_threads, contraction_grain(4 * dr), [&](size_t begin, size_t end, unsigned) {
+            cplx in[4];
+            for (size_t l = begin; l < end; l++) {
+                for (size_t r = 0; r < dr; r++) {
+                    for (int s = 0; s < 2; s++) {
+                        for (int t = 0; t < 2; t++) {
+                            int g = q0_left ? s + 2 * t : t + 2 * s;
+                            in[g] = theta[((l * 2 + s) * 2 + t) * dr + r];
+                        }
+                    }
+                    for (int s = 0; s < 2; s++) {
+                        for (int t = 0; t < 2; t++) {
+                            int g = q0_left ? s + 2 * t : t + 2 * s;
+                            theta[((l * 2 + s) * 2 + t) * dr + r] =
+                                u[g * 4 + 0] * in[0] + u[g * 4 + 1] * in[1] +
+                                u[g * 4 + 2] * in[2] + u[g * 4 + 3] * in[3];
+                        }
+                    }
+                }
+            }
+        });
+
+        Svd f = svd(dl * 2, 2 * dr, theta);
+        size_t keep = truncate(f);
+
+        A.dr = keep;
+        A.a.assign(dl * 2 * keep, 0.0);
+        for (size_t row = 0; row < dl * 2; row++) {
+            for (size_t k = 0; k < keep; k++) {
+                A.a[row * keep + k] = f.u[row * f.rank + k];
+            }
+        }
+        B.dl = keep;
+        B.a.assign(keep * 2 * dr, 0.0);
+        for (size_t k = 0; k < keep; k++) {
+            for (size_t col = 0; col < 2 * dr; col++) {
+                B.a[k * 2 * dr + col] = f.s[k] * f.vh[k * 2 * dr + col];
+            }
+        }
+        center_ = left + 1;
+        stats_.max_bond = std::max(stats_.max_bond, keep);
+    }
+
+    size_t contraction_grain(size_t work_per_item) const {
+        // Roughly 64k complex multiply-adds per thread before splitting pays
+        return std::max<size_t>(1, (1 << 16) / std::max<size_t>(1, work_per_item));
+    }
+
+    // Number of singular values to keep; rescales them to preserve the norm
+    size_t truncate(Svd& f) {
+        double total = 0.0;
+        for (double s : f.s) {
+            total += s * s;
+        }
+        size_t keep = f.rank;
+        double discarded = 0.0;
+        while (keep > 1) {
+            double w = f.s[keep - 1] * f.s[keep - 1];
+            if (keep <= options_.max_bond && discarded + w > options_.truncation * total) {
+                break;
+            }
+            discarded += w;
+            keep--;
+        }
+        if (total > 0.0 && discarded > 0.0) {
+            double scale = std::sqrt(total / (total - discarded));
+            for (size_t k = 0; k < keep; k++) {
+                f.s[k] *= scale;
+            }
+            stats_.truncation_error += discarded / total;
+        }
+        return keep;
+    }
+
+    // Shift the orthogonality centre to `target` with SVD splits, truncated
+    // like gate splits
+    void move_center(uint32_t target) {
+        while (center_ < target) {
+            Site& A = sites_[center_];
+            Site& B = sites_[center_ + 1];
+            Svd f = svd(A.dl * 2, A.dr, A.a);
+            size_t k = truncate(f);
+            std::vector<cplx> left(A.dl * 2 * k);
+            for (size_t row = 0; row < A.dl * 2; row++) {
+                for (size_t j = 0; j < k; j++) {
+                    left[row * k + j] = f.u[row * f.rank + j];
+                }
+            }
+            // B <- (S Vh) B
+            std::vector<cplx> nb(k * 2 * B.dr, 0.0);
+            for (size_t i = 0; i < k; i++) {
+                for (size_t m = 0; m < A.dr; m++) {
+                    cplx x = f.s[i] * f.vh[i * A.dr + m];
+                    for (size_t c = 0; c < 2 * B.dr; c++) {
+                        nb[i * 2 * B.dr + c] += x * B.a[m * 2 * B.dr + c];
+                    }
+                }
+            }
+            A.a = std::move(left);
+            A.dr = k;
+            B.a = std::move(nb);
+            B.dl = k;
+            center_++;
+        }
+        while (center_ > target) {
+            Site& A = sites_[center_ - 1];
+            Site& B = sites_[center_];
+            Svd f = svd(B.dl, 2 * B.dr, B.a);
+            size_t k = truncate(f);
+            // A <- A (U S)
+            std::vector<cplx> na(A.dl * 2 * k, 0.0);
+            for (size_t ls = 0; ls < A.dl * 2; ls++) {
+                for (size_t m = 0; m < B.dl; m++) {
+                    cplx x = A.a[ls * A.dr + m];
+                    for (size_t j = 0; j < k; j++) {
+                        na[ls * k + j] += x * f.u[m * f.rank + j] * f.s[j];
+                    }
+                }
+            }
+            A.a = std::move(na);
+            A.dr = k;
+            f.vh.resize(k * 2 * B.dr);
+            B.a = std::move(f.vh);
+            B.dl = k;
+            center_--;
+        }
+    }
+
+    uint32_t num_qubits_;
+    MpsOptions options_;
+    std::vector<Site> sites_;
+    std::vector<uint32_t> site_of_;
+    std::vector<uint32_t> qubit_at_;
+    uint32_t center_ = 0;
+    MpsStats stats_;
+};
+
+// Simulate `circ` and draw shots of its terminal measurements
+inline PackedShots run_mps(const LocalCircuit& circ, size_t shots, MpsOptions options = MpsOptions(),
+                           MpsStats* stats = nullptr) {
+    MpsSimulator sim(circ.num_qubits(), options);
+    sim.run(circ);
+    PackedShots out = sim.sample(circ, shots);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return out;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_MPS_SIMULATOR_HPP
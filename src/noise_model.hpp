@@ -0,0 +1,244 @@
+/*
+ * Calibration-driven noise model for the local engines
+ *
+ * Holds what a backend reports about each gate on each tuple of physical
+ * qubits (error rate and duration), the T1/T2 times of each qubit and its
+ * readout assignment errors. Gate errors are average gate infidelities r,
+ * as published in the backend target and properties. The Pauli-frame
+ * engine models each as a depolarizing channel with the same infidelity,
+ * i.e. a uniformly random non-identity Pauli applied after the gate with
+ * probability r * (d + 1) / d; the density-matrix engine combines thermal
+ * relaxation over the gate duration with a depolarizing channel making up
+ * the rest of r.
+ *
+ * The target only carries gate errors, durations and a symmetric readout
+ * error. T1/T2 and asymmetric readout errors come from the backend
+ * properties document (add_backend_properties), as served by the IBM
+ * Quantum API for each backend.
+ */
+
+#ifndef QKX_NOISE_MODEL_HPP
+#define QKX_NOISE_MODEL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "local_circuit.hpp"
+#include "readout_mitigation.hpp"
+
+namespace qkx {
+
+struct QubitCoherence {
+    double t1 = std::numeric_limits<double>::infinity();  // seconds
+    double t2 = std::numeric_limits<double>::infinity();  // seconds
+};
+
+class NoiseModel {
+public:
+    bool empty() const { return gates_.empty() && readout_.empty() && coherence_.empty(); }
+
+    void set_gate_error(GateKind kind, std::initializer_list<uint32_t> qubits, double error) {
+        gates_[key(kind, qubits)].error = error;
+    }
+
+    void set_gate_duration(GateKind kind, std::initializer_list<uint32_t> qubits, double seconds) {
+        gates_[key(kind, qubits)].duration = seconds;
+    }
+
+    void set_readout_error(uint32_t qubit, QubitReadoutError error) {
+        if (qubit >= readout_.size()) {
+            readout_.resize(qubit + 1);
+        }
+        readout_[qubit] = error;
+    }
+
+    void set_coherence(uint32_t qubit, QubitCoherence coherence) {
+        if (qubit >= coherence_.size()) {
+            coherence_.resize(qubit + 1);
+        }
+        coherence_[qubit] = coherence;
+    }
+
+    // Average gate infidelity of `op`, 0 if the backend reported none
+    double gate_error(const Operation& op) const {
+        auto it = gates_.find(key(op));
+        return it == gates_.end() ? 0.0 : it->second.error;
+    }
+
+    // Duration of `op` in seconds, 0 if the backend reported none
+    double gate_duration(const Operation& op) const {
+        auto it = gates_.find(key(op));
+        return it == gates_.end() ? 0.0 : it->second.duration;
+    }
+
+    // Probability of a non-identity Pauli error after `op`
+    double pauli_error(const Operation& op) const {
+        double d = op.num_qubits == 2 ? 4.0 : 2.0;
+        return std::min(1.0, gate_error(op) * (d + 1.0) / d);
+    }
+
+    QubitReadoutError readout_error(uint32_t qubit) const {
+        return qubit < readout_.size() ? readout_[qubit] : QubitReadoutError();
+    }
+
+    QubitCoherence coherence(uint32_t qubit) const {
+        return qubit < coherence_.size() ? coherence_[qubit] : QubitCoherence();
+    }
+
+    // The model seen by a circuit compacted onto `physical`, where local
+    // qubit i is physical qubit physical[i]
+    NoiseModel remap(const std::vector<uint32_t>& physical) const {
+        std::unordered_map<uint32_t, uint32_t> local;
+        for (uint32_t i = 0; i < physical.size(); i++) {
+            local[physical[i]] = i;
+        }
+        NoiseModel out;
+        for (const auto& g : gates_) {
+            GateKind kind = static_cast<GateKind>(g.first >> 56);
+            uint32_t q0 = static_cast<uint32_t>((g.first >> 24) & 0xffffff);
+            uint32_t q1 = static_cast<uint32_t>(g.first & 0xffffff);
+            auto a = local.find(q0);
+            if (a == local.end()) {
+                continue;
+            }
+            if (q1 == 0) {
+                out.gates_[key(kind, {a->second})] = g.second;
+            } else {
+                auto b = local.find(q1 - 1);
+                if (b != local.end()) {
+                    out.gates_[key(kind, {a->second, b->second})] = g.second;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < physical.size(); i++) {
+            out.set_readout_error(i, readout_error(physical[i]));
+            out.set_coherence(i, coherence(physical[i]));
+        }
+        return out;
+    }
+
+private:
+    struct GateProperties {
+        double error = 0.0;
+        double duration = 0.0;
+    };
+
+    static uint64_t key(GateKind kind, std::initializer_list<uint32_t> qubits) {
+        Operation op{};
+        op.kind = kind;
+        op.num_qubits = static_cast<uint32_t>(qubits.size());
+        uint32_t i = 0;
+        for (uint32_t q : qubits) {
+            op.qubits[i++] = q;
+        }
+        return key(op);
+    }
+
+    static uint64_t key(const Operation& op) {
+        uint64_t k = static_cast<uint64_t>(op.kind) << 56;
+        k |= static_cast<uint64_t>(op.qubits[0] & 0xffffff) << 24;
+        if (op.num_qubits == 2) {
+            k |= (op.qubits[1] & 0xffffff) + 1;
+        }
+        return k;
+    }
+
+    std::unordered_map<uint64_t, GateProperties> gates_;
+    std::vector<QubitReadoutError> readout_;
+    std::vector<QubitCoherence> coherence_;
+};
+
+namespace detail {
+
+inline double to_seconds(double value, const std::string& unit) {
+    if (unit == "s") {
+        return value;
+    } else if (unit == "ms") {
+        return value * 1e-3;
+    } else if (unit == "us" || unit == "µs") {
+        return value * 1e-6;
+    } else if (unit == "ns") {
+        return value * 1e-9;
+    }
+    return value;
+}
+
+}  // namespace detail
+
+// Merge a backend properties document ({"qubits": [[{name, value, unit}]],
+// "gates": [{gate, qubits, parameters}]}) into `noise`. Entries override
+// what the target provided.
+inline void add_backend_properties(NoiseModel& noise, const nlohmann::json& properties) {
+    if (properties.contains("qubits")) {
+        const auto& qubits = properties["qubits"];
+        for (uint32_t q = 0; q < qubits.size(); q++) {
+            QubitCoherence coherence;
+            QubitReadoutError readout;
+            bool has_readout = false;
+            for (const auto& item : qubits[q]) {
+                std::string name = item.value("name", "");
+                double value = item.value("value", 0.0);
+                std::string unit = item.value("unit", "");
+                if (name == "T1") {
+                    coherence.t1 = detail::to_seconds(value, unit);
+                } else if (name == "T2") {
+                    coherence.t2 = detail::to_seconds(value, unit);
+                } else if (name == "prob_meas1_prep0") {
+                    readout.p01 = value;
+                    has_readout = true;
+                } else if (name == "prob_meas0_prep1") {
+                    readout.p10 = value;
+                    has_readout = true;
+                } else if (name == "readout_error" && !has_readout) {
+                    readout.p01 = readout.p10 = value;
+                    has_readout = true;
+                }
+            }
+            noise.set_coherence(q, coherence);
+            if (has_readout) {
+                noise.set_readout_error(q, readout);
+            }
+        }
+    }
+    if (properties.contains("gates")) {
+        for (const auto& gate : properties["gates"]) {
+            GateKind kind;
+            if (!gate_kind_from_name(gate.value("gate", ""), kind)) {
+                continue;
+            }
+            std::vector<uint32_t> qubits = gate.value("qubits", std::vector<uint32_t>());
+            if (qubits.empty() || qubits.size() > 2) {
+                continue;
+            }
+            for (const auto& param : gate.value("parameters", nlohmann::json::array())) {
+                std::string name = param.value("name", "");
+                double value = param.value("value", 0.0);
+                bool one = qubits.size() == 1;
+                if (name == "gate_error") {
+                    if (one) {
+                        noise.set_gate_error(kind, {qubits[0]}, value);
+                    } else {
+                        noise.set_gate_error(kind, {qubits[0], qubits[1]}, value);
+                    }
+                } else if (name == "gate_length") {
+                    double seconds = detail::to_seconds(value, param.value("unit", ""));
+                    if (one) {
+                        noise.set_gate_duration(kind, {qubits[0]}, seconds);
+                    } else {
+                        noise.set_gate_duration(kind, {qubits[0], qubits[1]}, seconds);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}  // namespace qkx
+
+#endif  // QKX_NOISE_MODEL_HPP
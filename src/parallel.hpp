@@ -0,0 +1,51 @@
+/*
+ * Minimal fork-join helper for the local engines
+ *
+ * Splits [0, n) into one contiguous chunk per thread and runs them on
+ * short-lived std::threads. Work below `grain` items runs inline, so small
+ * problems pay no thread start-up cost.
+ */
+
+#ifndef QKX_PARALLEL_HPP
+#define QKX_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace qkx {
+
+inline unsigned default_num_threads(unsigned requested = 0) {
+    return requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// fn(begin, end, thread_index)
+template <typename Fn>
+void parallel_for(size_t n, unsigned num_threads, size_t grain, Fn&& fn) {
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(num_threads, grain ? n / grain : n));
+    if (threads <= 1) {
+        if (n > 0) {
+            fn(size_t(0), n, 0u);
+        }
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    size_t chunk = (n + threads - 1) / threads;
+    for (unsigned t = 1; t < threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = std::min(n, begin + chunk);
+        if (begin < end) {
+            pool.emplace_back([&fn, begin, end, t]() { fn(begin, end, t); });
+        }
+    }
+    fn(size_t(0), std::min(n, chunk), 0u);
+    for (auto& th : pool) {
+        th.join();
+    }
+}
+
+}  // namespace qkx
+
+#endif  // QKX_PARALLEL_HPP
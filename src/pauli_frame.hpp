@@ -0,0 +1,353 @@
+/*
+ * Pauli-frame noisy sampler
+ *
+ * For a Clifford circuit with Pauli noise, a noisy shot differs from a
+ * noiseless reference shot only by the Pauli frame accumulated along the
+ * way: the errors, pushed through the remaining gates, flip the measured
+ * bits wherever the frame has an X component. Frames are propagated for
+ * 64 shots per machine word, one word array per qubit for X and one for Z,
+ * so each gate is a few AND/XOR passes over contiguous words that the
+ * compiler vectorizes. Errors are placed by geometric skipping, so a gate
+ * costs time proportional to the errors it actually causes.
+ *
+ * Starting every frame with random Z components (which leave |0⟩ alone)
+ * makes the frames also reproduce the intrinsic randomness of the ideal
+ * state, so a single reference shot of the noiseless circuit is enough; it
+ * is drawn with the MPS engine. Gate errors and readout errors come from a
+ * NoiseModel, typically built from the backend target.
+ *
+ * Non-Clifford gates and mid-circuit measurements are rejected.
+ */
+
+#ifndef QKX_PAULI_FRAME_HPP
+#define QKX_PAULI_FRAME_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "local_circuit.hpp"
+#include "mps_simulator.hpp"
+#include "noise_model.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+
+namespace qkx {
+
+struct PauliFrameOptions {
+    size_t batch_words = 16;  // shots per batch / 64; keeps the frames in L1
+    unsigned num_threads = 0; // 0 = hardware concurrency
+    uint64_t seed = 0x50617531;
+};
+
+struct PauliFrameStats {
+    size_t num_gates = 0;
+    size_t num_noisy_gates = 0;
+    double expected_gate_errors = 0.0;  // mean Pauli errors per shot
+};
+
+// Action of a Clifford gate on Paulis, ignoring signs. Generators are
+// numbered x0, z0, x1, z1 and image[i] holds the Pauli that generator i is
+// mapped to, as bits in the same order.
+struct CliffordMap {
+    uint32_t num_qubits = 1;
+    uint8_t image[4] = {1, 2, 4, 8};
+};
+
+namespace detail {
+
+// Pauli with bits (x0, z0, x1, z1) as a matrix on the gate's qubits
+inline std::vector<cplx> pauli_matrix(uint32_t num_qubits, uint32_t bits) {
+    static const cplx single[4][4] = {
+        {1, 0, 0, 1},                         // I
+        {0, 1, 1, 0},                         // X
+        {1, 0, 0, -1},                        // Z
+        {0, cplx(0, -1), cplx(0, 1), 0},      // Y
+    };
+    const size_t d = size_t(1) << num_qubits;
+    std::vector<cplx> m(d * d, 1.0);
+    for (size_t r = 0; r < d; r++) {
+        for (size_t c = 0; c < d; c++) {
+            for (uint32_t q = 0; q < num_qubits; q++) {
+                uint32_t p = (bits >> (2 * q)) & 3;
+                m[r * d + c] *= single[p][((r >> q) & 1) * 2 + ((c >> q) & 1)];
+            }
+        }
+    }
+    return m;
+}
+
+}  // namespace detail
+
+// Symplectic map of a gate from its matrix; throws if it is not Clifford
+inline CliffordMap clifford_map(const Operation& op) {
+    CliffordMap map;
+    map.num_qubits = op.num_qubits;
+    const size_t d = size_t(1) << op.num_qubits;
+    std::vector<cplx> u(d * d);
+    if (op.num_qubits == 1) {
+        Matrix2 m = unitary_1q(op);
+        std::copy(m.begin(), m.end(), u.begin());
+    } else {
+        Matrix4 m = unitary_2q(op);
+        std::copy(m.begin(), m.end(), u.begin());
+    }
+
+    for (uint32_t g = 0; g < 2 * op.num_qubits; g++) {
+        // M = U P U^dagger
+        std::vector<cplx> p = detail::pauli_matrix(op.num_qubits, 1u << g);
+        std::vector<cplx> up(d * d, 0.0), m(d * d, 0.0);
+        for (size_t r = 0; r < d; r++) {
+            for (size_t k = 0; k < d; k++) {
+                for (size_t c = 0; c < d; c++) {
+                    up[r * d + c] += u[r * d + k] * p[k * d + c];
+                }
+            }
+        }
+        for (size_t r = 0; r < d; r++) {
+            for (size_t k = 0; k < d; k++) {
+                for (size_t c = 0; c < d; c++) {
+                    m[r * d + c] += up[r * d + k] * std::conj(u[c * d + k]);
+                }
+            }
+        }
+        bool found = false;
+        for (uint32_t bits = 1; bits < d * d && !found; bits++) {
+            std::vector<cplx> q = detail::pauli_matrix(op.num_qubits, bits);
+            cplx trace = 0.0;
+            for (size_t i = 0; i < d * d; i++) {
+                trace += std::conj(q[i]) * m[i];
+            }
+            if (std::abs(std::abs(trace) - static_cast<double>(d)) < 1e-9) {
+                map.image[g] = static_cast<uint8_t>(bits);
+                found = true;
+            }
+        }
+        if (!found) {
+            throw std::invalid_argument(std::string("Pauli-frame engine needs Clifford gates, got ") +
+                                        gate_name(op.kind));
+        }
+    }
+    return map;
+}
+
+class PauliFrameSimulator {
+public:
+    PauliFrameSimulator(const LocalCircuit& circ, const NoiseModel& noise,
+                        PauliFrameOptions options = PauliFrameOptions())
+        : circ_(circ), options_(options), measured_(terminal_measurements(circ)) {
+        options_.num_threads = default_num_threads(options_.num_threads);
+        options_.batch_words = std::max<size_t>(1, options_.batch_words);
+
+        for (const Operation& op : circ.ops()) {
+            if (!is_unitary(op.kind)) {
+                continue;
+            }
+            Step step;
+            step.op = op;
+            step.map = clifford_map(op);
+            step.error = noise.pauli_error(op);
+            steps_.push_back(step);
+            stats_.num_gates++;
+            if (step.error > 0.0) {
+                stats_.num_noisy_gates++;
+                stats_.expected_gate_errors += step.error;
+            }
+        }
+        for (const auto& m : measured_) {
+            readout_.push_back(noise.readout_error(m.first));
+        }
+
+        // One noiseless shot as the reference the frames are applied to
+        MpsOptions mps;
+        mps.seed = options_.seed ^ 0x726566;
+        mps.num_threads = 1;
+        reference_ = run_mps(circ, 1, mps);
+    }
+
+    const PauliFrameStats& stats() const { return stats_; }
+
+    PackedShots sample(size_t shots) const {
+        PackedShots out(circ_.num_clbits(), shots);
+        const size_t batch_shots = options_.batch_words * 64;
+        const size_t num_batches = (shots + batch_shots - 1) / batch_shots;
+        Xoshiro256 base(options_.seed);
+        parallel_for(num_batches, options_.num_threads, 1, [&](size_t begin, size_t end, unsigned t) {
+            Xoshiro256 rng = base.stream(t);
+            std::vector<uint64_t> x, z;
+            for (size_t b = begin; b < end; b++) {
+                size_t first = b * batch_shots;
+                run_batch(rng, x, z, out, first, std::min(batch_shots, shots - first));
+            }
+        });
+        return out;
+    }
+
+private:
+    struct Step {
+        Operation op;
+        CliffordMap map;
+        double error = 0.0;
+    };
+
+    // Calls fn(shot) for every shot in [0, n) hit by an event of probability p
+    template <typename Fn>
+    static void for_each_event(Xoshiro256& rng, double p, size_t n, Fn&& fn) {
+        if (p <= 0.0) {
+            return;
+        }
+        if (p >= 1.0) {
+            for (size_t s = 0; s < n; s++) {
+                fn(s);
+            }
+            return;
+        }
+        const double inv_log = 1.0 / std::log1p(-p);
+        size_t s = 0;
+        while (true) {
+            double gap = std::floor(std::log(1.0 - rng.uniform()) * inv_log);
+            if (gap >= static_cast<double>(n - s)) {
+                return;
+            }
+            s += static_cast<size_t>(gap);
+            fn(s);
+            s++;
+        }
+    }
+
+    void run_batch(Xoshiro256& rng, std::vector<uint64_t>& x, std::vector<uint64_t>& z,
+                   PackedShots& out, size_t first, size_t n) const {
+        const size_t W = options_.batch_words;
+        const uint32_t nq = circ_.num_qubits();
+        x.assign(nq * W, 0);
+        z.resize(nq * W);
+        for (auto& word : z) {
+            word = rng();
+        }
+
+        for (const Step& step : steps_) {
+            const CliffordMap& map = step.map;
+            const uint32_t q0 = step.op.qubits[0];
+            if (map.num_qubits == 1) {
+                uint64_t* x0 = &x[q0 * W];
+                uint64_t* z0 = &z[q0 * W];
+                const uint64_t m[2][2] = {
+                    {mask(map.image[0], 0), mask(map.image[0], 1)},
+                    {mask(map.image[1], 0), mask(map.image[1], 1)},
+                };
+                for (size_t w = 0; w < W; w++) {
+                    uint64_t a = x0[w], c = z0[w];
+                    x0[w] = (a & m[0][0]) ^ (c & m[1][0]);
+                    z0[w] = (a & m[0][1]) ^ (c & m[1][1]);
+                }
+            } else {
+                const uint32_t q1 = step.op.qubits[1];
+                uint64_t* x0 = &x[q0 * W];
+                uint64_t* z0 = &z[q0 * W];
+                uint64_t* x1 = &x[q1 * W];
+                uint64_t* z1 = &z[q1 * W];
+                uint64_t m[4][4];
+                for (int i = 0; i < 4; i++) {
+                    for (int j = 0; j < 4; j++) {
+                        m[i][j] = mask(map.image[i], j);
+                    }
+                }
+                for (size_t w = 0; w < W; w++) {
+                    const uint64_t in[4] = {x0[w], z0[w], x1[w], z1[w]};
+                    uint64_t o[4] = {0, 0, 0, 0};
+                    for (int i = 0; i < 4; i++) {
+                        for (int j = 0; j < 4; j++) {
+                            o[j] ^= in[i] & m[i][j];
+                        }
+                    }
+                    x0[w] = o[0];
+                    z0[w] = o[1];
+                    x1[w] = o[2];
+                    z1[w] = o[3];
+                }
+            }
+
+            // Depolarizing error: a uniformly random non-identity Pauli
+            const uint32_t num_paulis = map.num_qubits == 1 ? 3 : 15;
+            for_each_event(rng, step.error, n, [&](size_t s) {
+                uint32_t bits = 1 + static_cast<uint32_t>(rng.below(num_paulis));
+                uint64_t bit = 1ULL << (s & 63);
+                size_t w = s >> 6;
+                for (uint32_t k = 0; k < map.num_qubits; k++) {
+                    uint32_t q = step.op.qubits[k];
+                    if (bits & (1u << (2 * k))) {
+                        x[q * W + w] ^= bit;
+                    }
+                    if (bits & (2u << (2 * k))) {
+                        z[q * W + w] ^= bit;
+                    }
+                }
+            });
+        }
+
+        // Outcome = reference XOR frame X component, then readout flips
+        std::vector<uint64_t> bits(W);
+        for (size_t i = 0; i < measured_.size(); i++) {
+            const uint32_t q = measured_[i].first;
+            const uint32_t c = measured_[i].second;
+            const uint64_t ref = reference_.get(0).get(c) ? ~0ULL : 0ULL;
+            for (size_t w = 0; w < W; w++) {
+                bits[w] = ref ^ x[q * W + w];
+            }
+            const QubitReadoutError& e = readout_[i];
+            const double p = std::max(e.p01, e.p10);
+            for_each_event(rng, p, n, [&](size_t s) {
+                uint64_t bit = 1ULL << (s & 63);
+                bool one = bits[s >> 6] & bit;
+                if (rng.uniform() * p < (one ? e.p10 : e.p01)) {
+                    bits[s >> 6] ^= bit;
+                }
+            });
+
+            const size_t word = c >> 6;
+            const uint64_t cbit = 1ULL << (c & 63);
+            for (size_t w = 0; w * 64 < n; w++) {
+                uint64_t v = bits[w];
+                if (n - w * 64 < 64) {
+                    v &= (1ULL << (n - w * 64)) - 1;
+                }
+                while (v) {
+                    int j = ctz64(v);
+                    out.shot(first + w * 64 + j)[word] |= cbit;
+                    v &= v - 1;
+                }
+            }
+        }
+    }
+
+    static uint64_t mask(uint8_t image, int bit) {
+        return ((image >> bit) & 1) ? ~0ULL : 0ULL;
+    }
+
+    const LocalCircuit& circ_;
+    PauliFrameOptions options_;
+    std::vector<std::pair<uint32_t, uint32_t>> measured_;
+    std::vector<Step> steps_;
+    std::vector<QubitReadoutError> readout_;
+    PackedShots reference_;
+    PauliFrameStats stats_;
+};
+
+// Noisy shots of a Clifford circuit under `noise`
+inline PackedShots run_pauli_frame(const LocalCircuit& circ, size_t shots, const NoiseModel& noise,
+                                   PauliFrameOptions options = PauliFrameOptions(),
+                                   PauliFrameStats* stats = nullptr) {
+    PauliFrameSimulator sim(circ, noise, options);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return sim.sample(shots);
+}
+
+}  // namespace qkx
+
+#endif  // QKX_PAULI_FRAME_HPP
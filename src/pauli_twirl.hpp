@@ -0,0 +1,215 @@
+/*
+ * Pauli twirling of transpiled circuits
+ *
+ * Conjugating every two-qubit gate G by a random Pauli P before it and the
+ * Pauli G P G† after it leaves the ideal circuit unchanged but turns the
+ * gate's coherent errors into Pauli noise, averaged over many randomized
+ * instances. The same applies to readout: an X before a measurement with
+ * probability 1/2, undone by flipping the recorded bit, makes the readout
+ * error symmetric between 0 and 1.
+ *
+ * The twirl is applied to the transpiled circuit, so the instances need no
+ * further transpilation: Paulis are emitted as x and rz(π), which are in
+ * every IBM basis, and an rz(π) next to an rz on the same qubit is folded
+ * into its angle instead of adding a gate. G P G† comes from the gate's
+ * Clifford map (pauli_frame.hpp), up to a global phase. Instances draw from
+ * their own seeded streams, so they are generated in parallel and the set
+ * depends only on the seed.
+ *
+ * TwirledCircuit::flips holds the clbits whose readout was inverted;
+ * untwirl() XORs them back into the shots of that instance. Readout
+ * mitigation of twirled shots must use twirled_readout_errors(): after the
+ * untwirl each bit sees p01 and p10 equally often.
+ */
+
+#ifndef QKX_PAULI_TWIRL_HPP
+#define QKX_PAULI_TWIRL_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "bitstring.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+#include "pauli_frame.hpp"
+#include "random.hpp"
+#include "readout_mitigation.hpp"
+
+namespace qkx {
+
+struct TwirlOptions {
+    bool gates = true;         // twirl two-qubit gates
+    bool measurements = true;  // randomize readout with X before measurement
+    uint64_t seed = 0x54776972;
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+};
+
+struct TwirledCircuit {
+    LocalCircuit circuit;
+    Bitstring flips;  // clbits to invert in this instance's shots
+};
+
+class PauliTwirler {
+public:
+    explicit PauliTwirler(const LocalCircuit& circ, TwirlOptions options = TwirlOptions())
+        : circ_(circ), options_(options), reused_(circ.size(), 0) {
+        // Measurements whose qubit is acted on later; the readout X is undone
+        // after them so the qubit continues in the measured state
+        std::vector<char> used(circ.num_qubits(), 0);
+        for (size_t i = circ.size(); i-- > 0;) {
+            const Operation& op = circ.ops()[i];
+            if (op.kind == GateKind::Measure) {
+                reused_[i] = used[op.qubits[0]];
+            }
+            if (op.kind != GateKind::Barrier) {
+                for (uint32_t k = 0; k < op.num_qubits; k++) {
+                    used[op.qubits[k]] = 1;
+                }
+            }
+        }
+        for (const Operation& op : circ.ops()) {
+            if (is_two_qubit(op.kind)) {
+                num_two_qubit_++;
+                CliffordMap& map = maps_[static_cast<size_t>(op.kind) - static_cast<size_t>(GateKind::CX)];
+                map = clifford_map(op);
+            } else if (op.kind == GateKind::Measure) {
+                num_measure_++;
+            }
+        }
+    }
+
+    // Instance `index` of the set; the same index always gives the same circuit
+    TwirledCircuit instance(uint64_t index) const {
+        Xoshiro256 rng(options_.seed ^ (0xD1B54A32D192ED03ULL * (index + 1)));
+        uint64_t random = 0;
+        uint32_t random_bits = 0;
+        auto draw = [&](uint32_t bits) {
+            if (random_bits < bits) {
+                random = rng();
+                random_bits = 64;
+            }
+            uint32_t value = static_cast<uint32_t>(random & ((1u << bits) - 1));
+            random >>= bits;
+            random_bits -= bits;
+            return value;
+        };
+
+        TwirledCircuit out{LocalCircuit(circ_.num_qubits(), circ_.num_clbits()), Bitstring(circ_.num_clbits())};
+        std::vector<Operation>& ops = out.circuit.ops();
+        ops.reserve(circ_.size() + 4 * num_two_qubit_ + 2 * num_measure_);
+        // Index in ops of the last instruction on each qubit, if it is an rz
+        std::vector<size_t> last_rz(circ_.num_qubits(), SIZE_MAX);
+
+        auto emit = [&](const Operation& op) {
+            if (op.kind == GateKind::RZ && last_rz[op.qubits[0]] != SIZE_MAX) {
+                ops[last_rz[op.qubits[0]]].params[0] += op.params[0];
+                return;
+            }
+            for (uint32_t i = 0; i < op.num_qubits; i++) {
+                last_rz[op.qubits[i]] = op.kind == GateKind::RZ ? ops.size() : SIZE_MAX;
+            }
+            if (op.kind == GateKind::Barrier && op.num_qubits == 0) {
+                std::fill(last_rz.begin(), last_rz.end(), SIZE_MAX);
+            }
+            ops.push_back(op);
+        };
+        // Pauli with bits (x, z) on qubit q: Z first, then X
+        auto pauli = [&](uint32_t bits, uint32_t q) {
+            Operation op{};
+            op.num_qubits = 1;
+            op.qubits[0] = q;
+            if (bits & 2) {
+                op.kind = GateKind::RZ;
+                op.params[0] = kPi;
+                emit(op);
+            }
+            if (bits & 1) {
+                op.kind = GateKind::X;
+                op.params[0] = 0.0;
+                emit(op);
+            }
+        };
+
+        for (size_t i = 0; i < circ_.size(); i++) {
+            const Operation& op = circ_.ops()[i];
+            if (options_.gates && is_two_qubit(op.kind)) {
+                const CliffordMap& map = maps_[static_cast<size_t>(op.kind) - static_cast<size_t>(GateKind::CX)];
+                uint32_t before = draw(4);
+                uint32_t after = 0;
+                for (uint32_t g = 0; g < 4; g++) {
+                    if ((before >> g) & 1) {
+                        after ^= map.image[g];
+                    }
+                }
+                pauli(before & 3, op.qubits[0]);
+                pauli(before >> 2, op.qubits[1]);
+                emit(op);
+                pauli(after & 3, op.qubits[0]);
+                pauli(after >> 2, op.qubits[1]);
+            } else if (options_.measurements && op.kind == GateKind::Measure) {
+                bool flip = draw(1);
+                if (flip) {
+                    pauli(1, op.qubits[0]);
+                }
+                out.flips.set(op.clbit, flip);
+                emit(op);
+                if (flip && reused_[i]) {
+                    pauli(1, op.qubits[0]);
+                }
+            } else {
+                emit(op);
+            }
+        }
+        return out;
+    }
+
+    // Instances 0..count-1
+    std::vector<TwirledCircuit> generate(size_t count) const {
+        std::vector<TwirledCircuit> out(count);
+        parallel_for(count, default_num_threads(options_.num_threads), 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) {
+                out[i] = instance(i);
+            }
+        });
+        return out;
+    }
+
+private:
+    const LocalCircuit& circ_;
+    TwirlOptions options_;
+    std::vector<char> reused_;
+    std::array<CliffordMap, 5> maps_{};  // CX, CY, CZ, ECR, Swap
+    size_t num_two_qubit_ = 0;
+    size_t num_measure_ = 0;
+};
+
+// Undoes the readout randomization of one instance in its shots
+inline void untwirl(PackedShots& shots, const Bitstring& flips) {
+    if (shots.num_bits() != flips.num_bits()) {
+        throw std::invalid_argument("shots and twirl flips have different widths");
+    }
+    const uint32_t words = shots.words_per_shot();
+    for (size_t s = 0; s < shots.num_shots(); s++) {
+        uint64_t* shot = shots.shot(s);
+        for (uint32_t w = 0; w < words; w++) {
+            shot[w] ^= flips.data()[w];
+        }
+    }
+}
+
+// Readout error rates seen by untwirled shots of randomized measurements:
+// both directions become the mean of the calibrated p01 and p10
+inline std::vector<QubitReadoutError> twirled_readout_errors(std::vector<QubitReadoutError> errors) {
+    for (QubitReadoutError& e : errors) {
+        e.p01 = e.p10 = 0.5 * (e.p01 + e.p10);
+    }
+    return errors;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_PAULI_TWIRL_HPP
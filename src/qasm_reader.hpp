@@ -0,0 +1,1076 @@
+/*
+ * OpenQASM 3 reader
+ *
+ * Reads the subset of OpenQASM 3 (and OpenQASM 2) that circuit exporters
+ * emit: qubit/bit (and qreg/creg) declarations, physical qubits ($n), gate
+ * definitions, standard gate calls with constant parameter expressions,
+ * register broadcasting, measure, reset and barrier. Classical control,
+ * gate modifiers and inputs are rejected with the line number.
+ *
+ * A hand-written lexer works on the file buffer in place; the parser builds
+ * a flat statement list whose names are views into that buffer and whose
+ * expressions and operand lists live in a bump arena, so a statement costs
+ * no individual heap allocation. lower_qasm() then expands gate definitions
+ * and broadcasts into a LocalCircuit, failing once the expansion passes a
+ * cap on the number of operations, which to_quantum_circuit()
+ * (qiskit_bridge.hpp) turns into a QuantumCircuit for submission.
+ * read_qasm_files() parses many files on a thread pool.
+ *
+ * Calls to gates the local engines know (h, cx, rz, sx, ecr, ...) use the
+ * native gate even when the file also defines it, as Qiskit exports do for
+ * ecr and sxdg; barriers are dropped, as in from_qk_circuit(). The other
+ * gates of stdgates.inc and qelib1.inc (cp, crz, ch, cu, ccx, cswap, rzz,
+ * ...) are expanded into native gates from built-in definitions, which a
+ * definition in the file overrides.
+ */
+
+#ifndef QKX_QASM_READER_HPP
+#define QKX_QASM_READER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+
+namespace qkx {
+
+// Bump allocator for trivially destructible AST nodes
+class QasmArena {
+public:
+    template <typename T>
+    T* allocate(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena nodes are never destroyed");
+        size_t bytes = (n * sizeof(T) + 15) & ~size_t(15);
+        if (bytes > left_) {
+            size_t block = std::max(bytes, kBlockBytes);
+            blocks_.emplace_back(new char[block]);
+            next_ = blocks_.back().get();
+            left_ = block;
+        }
+        T* out = reinterpret_cast<T*>(next_);
+        next_ += bytes;
+        left_ -= bytes;
+        return out;
+    }
+
+    template <typename T>
+    T* copy(const std::vector<T>& items) {
+        T* out = allocate<T>(items.size());
+        std::copy(items.begin(), items.end(), out);
+        return out;
+    }
+
+private:
+    static constexpr size_t kBlockBytes = 64 * 1024;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* next_ = nullptr;
+    size_t left_ = 0;
+};
+
+struct QasmExpr {
+    enum class Op : uint8_t { Number, Param, Neg, Add, Sub, Mul, Div, Pow, Call };
+    Op op;
+    uint8_t function;  // Call: index into kQasmFunctions
+    uint32_t param;    // Param: index of the enclosing gate's parameter
+    double value;      // Number
+    const QasmExpr* lhs;
+    const QasmExpr* rhs;
+};
+
+struct QasmOperand {
+    std::string_view name;  // register, or gate argument in a definition
+    int64_t index;          // -1 for the whole register
+    bool physical;          // $index
+};
+
+struct QasmStatement {
+    enum class Kind : uint8_t { Gate, Measure, Reset };
+    Kind kind;
+    uint32_t line;
+    uint32_t num_params;
+    uint32_t num_operands;
+    std::string_view name;
+    const QasmExpr* const* params;
+    const QasmOperand* operands;
+    QasmOperand target;  // Measure: the bits written
+};
+
+struct QasmGateDef {
+    std::string_view name;
+    uint32_t num_params;
+    uint32_t num_qubits;
+    uint32_t body_size;
+    const std::string_view* qubits;
+    const QasmStatement* body;
+};
+
+struct QasmRegister {
+    std::string_view name;
+    uint32_t offset;
+    uint32_t size;
+    bool single;  // `qubit a;` rather than `qubit[1] a;`
+};
+
+// Parsed program; names point into `source`
+struct QasmProgram {
+    std::string file;
+    std::vector<char> source;
+    QasmArena arena;
+    std::vector<QasmRegister> qubit_registers;
+    std::vector<QasmRegister> bit_registers;
+    uint32_t num_qubits = 0;
+    uint32_t num_clbits = 0;
+    uint32_t num_physical = 0;  // highest $n + 1
+    std::vector<QasmGateDef> gates;
+    std::vector<QasmStatement> statements;
+};
+
+namespace detail {
+
+struct QasmFunction {
+    const char* name;
+    double (*fn)(double);
+};
+
+inline const QasmFunction kQasmFunctions[] = {
+    {"sin", [](double x) { return std::sin(x); }},     {"cos", [](double x) { return std::cos(x); }},
+    {"tan", [](double x) { return std::tan(x); }},     {"arcsin", [](double x) { return std::asin(x); }},
+    {"arccos", [](double x) { return std::acos(x); }}, {"arctan", [](double x) { return std::atan(x); }},
+    {"exp", [](double x) { return std::exp(x); }},     {"ln", [](double x) { return std::log(x); }},
+    {"sqrt", [](double x) { return std::sqrt(x); }},
+};
+
+struct QasmToken {
+    enum class Kind : uint8_t { End, Identifier, Integer, Real, String, Arrow, Power, Symbol };
+    Kind kind = Kind::End;
+    char symbol = 0;
+    uint32_t line = 1;
+    std::string_view text;
+    double value = 0.0;
+    int64_t integer = 0;
+};
+
+// Character classes: bit 0 starts an identifier, bit 1 continues one,
+// bit 2 is a digit
+struct QasmCharClasses {
+    uint8_t bits[256] = {};
+    constexpr QasmCharClasses() {
+        for (int c = 0; c < 256; c++) {
+            bool start = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || c >= 0x80;
+            bool digit = c >= '0' && c <= '9';
+            bits[c] = static_cast<uint8_t>((start ? 3 : 0) | (digit ? 6 : 0));
+        }
+    }
+};
+
+inline constexpr QasmCharClasses kQasmChars{};
+
+inline bool identifier_start(unsigned char c) { return kQasmChars.bits[c] & 1; }
+inline bool identifier_char(unsigned char c) { return kQasmChars.bits[c] & 2; }
+inline bool is_digit(unsigned char c) { return kQasmChars.bits[c] & 4; }
+
+class QasmLexer {
+public:
+    QasmLexer(const char* begin, const char* end, const std::string& file)
+        : p_(begin), end_(end), file_(file) {}
+
+    [[noreturn]] void fail(uint32_t line, const std::string& message) const {
+        throw std::invalid_argument(file_ + ":" + std::to_string(line) + ": " + message);
+    }
+
+    QasmToken next() {
+        skip_space();
+        QasmToken t;
+        t.line = line_;
+        if (p_ >= end_) {
+            return t;
+        }
+        const char* start = p_;
+        unsigned char c = static_cast<unsigned char>(*p_);
+        if (identifier_start(c)) {
+            while (p_ < end_ && identifier_char(static_cast<unsigned char>(*p_))) {
+                p_++;
+            }
+            t.kind = QasmToken::Kind::Identifier;
+        } else if (is_digit(c) || (c == '.' && p_ + 1 < end_ && is_digit(p_[1]))) {
+            // Integers are accumulated here; reals go to from_chars
+            bool real = false;
+            uint64_t integer = 0;
+            while (p_ < end_ && is_digit(*p_) && integer < (1ULL << 56)) {
+                integer = integer * 10 + static_cast<uint64_t>(*p_++ - '0');
+            }
+            while (p_ < end_ && (is_digit(*p_) || *p_ == '.')) {
+                real = true;
+                p_++;
+            }
+            if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+                real = true;
+                p_++;
+                if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+                    p_++;
+                }
+                while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                    p_++;
+                }
+            }
+            if (real) {
+                t.kind = QasmToken::Kind::Real;
+                auto parsed = std::from_chars(start, p_, t.value);
+                if (parsed.ec == std::errc::result_out_of_range) {
+                    fail(line_, "number out of range '" + std::string(start, p_) + "'");
+                }
+                if (parsed.ec != std::errc() || parsed.ptr != p_) {
+                    fail(line_, "malformed number '" + std::string(start, p_) + "'");
+                }
+            } else {
+                t.kind = QasmToken::Kind::Integer;
+                t.integer = static_cast<int64_t>(integer);
+                t.value = static_cast<double>(integer);
+            }
+        } else if (c == '"') {
+            const char* close = static_cast<const char*>(std::memchr(p_ + 1, '"', end_ - p_ - 1));
+            if (!close) {
+                fail(line_, "unterminated string");
+            }
+            t.kind = QasmToken::Kind::String;
+            t.text = std::string_view(p_ + 1, close - p_ - 1);
+            p_ = close + 1;
+            return t;
+        } else if (c == '-' && p_ + 1 < end_ && p_[1] == '>') {
+            p_ += 2;
+            t.kind = QasmToken::Kind::Arrow;
+        } else if (c == '*' && p_ + 1 < end_ && p_[1] == '*') {
+            p_ += 2;
+            t.kind = QasmToken::Kind::Power;
+        } else {
+            p_++;
+            t.kind = c == '^' ? QasmToken::Kind::Power : QasmToken::Kind::Symbol;
+            t.symbol = static_cast<char>(c);
+        }
+        t.text = std::string_view(start, p_ - start);
+        return t;
+    }
+
+private:
+    void skip_space() {
+        while (p_ < end_) {
+            char c = *p_;
+            if (c == '\n') {
+                line_++;
+                p_++;
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                p_++;
+            } else if (c == '/' && p_ + 1 < end_ && p_[1] == '/') {
+                while (p_ < end_ && *p_ != '\n') {
+                    p_++;
+                }
+            } else if (c == '/' && p_ + 1 < end_ && p_[1] == '*') {
+                p_ += 2;
+                while (p_ + 1 < end_ && !(p_[0] == '*' && p_[1] == '/')) {
+                    line_ += *p_ == '\n';
+                    p_++;
+                }
+                p_ = std::min(end_, p_ + 2);
+            } else {
+                break;
+            }
+        }
+    }
+
+    const char* p_;
+    const char* end_;
+    const std::string& file_;
+    uint32_t line_ = 1;
+};
+
+class QasmParser {
+public:
+    explicit QasmParser(QasmProgram& prog)
+        : prog_(prog), lexer_(prog.source.data(), prog.source.data() + prog.source.size(), prog.file) {
+        advance();
+    }
+
+    void parse() {
+        // Exported programs average over 16 bytes per statement
+        prog_.statements.reserve(prog_.statements.size() + prog_.source.size() / 16);
+        while (tok_.kind != QasmToken::Kind::End) {
+            statement();
+        }
+    }
+
+private:
+    using Kind = QasmToken::Kind;
+
+    void advance() { tok_ = lexer_.next(); }
+
+    [[noreturn]] void fail(const std::string& message) const { lexer_.fail(tok_.line, message); }
+
+    bool is_symbol(char c) const { return tok_.kind == Kind::Symbol && tok_.symbol == c; }
+    bool is_word(std::string_view w) const { return tok_.kind == Kind::Identifier && tok_.text == w; }
+
+    void expect(char c) {
+        if (!is_symbol(c)) {
+            fail(std::string("expected '") + c + "' before '" + std::string(tok_.text) + "'");
+        }
+        advance();
+    }
+
+    std::string_view identifier() {
+        if (tok_.kind != Kind::Identifier) {
+            fail("expected an identifier before '" + std::string(tok_.text) + "'");
+        }
+        std::string_view name = tok_.text;
+        advance();
+        return name;
+    }
+
+    int64_t integer() {
+        if (tok_.kind != Kind::Integer) {
+            fail("expected an integer before '" + std::string(tok_.text) + "'");
+        }
+        int64_t v = tok_.integer;
+        advance();
+        return v;
+    }
+
+    void skip_to_semicolon() {
+        while (tok_.kind != Kind::End && !is_symbol(';')) {
+            advance();
+        }
+        expect(';');
+    }
+
+    void statement() {
+        if (tok_.kind != Kind::Identifier) {
+            fail("unexpected '" + std::string(tok_.text) + "'");
+        }
+        std::string_view word = tok_.text;
+        if (word == "OPENQASM" || word == "barrier") {
+            skip_to_semicolon();
+        } else if (word == "include") {
+            advance();
+            if (tok_.kind != Kind::String) {
+                fail("expected a file name after include");
+            }
+            if (tok_.text != "stdgates.inc" && tok_.text != "qelib1.inc") {
+                fail("cannot include '" + std::string(tok_.text) + "'");
+            }
+            advance();
+            expect(';');
+        } else if (word == "qubit" || word == "bit") {
+            advance();
+            uint32_t size = 1;
+            bool single = !is_symbol('[');
+            if (!single) {
+                advance();
+                size = declared_size();
+                expect(']');
+            }
+            declare(word == "qubit", identifier(), size, single);
+            expect(';');
+        } else if (word == "qreg" || word == "creg") {
+            advance();
+            std::string_view name = identifier();
+            expect('[');
+            uint32_t size = declared_size();
+            expect(']');
+            declare(word == "qreg", name, size, false);
+            expect(';');
+        } else if (word == "gate") {
+            gate_definition();
+        } else if (word == "measure") {
+            advance();
+            QasmStatement s = make(QasmStatement::Kind::Measure);
+            s.operands = operands(s.num_operands, 1);
+            if (tok_.kind != Kind::Arrow) {
+                fail("measurement results must be stored");
+            }
+            advance();
+            s.target = operand();
+            expect(';');
+            body_ ? body_->push_back(s) : prog_.statements.push_back(s);
+        } else if (word == "reset") {
+            advance();
+            QasmStatement s = make(QasmStatement::Kind::Reset);
+            s.operands = operands(s.num_operands, 1);
+            expect(';');
+            body_ ? body_->push_back(s) : prog_.statements.push_back(s);
+        } else if (word == "input" || word == "output" || word == "if" || word == "for" || word == "while" ||
+                   word == "ctrl" || word == "negctrl" || word == "inv" || word == "pow" || word == "def" ||
+                   word == "delay" || word == "box" || word == "let" || word == "const") {
+            fail("unsupported statement '" + std::string(word) + "'");
+        } else {
+            call_or_assignment();
+        }
+    }
+
+    uint32_t declared_size() {
+        int64_t size = integer();
+        if (size < 1 || size > (1 << 24)) {
+            fail("register size out of range");
+        }
+        return static_cast<uint32_t>(size);
+    }
+
+    void declare(bool quantum, std::string_view name, uint32_t size, bool single) {
+        if (body_) {
+            fail("declaration inside a gate definition");
+        }
+        auto& regs = quantum ? prog_.qubit_registers : prog_.bit_registers;
+        uint32_t& total = quantum ? prog_.num_qubits : prog_.num_clbits;
+        for (const QasmRegister& r : regs) {
+            if (r.name == name) {
+                fail("register '" + std::string(name) + "' declared twice");
+            }
+        }
+        regs.push_back({name, total, size, single});
+        total += size;
+    }
+
+    QasmStatement make(QasmStatement::Kind kind) {
+        QasmStatement s{};
+        s.kind = kind;
+        s.line = tok_.line;
+        return s;
+    }
+
+    QasmOperand operand() {
+        QasmOperand o{};
+        o.index = -1;
+        o.name = identifier();
+        if (o.name[0] == '$') {
+            int64_t index = 0;
+            for (size_t i = 1; i < o.name.size(); i++) {
+                if (!is_digit(o.name[i]) || index >= (1 << 24)) {
+                    fail("bad physical qubit '" + std::string(o.name) + "'");
+                }
+                index = index * 10 + (o.name[i] - '0');
+            }
+            if (o.name.size() < 2 || index >= (1 << 24)) {
+                fail("bad physical qubit '" + std::string(o.name) + "'");
+            }
+            o.physical = true;
+            o.index = index;
+            prog_.num_physical = std::max(prog_.num_physical, static_cast<uint32_t>(index + 1));
+        } else if (is_symbol('[')) {
+            advance();
+            o.index = integer();
+            expect(']');
+        }
+        return o;
+    }
+
+    // Comma-separated operands up to ';' or '->'
+    const QasmOperand* operands(uint32_t& count, uint32_t min_count) {
+        scratch_operands_.clear();
+        while (tok_.kind == Kind::Identifier) {
+            scratch_operands_.push_back(operand());
+            if (!is_symbol(',')) {
+                break;
+            }
+            advance();
+        }
+        if (scratch_operands_.size() < min_count) {
+            fail("missing operands");
+        }
+        count = static_cast<uint32_t>(scratch_operands_.size());
+        return prog_.arena.copy(scratch_operands_);
+    }
+
+    void call_or_assignment() {
+        QasmStatement s = make(QasmStatement::Kind::Gate);
+        std::string_view name = identifier();
+        if (is_symbol('[') || is_symbol('=')) {
+            // bits = measure qubits;
+            QasmOperand target{name, -1, false};
+            if (is_symbol('[')) {
+                advance();
+                target.index = integer();
+                expect(']');
+            }
+            expect('=');
+            if (!is_word("measure")) {
+                fail("only measurement results can be assigned");
+            }
+            advance();
+            s.kind = QasmStatement::Kind::Measure;
+            s.target = target;
+            s.operands = operands(s.num_operands, 1);
+            expect(';');
+        } else {
+            s.name = name;
+            if (is_symbol('(')) {
+                advance();
+                scratch_params_.clear();
+                while (!is_symbol(')')) {
+                    scratch_params_.push_back(expression());
+                    if (!is_symbol(',')) {
+                        break;
+                    }
+                    advance();
+                }
+                expect(')');
+                s.num_params = static_cast<uint32_t>(scratch_params_.size());
+                s.params = prog_.arena.copy(scratch_params_);
+            }
+            if (is_symbol('@')) {
+                fail("gate modifiers are not supported");
+            }
+            s.operands = operands(s.num_operands, 1);
+            expect(';');
+        }
+        body_ ? body_->push_back(s) : prog_.statements.push_back(s);
+    }
+
+    void gate_definition() {
+        if (body_) {
+            fail("nested gate definition");
+        }
+        advance();
+        QasmGateDef def{};
+        def.name = identifier();
+        params_.clear();
+        if (is_symbol('(')) {
+            advance();
+            while (tok_.kind == Kind::Identifier) {
+                params_.push_back(identifier());
+                if (!is_symbol(',')) {
+                    break;
+                }
+                advance();
+            }
+            expect(')');
+        }
+        std::vector<std::string_view> qubits;
+        while (tok_.kind == Kind::Identifier) {
+            qubits.push_back(identifier());
+            if (!is_symbol(',')) {
+                break;
+            }
+            advance();
+        }
+        if (qubits.empty()) {
+            fail("gate '" + std::string(def.name) + "' has no qubits");
+        }
+        expect('{');
+        std::vector<QasmStatement> body;
+        body_ = &body;
+        while (!is_symbol('}')) {
+            if (tok_.kind == Kind::End) {
+                fail("unterminated gate definition");
+            }
+            if (is_word("barrier")) {
+                skip_to_semicolon();
+            } else {
+                call_or_assignment();
+            }
+        }
+        body_ = nullptr;
+        advance();
+        for (const QasmStatement& s : body) {
+            if (s.kind != QasmStatement::Kind::Gate) {
+                lexer_.fail(s.line, "only gate calls are allowed in a gate definition");
+            }
+            for (uint32_t i = 0; i < s.num_operands; i++) {
+                const QasmOperand& o = s.operands[i];
+                if (o.index != -1 || std::find(qubits.begin(), qubits.end(), o.name) == qubits.end()) {
+                    lexer_.fail(s.line, "'" + std::string(o.name) + "' is not an argument of " + std::string(def.name));
+                }
+            }
+        }
+        def.num_params = static_cast<uint32_t>(params_.size());
+        def.num_qubits = static_cast<uint32_t>(qubits.size());
+        def.qubits = prog_.arena.copy(qubits);
+        def.body_size = static_cast<uint32_t>(body.size());
+        def.body = prog_.arena.copy(body);
+        params_.clear();
+        prog_.gates.push_back(def);
+    }
+
+    QasmExpr* node(QasmExpr::Op op, const QasmExpr* lhs = nullptr, const QasmExpr* rhs = nullptr) {
+        QasmExpr* e = prog_.arena.allocate<QasmExpr>(1);
+        *e = QasmExpr{op, 0, 0, 0.0, lhs, rhs};
+        return e;
+    }
+
+    // expression := term (('+' | '-') term)*
+    const QasmExpr* expression() {
+        const QasmExpr* e = term();
+        while (is_symbol('+') || is_symbol('-')) {
+            QasmExpr::Op op = is_symbol('+') ? QasmExpr::Op::Add : QasmExpr::Op::Sub;
+            advance();
+            e = node(op, e, term());
+        }
+        return e;
+    }
+
+    // term := unary (('*' | '/') unary)*
+    const QasmExpr* term() {
+        const QasmExpr* e = unary();
+        while (is_symbol('*') || is_symbol('/')) {
+            QasmExpr::Op op = is_symbol('*') ? QasmExpr::Op::Mul : QasmExpr::Op::Div;
+            advance();
+            e = node(op, e, unary());
+        }
+        return e;
+    }
+
+    // unary := '-' unary | power
+    const QasmExpr* unary() {
+        if (is_symbol('-')) {
+            advance();
+            return node(QasmExpr::Op::Neg, unary());
+        }
+        if (is_symbol('+')) {
+            advance();
+            return unary();
+        }
+        return power();
+    }
+
+    // power := primary (('**' | '^') unary)?
+    const QasmExpr* power() {
+        const QasmExpr* e = primary();
+        if (tok_.kind == Kind::Power) {
+            advance();
+            e = node(QasmExpr::Op::Pow, e, unary());
+        }
+        return e;
+    }
+
+    const QasmExpr* primary() {
+        if (tok_.kind == Kind::Integer || tok_.kind == Kind::Real) {
+            QasmExpr* e = node(QasmExpr::Op::Number);
+            e->value = tok_.value;
+            advance();
+            return e;
+        }
+        if (is_symbol('(')) {
+            advance();
+            const QasmExpr* e = expression();
+            expect(')');
+            return e;
+        }
+        std::string_view name = identifier();
+        QasmExpr* e = node(QasmExpr::Op::Number);
+        if (name == "pi" || name == "π") {
+            e->value = kPi;
+        } else if (name == "tau" || name == "τ") {
+            e->value = 2 * kPi;
+        } else if (name == "euler" || name == "ℇ") {
+            e->value = M_E;
+        } else {
+            for (uint32_t i = 0; i < params_.size(); i++) {
+                if (params_[i] == name) {
+                    e->op = QasmExpr::Op::Param;
+                    e->param = i;
+                    return e;
+                }
+            }
+            for (uint8_t f = 0; f < sizeof(kQasmFunctions) / sizeof(kQasmFunctions[0]); f++) {
+                if (name == kQasmFunctions[f].name) {
+                    expect('(');
+                    e->op = QasmExpr::Op::Call;
+                    e->function = f;
+                    e->lhs = expression();
+                    expect(')');
+                    return e;
+                }
+            }
+            fail("unknown identifier '" + std::string(name) + "' in expression");
+        }
+        return e;
+    }
+
+    QasmProgram& prog_;
+    QasmLexer lexer_;
+    QasmToken tok_;
+    std::vector<QasmStatement>* body_ = nullptr;  // inside a gate definition
+    std::vector<std::string_view> params_;       // of the gate being defined
+    std::vector<QasmOperand> scratch_operands_;
+    std::vector<const QasmExpr*> scratch_params_;
+};
+
+inline double evaluate(const QasmExpr* e, const double* args) {
+    switch (e->op) {
+        case QasmExpr::Op::Number: return e->value;
+        case QasmExpr::Op::Param: return args[e->param];
+        case QasmExpr::Op::Neg: return -evaluate(e->lhs, args);
+        case QasmExpr::Op::Add: return evaluate(e->lhs, args) + evaluate(e->rhs, args);
+        case QasmExpr::Op::Sub: return evaluate(e->lhs, args) - evaluate(e->rhs, args);
+        case QasmExpr::Op::Mul: return evaluate(e->lhs, args) * evaluate(e->rhs, args);
+        case QasmExpr::Op::Div: return evaluate(e->lhs, args) / evaluate(e->rhs, args);
+        case QasmExpr::Op::Pow: return std::pow(evaluate(e->lhs, args), evaluate(e->rhs, args));
+        case QasmExpr::Op::Call: return kQasmFunctions[e->function].fn(evaluate(e->lhs, args));
+    }
+    return 0.0;
+}
+
+// Up to eight bytes of `name` packed into an integer; 0 if it is longer
+inline uint64_t pack_name(std::string_view name) {
+    if (name.size() > 8) {
+        return 0;
+    }
+    uint64_t key = 0;
+    std::memcpy(&key, name.data(), name.size());
+    return key;
+}
+
+// Gate names the local engines implement, with the aliases of stdgates.inc.
+// Names are compared as packed integers: this runs once per gate.
+inline bool native_gate(std::string_view name, GateKind& kind) {
+    struct Entry {
+        uint64_t key;
+        GateKind kind;
+    };
+    static const std::vector<Entry> table = []() {
+        std::vector<Entry> t;
+        for (int k = 0; k < static_cast<int>(GateKind::Measure); k++) {
+            t.push_back({pack_name(gate_name(static_cast<GateKind>(k))), static_cast<GateKind>(k)});
+        }
+        for (auto alias : {std::make_pair("U", GateKind::U), std::make_pair("u3", GateKind::U),
+                           std::make_pair("CX", GateKind::CX), std::make_pair("cnot", GateKind::CX),
+                           std::make_pair("u1", GateKind::P), std::make_pair("phase", GateKind::P)}) {
+            t.push_back({pack_name(alias.first), alias.second});
+        }
+        return t;
+    }();
+    uint64_t key = pack_name(name);
+    for (const Entry& e : table) {
+        if (e.key == key && key != 0) {
+            kind = e.kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Gates of stdgates.inc and qelib1.inc outside the native set, in terms of
+// native gates (up to global phase, as in the include files)
+constexpr const char* kStandardGateDefinitions = R"(OPENQASM 3.0;
+gate cp(l) a, b { p(l/2) a; cx a, b; p(-l/2) b; cx a, b; p(l/2) b; }
+gate cphase(l) a, b { cp(l) a, b; }
+gate cu1(l) a, b { cp(l) a, b; }
+gate crx(t) a, b { p(pi/2) b; cx a, b; U(-t/2, 0, 0) b; cx a, b; U(t/2, -pi/2, 0) b; }
+gate cry(t) a, b { ry(t/2) b; cx a, b; ry(-t/2) b; cx a, b; }
+gate crz(t) a, b { rz(t/2) b; cx a, b; rz(-t/2) b; cx a, b; }
+gate ch a, b { s b; h b; t b; cx a, b; tdg b; h b; sdg b; }
+gate csx a, b { h b; cp(pi/2) a, b; h b; }
+gate cu3(t, f, l) c, q {
+  p((l+f)/2) c; p((l-f)/2) q; cx c, q; U(-t/2, 0, -(f+l)/2) q; cx c, q; U(t/2, f, 0) q;
+}
+gate cu(t, f, l, g) c, q { p(g) c; cu3(t, f, l) c, q; }
+gate rxx(t) a, b { h a; h b; cx a, b; rz(t) b; cx a, b; h a; h b; }
+gate ryy(t) a, b { rx(pi/2) a; rx(pi/2) b; cx a, b; rz(t) b; cx a, b; rx(-pi/2) a; rx(-pi/2) b; }
+gate rzz(t) a, b { cx a, b; rz(t) b; cx a, b; }
+gate rzx(t) a, b { h b; cx a, b; rz(t) b; cx a, b; h b; }
+gate dcx a, b { cx a, b; cx b, a; }
+gate iswap a, b { s a; s b; h a; cx a, b; cx b, a; h b; }
+gate ccx a, b, c {
+  h c; cx b, c; tdg c; cx a, c; t c; cx b, c; tdg c; cx a, c; t b; t c; h c; cx a, b; t a; tdg b; cx a, b;
+}
+gate toffoli a, b, c { ccx a, b, c; }
+gate cswap a, b, c { cx c, b; ccx a, b, c; cx c, b; }
+gate fredkin a, b, c { cswap a, b, c; }
+)";
+
+// Parsed once; names point into its own source, so it is never moved
+inline const QasmProgram& standard_gate_program() {
+    static const QasmProgram* program = [] {
+        auto* prog = new QasmProgram();
+        prog->file = "<stdgates>";
+        std::string_view text(kStandardGateDefinitions);
+        prog->source.assign(text.begin(), text.end());
+        QasmParser(*prog).parse();
+        return prog;
+    }();
+    return *program;
+}
+
+// Default cap on the operations one program may lower to: nested gate
+// definitions multiply, so a short file can otherwise expand into more
+// operations than fit in memory (67M operations take 3 GiB)
+constexpr uint64_t kMaxQasmOps = uint64_t(1) << 26;
+
+class QasmLowering {
+public:
+    explicit QasmLowering(const QasmProgram& prog, uint64_t max_ops = kMaxQasmOps)
+        : prog_(prog), max_ops_(max_ops) {
+        if (prog.num_physical && prog.num_qubits) {
+            fail(1, "physical qubits cannot be mixed with qubit registers");
+        }
+        out_ = LocalCircuit(prog.num_physical ? prog.num_physical : prog.num_qubits, prog.num_clbits);
+        if (&prog != &standard_gate_program()) {
+            for (const QasmGateDef& def : standard_gate_program().gates) {
+                gates_[def.name] = &def;
+            }
+        }
+        for (const QasmGateDef& def : prog.gates) {
+            gates_[def.name] = &def;
+        }
+    }
+
+    LocalCircuit run() {
+        out_.ops().reserve(prog_.statements.size());
+        for (const QasmStatement& s : prog_.statements) {
+            line_ = s.line;
+            top_level(s);
+        }
+        return std::move(out_);
+    }
+
+private:
+    // Qubits or bits [start, start + count)
+    struct Span {
+        uint32_t start;
+        uint32_t count;
+    };
+
+    [[noreturn]] void fail(uint32_t line, const std::string& message) const {
+        throw std::invalid_argument(prog_.file + ":" + std::to_string(line) + ": " + message);
+    }
+
+    Span resolve(const QasmOperand& o, bool quantum, uint32_t line) const {
+        if (o.physical) {
+            if (!quantum) {
+                fail(line, "physical qubit used as a bit");
+            }
+            return {static_cast<uint32_t>(o.index), 1};
+        }
+        for (const QasmRegister& r : quantum ? prog_.qubit_registers : prog_.bit_registers) {
+            if (r.name == o.name) {
+                if (o.index < 0) {
+                    return {r.offset, r.size};
+                }
+                if (o.index >= r.size || r.single) {
+                    fail(line, "index " + std::to_string(o.index) + " out of range for " + std::string(o.name));
+                }
+                return {r.offset + static_cast<uint32_t>(o.index), 1};
+            }
+        }
+        fail(line, std::string("undeclared ") + (quantum ? "qubit" : "bit") + " '" + std::string(o.name) + "'");
+    }
+
+    void top_level(const QasmStatement& s) {
+        Span spans[8];
+        if (s.num_operands > 8) {
+            fail(s.line, "too many operands");
+        }
+        uint32_t width = 1;
+        for (uint32_t i = 0; i < s.num_operands; i++) {
+            spans[i] = resolve(s.operands[i], true, s.line);
+            if (spans[i].count != 1) {
+                if (width != 1 && width != spans[i].count) {
+                    fail(s.line, "registers of different sizes");
+                }
+                width = spans[i].count;
+            }
+        }
+        if (s.kind == QasmStatement::Kind::Measure) {
+            Span bits = resolve(s.target, false, s.line);
+            if (bits.count != width || s.num_operands != 1) {
+                fail(s.line, "measure needs as many bits as qubits");
+            }
+            for (uint32_t k = 0; k < width; k++) {
+                check_size();
+                out_.measure(spans[0].start + (spans[0].count > 1 ? k : 0), bits.start + k);
+            }
+            return;
+        }
+        double params[kMaxParams];
+        if (s.kind == QasmStatement::Kind::Gate) {
+            evaluate_params(s, nullptr, params, s.line);
+        }
+        uint32_t qubits[8];
+        for (uint32_t k = 0; k < width; k++) {
+            for (uint32_t i = 0; i < s.num_operands; i++) {
+                qubits[i] = spans[i].start + (spans[i].count > 1 ? k : 0);
+            }
+            if (s.kind == QasmStatement::Kind::Reset) {
+                check_size();
+                out_.reset(qubits[0]);
+            } else {
+                apply(s.name, params, s.num_params, qubits, s.num_operands, s.line, 0);
+            }
+        }
+    }
+
+    // Reported at the top-level statement whose expansion crossed the cap
+    void check_size() const {
+        if (out_.size() >= max_ops_) {
+            fail(line_, "circuit expands to more than " + std::to_string(max_ops_) + " operations");
+        }
+    }
+
+    void evaluate_params(const QasmStatement& s, const double* args, double* params, uint32_t line) const {
+        if (s.num_params > kMaxParams) {
+            fail(line, "too many parameters for " + std::string(s.name));
+        }
+        for (uint32_t p = 0; p < s.num_params; p++) {
+            params[p] = evaluate(s.params[p], args);
+        }
+    }
+
+    void apply(std::string_view name, const double* params, uint32_t num_params, const uint32_t* qubits,
+               uint32_t num_qubits, uint32_t line, int depth) {
+        GateKind kind;
+        if (native_gate(name, kind)) {
+            Operation op{};
+            op.kind = kind;
+            op.num_qubits = is_two_qubit(kind) ? 2 : 1;
+            if (num_params != gate_num_params(kind) || num_qubits != op.num_qubits) {
+                fail(line, "wrong number of parameters or qubits for " + std::string(name));
+            }
+            for (uint32_t i = 0; i < num_qubits; i++) {
+                op.qubits[i] = qubits[i];
+            }
+            for (uint32_t p = 0; p < num_params; p++) {
+                op.params[p] = params[p];
+            }
+            if (num_qubits == 2 && qubits[0] == qubits[1]) {
+                fail(line, "repeated qubit in " + std::string(name));
+            }
+            check_size();
+            out_.append(op);
+            return;
+        }
+        if (name == "u2" && num_params == 2 && num_qubits == 1) {
+            double u[3] = {kPi / 2, params[0], params[1]};
+            apply("U", u, 3, qubits, 1, line, depth);
+            return;
+        }
+        auto it = gates_.find(name);
+        if (it == gates_.end()) {
+            fail(line, "unknown gate '" + std::string(name) + "'");
+        }
+        const QasmGateDef& def = *it->second;
+        if (num_params != def.num_params || num_qubits != def.num_qubits) {
+            fail(line, "wrong number of parameters or qubits for " + std::string(name));
+        }
+        if (depth > 64) {
+            fail(line, "gate definitions nested too deeply");
+        }
+        for (uint32_t b = 0; b < def.body_size; b++) {
+            const QasmStatement& s = def.body[b];
+            double inner[kMaxParams];
+            evaluate_params(s, params, inner, line);
+            uint32_t inner_qubits[8];
+            if (s.num_operands > 8) {
+                fail(s.line, "too many operands");
+            }
+            for (uint32_t i = 0; i < s.num_operands; i++) {
+                uint32_t a = static_cast<uint32_t>(
+                    std::find(def.qubits, def.qubits + def.num_qubits, s.operands[i].name) - def.qubits);
+                inner_qubits[i] = qubits[a];
+            }
+            apply(s.name, inner, s.num_params, inner_qubits, s.num_operands, s.line, depth + 1);
+        }
+    }
+
+    static constexpr uint32_t kMaxParams = 4;  // cu(θ, φ, λ, γ)
+
+    const QasmProgram& prog_;
+    uint64_t max_ops_;
+    uint32_t line_ = 1;  // top-level statement being lowered
+    LocalCircuit out_;
+    std::unordered_map<std::string_view, const QasmGateDef*> gates_;
+};
+
+}  // namespace detail
+
+// Parses `prog.source`; `prog.file` names the input in error messages
+inline void parse_qasm(QasmProgram& prog) {
+    detail::QasmParser(prog).parse();
+}
+
+// Fails if the program lowers to more than `max_ops` operations
+inline LocalCircuit lower_qasm(const QasmProgram& prog, uint64_t max_ops = detail::kMaxQasmOps) {
+    return detail::QasmLowering(prog, max_ops).run();
+}
+
+inline LocalCircuit read_qasm(std::string_view source, const std::string& file = "<qasm>") {
+    QasmProgram prog;
+    prog.file = file;
+    prog.source.assign(source.begin(), source.end());
+    parse_qasm(prog);
+    return lower_qasm(prog);
+}
+
+// Reads `path` into prog.source and parses it
+inline void load_qasm_file(QasmProgram& prog, const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st {};
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("cannot read " + path);
+    }
+    prog.file = path;
+    prog.source.resize(static_cast<size_t>(st.st_size));
+    size_t done = 0;
+    while (done < prog.source.size()) {
+        ssize_t n = ::read(fd, prog.source.data() + done, prog.source.size() - done);
+        if (n <= 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot read " + path);
+        }
+        done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    parse_qasm(prog);
+}
+
+inline LocalCircuit read_qasm_file(const std::string& path) {
+    QasmProgram prog;
+    load_qasm_file(prog, path);
+    return lower_qasm(prog);
+}
+
+struct QasmFileResult {
+    LocalCircuit circuit;
+    std::string error;  // empty on success
+    uint64_t bytes = 0;
+};
+
+// Every file of `paths`, parsed on `num_threads` threads (0: all cores);
+// a file that fails carries its error instead of a circuit
+inline std::vector<QasmFileResult> read_qasm_files(const std::vector<std::string>& paths, unsigned num_threads = 0) {
+    std::vector<QasmFileResult> results(paths.size());
+    std::atomic<size_t> next{0};
+    unsigned threads = default_num_threads(num_threads);
+    // One chunk per thread, each pulling files from a shared counter so
+    // large files do not leave threads idle
+    parallel_for(threads, threads, 1, [&](size_t, size_t, unsigned) {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            try {
+                QasmProgram prog;
+                load_qasm_file(prog, paths[i]);
+                results[i].bytes = prog.source.size();
+                results[i].circuit = lower_qasm(prog);
+            } catch (const std::exception& e) {
+                results[i].error = e.what();
+            }
+        }
+    });
+    return results;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_QASM_READER_HPP
@@ -0,0 +1,244 @@
+/*
+ * Streaming OpenQASM 3 writer
+ *
+ * QuantumCircuit::to_qasm3() returns the whole program as one string, so
+ * dumping a circuit costs memory proportional to its text (tens of bytes
+ * per gate, on top of the circuit itself). QasmWriter formats one operation
+ * at a time into a fixed buffer and hands full buffers to a file descriptor
+ * or an ostream, so memory stays at the buffer size however large the
+ * circuit is, and operations can be streamed from a generator without ever
+ * materializing the circuit.
+ *
+ * The output follows Qiskit's exporter: stdgates.inc gates by name, with
+ * definitions emitted for the gates the include file lacks (ecr, sxdg).
+ * File descriptors are POSIX only; on Windows the writer takes an ostream.
+ */
+
+#ifndef QKX_QASM_WRITER_HPP
+#define QKX_QASM_WRITER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "local_circuit.hpp"
+
+namespace qkx {
+
+// Bit k set if the circuit uses GateKind k
+inline uint32_t gate_kind_mask(const LocalCircuit& circ) {
+    uint32_t mask = 0;
+    for (const Operation& op : circ.ops()) {
+        mask |= 1u << static_cast<int>(op.kind);
+    }
+    return mask;
+}
+
+class QasmWriter {
+public:
+#ifndef _WIN32
+    explicit QasmWriter(int fd, size_t buffer_bytes = 1 << 16) : fd_(fd) { init(buffer_bytes); }
+#endif
+    explicit QasmWriter(std::ostream& out, size_t buffer_bytes = 1 << 16) : out_(&out) { init(buffer_bytes); }
+    QasmWriter(const QasmWriter&) = delete;
+    QasmWriter& operator=(const QasmWriter&) = delete;
+
+    ~QasmWriter() {
+        try {
+            flush();
+        } catch (...) {
+            // Call finish() to see write errors
+        }
+    }
+
+    // Program header and register declarations; `used_kinds` (see
+    // gate_kind_mask) selects the gate definitions to emit, all by default
+    void begin(uint32_t num_qubits, uint32_t num_clbits, uint32_t used_kinds = ~0u,
+               const std::string& qubit_register = "q", const std::string& clbit_register = "meas") {
+        qreg_ = qubit_register;
+        creg_ = clbit_register;
+        put("OPENQASM 3.0;\ninclude \"stdgates.inc\";\n");
+        if (used_kinds & (1u << static_cast<int>(GateKind::SXdg))) {
+            put("gate sxdg _gate_q_0 {\n  s _gate_q_0;\n  h _gate_q_0;\n  s _gate_q_0;\n}\n");
+        }
+        if (used_kinds & (1u << static_cast<int>(GateKind::ECR))) {
+            put("gate ecr _gate_q_0, _gate_q_1 {\n  s _gate_q_0;\n  sx _gate_q_1;\n"
+                "  cx _gate_q_0, _gate_q_1;\n  x _gate_q_0;\n}\n");
+        }
+        if (num_clbits > 0) {
+            put("bit[");
+            put(num_clbits);
+            put("] ");
+            put(creg_);
+            put(";\n");
+        }
+        put("qubit[");
+        put(num_qubits);
+        put("] ");
+        put(qreg_);
+        put(";\n");
+    }
+
+    void op(const Operation& op) {
+        reserve(kMaxLineBytes + qreg_.size() * 2 + creg_.size());
+        if (op.kind == GateKind::Measure) {
+            put(creg_);
+            put('[');
+            put(op.clbit);
+            put("] = measure ");
+            put_qubit(op.qubits[0]);
+            put(";\n");
+            return;
+        }
+        switch (op.kind) {
+            case GateKind::I: put("id"); break;
+            case GateKind::U: put("u3"); break;
+            default: put(gate_name(op.kind)); break;
+        }
+        uint32_t num_params = gate_num_params(op.kind);
+        for (uint32_t p = 0; p < num_params; p++) {
+            put(p == 0 ? '(' : ',');
+            put(op.params[p]);
+        }
+        if (num_params) {
+            put(')');
+        }
+        put(' ');
+        if (op.num_qubits == 0) {
+            put(qreg_);  // barrier over the whole register
+        }
+        for (uint32_t i = 0; i < op.num_qubits; i++) {
+            if (i) {
+                put(", ");
+            }
+            put_qubit(op.qubits[i]);
+        }
+        put(";\n");
+    }
+
+    // Flushes and reports write errors
+    void finish() {
+        flush();
+        if (out_) {
+            out_->flush();
+            if (!*out_) {
+                throw std::runtime_error("QASM output stream failed");
+            }
+        }
+    }
+
+    uint64_t bytes_written() const { return written_ + used_; }
+
+private:
+    // Longest gate line: name, three shortest-round-trip doubles and two
+    // qubit indices, excluding the register names
+    static constexpr size_t kMaxLineBytes = 160;
+
+    void init(size_t buffer_bytes) {
+        buffer_.resize(std::max<size_t>(buffer_bytes, 4 * kMaxLineBytes));
+    }
+
+    void reserve(size_t bytes) {
+        if (buffer_.size() - used_ < bytes) {
+            flush();
+            if (buffer_.size() < bytes) {
+                buffer_.resize(bytes);
+            }
+        }
+    }
+
+    void put(char c) { buffer_[used_++] = c; }
+
+    void put(const char* s) { put(s, std::strlen(s)); }
+    void put(const std::string& s) { put(s.data(), s.size()); }
+
+    void put(const char* s, size_t n) {
+        reserve(n);
+        std::memcpy(buffer_.data() + used_, s, n);
+        used_ += n;
+    }
+
+    void put(uint32_t v) {
+        reserve(16);
+        used_ = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), v).ptr - buffer_.data();
+    }
+
+    void put(double v) {
+        reserve(32);
+        used_ = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), v).ptr - buffer_.data();
+    }
+
+    void put_qubit(uint32_t q) {
+        put(qreg_);
+        put('[');
+        put(q);
+        put(']');
+    }
+
+    void flush() {
+        const char* p = buffer_.data();
+        size_t left = used_;
+        if (out_) {
+            out_->write(p, static_cast<std::streamsize>(left));
+        }
+#ifndef _WIN32
+        else {
+            while (left > 0) {
+                ssize_t n = ::write(fd_, p, left);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0) {
+                    throw std::runtime_error(std::string("QASM write failed: ") + std::strerror(errno));
+                }
+                p += n;
+                left -= static_cast<size_t>(n);
+            }
+        }
+#endif
+        written_ += used_;
+        used_ = 0;
+    }
+
+    int fd_ = -1;
+    std::ostream* out_ = nullptr;
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    uint64_t written_ = 0;
+    std::string qreg_ = "q";
+    std::string creg_ = "meas";
+};
+
+inline void write_qasm3(const LocalCircuit& circ, QasmWriter& writer) {
+    writer.begin(circ.num_qubits(), circ.num_clbits(), gate_kind_mask(circ));
+    for (const Operation& op : circ.ops()) {
+        writer.op(op);
+    }
+    writer.finish();
+}
+
+inline void write_qasm3(const LocalCircuit& circ, std::ostream& out) {
+    QasmWriter writer(out);
+    write_qasm3(circ, writer);
+}
+
+#ifndef _WIN32
+inline void write_qasm3(const LocalCircuit& circ, int fd) {
+    QasmWriter writer(fd);
+    write_qasm3(circ, writer);
+}
+#endif
+
+}  // namespace qkx
+
+#endif  // QKX_QASM_WRITER_HPP
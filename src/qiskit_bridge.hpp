@@ -0,0 +1,168 @@
+/*
+ * Conversion between Qiskit circuits and LocalCircuit
+ *
+ * Instructions are read through the Qiskit C API (qk_circuit_get_instruction)
+ * on the circuit wrapped by QuantumCircuit, so the same code handles
+ * logical circuits and transpiled circuits on physical qubits. Error rates
+ * for the noisy engines are read from the backend target the same way.
+ */
+
+#ifndef QKX_QISKIT_BRIDGE_HPP
+#define QKX_QISKIT_BRIDGE_HPP
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "circuit/quantumcircuit.hpp"
+
+#include "local_circuit.hpp"
+#include "noise_model.hpp"
+
+namespace qkx {
+
+inline LocalCircuit from_qk_circuit(const QkCircuit* qc) {
+    LocalCircuit circ(qk_circuit_num_qubits(qc), qk_circuit_num_clbits(qc));
+
+    size_t num_inst = qk_circuit_num_instructions(qc);
+    for (size_t i = 0; i < num_inst; i++) {
+        QkCircuitInstruction inst;
+        qk_circuit_get_instruction(qc, i, &inst);
+        std::string name(inst.name);
+
+        GateKind kind;
+        bool known = gate_kind_from_name(name, kind);
+        if (known && kind == GateKind::Barrier) {
+            // Barriers only constrain the transpiler
+        } else if (!known || inst.num_qubits > 2 || inst.num_params != gate_num_params(kind)) {
+            qk_circuit_instruction_clear(&inst);
+            throw std::invalid_argument("instruction not supported by local engines: " + name);
+        } else {
+            Operation op{};
+            op.kind = kind;
+            op.num_qubits = inst.num_qubits;
+            for (uint32_t q = 0; q < inst.num_qubits; q++) {
+                op.qubits[q] = inst.qubits[q];
+            }
+            for (uint32_t p = 0; p < inst.num_params; p++) {
+                op.params[p] = inst.params[p];
+            }
+            if (kind == GateKind::Measure) {
+                op.clbit = inst.clbits[0];
+            }
+            circ.append(op);
+        }
+        qk_circuit_instruction_clear(&inst);
+    }
+    return circ;
+}
+
+inline LocalCircuit from_quantum_circuit(Qiskit::circuit::QuantumCircuit& circ) {
+    auto rust_circ = circ.get_rust_circuit();
+    return from_qk_circuit(rust_circ.get());
+}
+
+// QuantumCircuit with the operations of `circ`, its clbits in one register
+// named "meas" as the sampler results expect. U gates are written as
+// RZ·RY·RZ, equal up to global phase; barriers are kept for the transpiler.
+inline Qiskit::circuit::QuantumCircuit to_quantum_circuit(const LocalCircuit& circ) {
+    using namespace Qiskit::circuit;
+    QuantumRegister qr(circ.num_qubits());
+    ClassicalRegister cr(circ.num_clbits(), std::string("meas"));
+    QuantumCircuit out(std::vector<QuantumRegister>({qr}), std::vector<ClassicalRegister>({cr}));
+    for (const Operation& op : circ.ops()) {
+        const uint32_t a = op.qubits[0], b = op.qubits[1];
+        const double* p = op.params;
+        switch (op.kind) {
+            case GateKind::I: out.id(a); break;
+            case GateKind::H: out.h(a); break;
+            case GateKind::X: out.x(a); break;
+            case GateKind::Y: out.y(a); break;
+            case GateKind::Z: out.z(a); break;
+            case GateKind::S: out.s(a); break;
+            case GateKind::Sdg: out.sdg(a); break;
+            case GateKind::T: out.t(a); break;
+            case GateKind::Tdg: out.tdg(a); break;
+            case GateKind::SX: out.sx(a); break;
+            case GateKind::SXdg: out.sxdg(a); break;
+            case GateKind::RX: out.rx(p[0], a); break;
+            case GateKind::RY: out.ry(p[0], a); break;
+            case GateKind::RZ: out.rz(p[0], a); break;
+            case GateKind::P: out.p(p[0], a); break;
+            case GateKind::U:
+                out.rz(p[2], a);
+                out.ry(p[0], a);
+                out.rz(p[1], a);
+                break;
+            case GateKind::CX: out.cx(a, b); break;
+            case GateKind::CY: out.cy(a, b); break;
+            case GateKind::CZ: out.cz(a, b); break;
+            case GateKind::ECR: out.ecr(a, b); break;
+            case GateKind::Swap: out.swap(a, b); break;
+            case GateKind::Measure: out.measure(a, op.clbit); break;
+            case GateKind::Reset: out.reset(a); break;
+            case GateKind::Barrier:
+                for (uint32_t q = 0; q < op.num_qubits; q++) {
+                    out.barrier(op.qubits[q]);
+                }
+                break;
+        }
+    }
+    return out;
+}
+
+// Gate errors, gate durations and readout errors reported by a backend
+// target. Operations the local engines do not know, and missing (NaN)
+// values, are skipped. The target only carries a symmetric measurement error, so it is
+// used for both assignment directions.
+inline NoiseModel noise_model_from_target(const QkTarget* target) {
+    NoiseModel noise;
+    size_t num_ops = qk_target_num_instructions(target);
+    for (size_t i = 0; i < num_ops; i++) {
+        QkTargetOp target_op;
+        qk_target_op_get(target, i, &target_op);
+        std::string name(target_op.name);
+        qk_target_op_clear(&target_op);
+
+        GateKind kind;
+        if (!gate_kind_from_name(name, kind) || kind == GateKind::Barrier || kind == GateKind::Reset) {
+            continue;
+        }
+        size_t num_props = qk_target_op_num_properties(target, i);
+        for (size_t j = 0; j < num_props; j++) {
+            uint32_t* qargs = nullptr;
+            uint32_t num_qargs = 0;
+            qk_target_op_get_qargs(target, i, j, &qargs, &num_qargs);
+            QkInstructionProperties props;
+            qk_target_op_get_props(target, i, j, &props);
+            if (num_qargs == 0 || num_qargs > 2) {
+                continue;
+            }
+            if (kind == GateKind::Measure) {
+                if (!std::isnan(props.error)) {
+                    noise.set_readout_error(qargs[0], {props.error, props.error});
+                }
+                continue;
+            }
+            if (!std::isnan(props.error)) {
+                if (num_qargs == 1) {
+                    noise.set_gate_error(kind, {qargs[0]}, props.error);
+                } else {
+                    noise.set_gate_error(kind, {qargs[0], qargs[1]}, props.error);
+                }
+            }
+            if (!std::isnan(props.duration)) {
+                if (num_qargs == 1) {
+                    noise.set_gate_duration(kind, {qargs[0]}, props.duration);
+                } else {
+                    noise.set_gate_duration(kind, {qargs[0], qargs[1]}, props.duration);
+                }
+            }
+        }
+    }
+    return noise;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_QISKIT_BRIDGE_HPP
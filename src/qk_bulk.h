@@ -0,0 +1,62 @@
+/*
+ * Array helpers for appending instructions with the Qiskit C API
+ *
+ * Thin convenience wrappers for code that already produces its instruction
+ * stream as parallel arrays:
+ *
+ *   gates[i]  the gate kind
+ *   qargs     qk_gate_num_qubits(gates[i]) qubits per gate, back to back
+ *   params    qk_gate_num_params(gates[i]) angles per gate, back to back
+ *
+ * The C API has no bulk entry point, so this is still one qk_circuit_gate()
+ * call per gate, and it is not faster than calling it directly;
+ * bench_bulk_append compares the two.
+ *
+ * Header only, C99 and C++.
+ */
+
+#ifndef QKX_QK_BULK_H
+#define QKX_QK_BULK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <qiskit.h>
+
+// Appends n gates from parallel arrays (params may be NULL when no gate
+// takes any). Returns the number of gates appended, which is less than n
+// only if a qk_circuit_gate() call failed, at gate index <return value>.
+static inline size_t qkx_circuit_append_gates(QkCircuit *qc, size_t n, const QkGate *gates,
+                                              const uint32_t *qargs, const double *params) {
+    // Generated streams come in runs of one kind, so look the arity up once per run
+    QkGate kind = (QkGate)0;
+    uint32_t num_qubits = 0, num_params = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || gates[i] != kind) {
+            kind = gates[i];
+            num_qubits = qk_gate_num_qubits(kind);
+            num_params = qk_gate_num_params(kind);
+        }
+        if (qk_circuit_gate(qc, kind, qargs, num_params ? params : NULL) != QkExitCode_Success) {
+            return i;
+        }
+        qargs += num_qubits;
+        if (num_params) {
+            params += num_params;
+        }
+    }
+    return n;
+}
+
+// Measures qubit i into clbit i for i < num_qubits. Returns the number of
+// measurements appended, as above.
+static inline uint32_t qkx_circuit_measure_all(QkCircuit *qc, uint32_t num_qubits) {
+    for (uint32_t q = 0; q < num_qubits; q++) {
+        if (qk_circuit_measure(qc, q, q) != QkExitCode_Success) {
+            return q;
+        }
+    }
+    return num_qubits;
+}
+
+#endif  // QKX_QK_BULK_H
@@ -0,0 +1,115 @@
+/*
+ * Random number streams for parallel sampling
+ *
+ * xoshiro256** (Blackman and Vigna) is small, fast and has a jump()
+ * function that advances the state by 2^128 draws, so thread t can use
+ * the stream obtained by jumping t times from a common seed: streams never
+ * overlap and results are reproducible for a given seed and thread count.
+ */
+
+#ifndef QKX_RANDOM_HPP
+#define QKX_RANDOM_HPP
+
+#include <cstdint>
+#include <limits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace qkx {
+
+// Full 64 x 64 -> 128-bit product: returns the low half, stores the high one
+inline uint64_t mul128(uint64_t a, uint64_t b, uint64_t* high) {
+#ifdef _MSC_VER
+    return _umul128(a, b, high);
+#else
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    *high = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#endif
+}
+
+class Xoshiro256 {
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed = 0x853c49e6748fea9bULL) {
+        // Expand the seed with splitmix64 as recommended by the authors
+        for (auto& word : s_) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+    result_type operator()() {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Uniform integer in [0, n) without division (Lemire's multiply-shift;
+    // the bias is below n / 2^64)
+    uint64_t below(uint64_t n) {
+        uint64_t high;
+        mul128((*this)(), n, &high);
+        return high;
+    }
+
+    // Advance by 2^128 draws
+    void jump() {
+        static const uint64_t kJump[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                         0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t j : kJump) {
+            for (int b = 0; b < 64; b++) {
+                if (j & (1ULL << b)) {
+                    for (int i = 0; i < 4; i++) {
+                        t[i] ^= s_[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            s_[i] = t[i];
+        }
+    }
+
+    // Independent stream for worker `index`
+    Xoshiro256 stream(unsigned index) const {
+        Xoshiro256 r = *this;
+        for (unsigned i = 0; i <= index; i++) {
+            r.jump();
+        }
+        return r;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s_[4];
+};
+
+}  // namespace qkx
+
+#endif  // QKX_RANDOM_HPP
@@ -0,0 +1,156 @@
+/*
+ * Readout calibration circuits for ReadoutMitigator
+ *
+ * Calibration is done on the physical qubits a transpiled circuit actually
+ * measures: one circuit prepares all of them in |0⟩, one in |1⟩, and the
+ * per-qubit marginals give the assignment error rates (the tensored model
+ * used by M3). The circuits only use X and measure, which every backend
+ * supports natively, so they are submitted without transpiling and keep
+ * exactly the same layout as the experiment. Results are cached per
+ * backend so repeated runs within max_age reuse them.
+ */
+
+#ifndef QKX_READOUT_CALIBRATION_HPP
+#define QKX_READOUT_CALIBRATION_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "circuit/quantumcircuit.hpp"
+#include "primitives/backend_sampler_v2.hpp"
+
+#include "bitstring.hpp"
+#include "readout_mitigation.hpp"
+
+namespace qkx {
+
+// Physical qubit measured into each classical bit of a transpiled circuit.
+// If a clbit is written more than once the last measurement wins.
+inline std::vector<uint32_t> measured_qubits(Qiskit::circuit::QuantumCircuit& circ) {
+    auto rust_circ = circ.get_rust_circuit();
+    const QkCircuit* qc = rust_circ.get();
+    std::vector<uint32_t> physical(qk_circuit_num_clbits(qc), UINT32_MAX);
+
+    size_t num_inst = qk_circuit_num_instructions(qc);
+    for (size_t i = 0; i < num_inst; i++) {
+        QkCircuitInstruction inst;
+        qk_circuit_get_instruction(qc, i, &inst);
+        if (std::string(inst.name) == "measure" && inst.num_qubits == 1 && inst.num_clbits == 1) {
+            physical[inst.clbits[0]] = inst.qubits[0];
+        }
+        qk_circuit_instruction_clear(&inst);
+    }
+    for (uint32_t q : physical) {
+        if (q == UINT32_MAX) {
+            throw std::runtime_error("circuit leaves a classical bit unmeasured");
+        }
+    }
+    return physical;
+}
+
+// Build the |0...0⟩ and |1...1⟩ calibration circuits on the given
+// physical qubits of a device with num_device_qubits qubits
+inline std::vector<Qiskit::circuit::QuantumCircuit> readout_calibration_circuits(
+        uint32_t num_device_qubits, const std::vector<uint32_t>& physical_qubits) {
+    using namespace Qiskit::circuit;
+
+    std::vector<QuantumCircuit> circuits;
+    for (int prepared = 0; prepared < 2; prepared++) {
+        QuantumRegister qr(num_device_qubits);
+        ClassicalRegister cr(physical_qubits.size(), std::string("meas"));
+        QuantumCircuit circ(
+            std::vector<QuantumRegister>({qr}),
+            std::vector<ClassicalRegister>({cr})
+        );
+        for (size_t c = 0; c < physical_qubits.size(); c++) {
+            if (prepared) {
+                circ.x(physical_qubits[c]);
+            }
+        }
+        for (size_t c = 0; c < physical_qubits.size(); c++) {
+            circ.measure(physical_qubits[c], c);
+        }
+        circuits.push_back(circ);
+    }
+    return circuits;
+}
+
+// Per-qubit error rates from the counts of the two calibration circuits
+template <typename Counts>
+ReadoutCalibration readout_calibration_from_counts(const std::string& backend,
+                                                   const std::vector<uint32_t>& physical_qubits,
+                                                   const Counts& counts0, const Counts& counts1) {
+    const uint32_t num_bits = static_cast<uint32_t>(physical_qubits.size());
+    std::vector<uint64_t> ones_given_0(num_bits, 0), zeros_given_1(num_bits, 0);
+    uint64_t shots0 = 0, shots1 = 0;
+
+    for (const auto& c : counts0) {
+        Bitstring b = Bitstring::from_string(c.first, num_bits);
+        for (uint32_t bit = 0; bit < num_bits; bit++) {
+            if (b.get(bit)) {
+                ones_given_0[bit] += c.second;
+            }
+        }
+        shots0 += c.second;
+    }
+    for (const auto& c : counts1) {
+        Bitstring b = Bitstring::from_string(c.first, num_bits);
+        for (uint32_t bit = 0; bit < num_bits; bit++) {
+            if (!b.get(bit)) {
+                zeros_given_1[bit] += c.second;
+            }
+        }
+        shots1 += c.second;
+    }
+    if (shots0 == 0 || shots1 == 0) {
+        throw std::runtime_error("readout calibration returned no shots");
+    }
+
+    ReadoutCalibration cal;
+    cal.backend = backend;
+    cal.timestamp = static_cast<int64_t>(std::time(nullptr));
+    for (uint32_t bit = 0; bit < num_bits; bit++) {
+        QubitReadoutError e;
+        e.p01 = static_cast<double>(ones_given_0[bit]) / static_cast<double>(shots0);
+        e.p10 = static_cast<double>(zeros_given_1[bit]) / static_cast<double>(shots1);
+        cal.qubits[physical_qubits[bit]] = e;
+    }
+    return cal;
+}
+
+// Return a calibration covering physical_qubits, from the cache if a fresh
+// one exists and otherwise by running both calibration circuits as a
+// single job with the given sampler
+template <typename Sampler>
+ReadoutCalibration get_readout_calibration(Sampler& sampler, const std::string& backend,
+                                           uint32_t num_device_qubits,
+                                           const std::vector<uint32_t>& physical_qubits,
+                                           int64_t max_age_seconds = 6 * 3600,
+                                           const ReadoutCalibrationCache& cache = ReadoutCalibrationCache()) {
+    using namespace Qiskit::primitives;
+
+    ReadoutCalibration cal;
+    if (cache.load(backend, cal) && cal.covers(physical_qubits) && cal.is_fresh(max_age_seconds, physical_qubits)) {
+        return cal;
+    }
+
+    auto circuits = readout_calibration_circuits(num_device_qubits, physical_qubits);
+    auto job = sampler.run({SamplerPub(circuits[0]), SamplerPub(circuits[1])});
+    if (job == nullptr) {
+        throw std::runtime_error("failed to submit readout calibration job");
+    }
+    auto result = job->result();
+    auto counts0 = result[0].data("meas").get_counts();
+    auto counts1 = result[1].data("meas").get_counts();
+
+    cal = readout_calibration_from_counts(backend, physical_qubits, counts0, counts1);
+    cache.store(cal);
+    return cal;
+}
+
+}  // namespace qkx
+
+#endif  // QKX_READOUT_CALIBRATION_HPP
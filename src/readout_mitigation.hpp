@@ -0,0 +1,529 @@
+/*
+ * Matrix-free readout-error mitigation
+ *
+ * Implements the M3 approach (Nation et al., PRX Quantum 2, 040326): the
+ * readout assignment matrix is restricted to the outcomes that were
+ * actually observed, truncated to pairs within a small Hamming distance,
+ * column-renormalised, and the resulting linear system is solved with
+ * preconditioned GMRES without ever forming the matrix. Work scales with
+ * the number of distinct outcomes rather than 2^N, so wide registers up
+ * to 127 qubits are cheap as long as shots are finite.
+ *
+ * Per-qubit error rates come from a ReadoutCalibration, which is cached on
+ * disk per backend (see readout_calibration.hpp for the circuits).
+ */
+
+#ifndef QKX_READOUT_MITIGATION_HPP
+#define QKX_READOUT_MITIGATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "bitstring.hpp"
+#include "parallel.hpp"
+
+namespace qkx {
+
+// Assignment error rates of a single qubit
+struct QubitReadoutError {
+    double p01 = 0.0;  // P(measure 1 | prepared 0)
+    double p10 = 0.0;  // P(measure 0 | prepared 1)
+};
+
+// Calibration data for the physical qubits of one backend. Entries merged
+// from several calibration runs keep the time of the run that measured them.
+struct ReadoutCalibration {
+    std::string backend;
+    int64_t timestamp = 0;  // Unix time of the latest calibration run
+    std::map<uint32_t, QubitReadoutError> qubits;
+    std::map<uint32_t, int64_t> qubit_timestamps;  // if older than `timestamp`
+
+    int64_t qubit_timestamp(uint32_t q) const {
+        auto it = qubit_timestamps.find(q);
+        return it == qubit_timestamps.end() ? timestamp : it->second;
+    }
+
+    bool covers(const std::vector<uint32_t>& physical_qubits) const {
+        for (uint32_t q : physical_qubits) {
+            if (qubits.find(q) == qubits.end()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True if every one of physical_qubits was calibrated within the age
+    bool is_fresh(int64_t max_age_seconds, const std::vector<uint32_t>& physical_qubits) const {
+        const int64_t now = static_cast<int64_t>(std::time(nullptr));
+        for (uint32_t q : physical_qubits) {
+            if (now - qubit_timestamp(q) > max_age_seconds) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Error rates ordered by classical bit, given the physical qubit
+    // measured into each classical bit
+    std::vector<QubitReadoutError> for_qubits(const std::vector<uint32_t>& physical_qubits) const {
+        std::vector<QubitReadoutError> errors;
+        errors.reserve(physical_qubits.size());
+        for (uint32_t q : physical_qubits) {
+            auto it = qubits.find(q);
+            if (it == qubits.end()) {
+                throw std::out_of_range("no readout calibration for qubit " + std::to_string(q));
+            }
+            errors.push_back(it->second);
+        }
+        return errors;
+    }
+};
+
+// On-disk cache of calibrations, one JSON file per backend
+class ReadoutCalibrationCache {
+public:
+    explicit ReadoutCalibrationCache(std::string directory = default_directory())
+        : directory_(std::move(directory)) {}
+
+    // $QISKIT_READOUT_CACHE, or $HOME/.qiskit/readout_cache
+    static std::string default_directory() {
+        if (const char* dir = std::getenv("QISKIT_READOUT_CACHE")) {
+            return dir;
+        }
+        const char* home = std::getenv("HOME");
+        return std::string(home ? home : ".") + "/.qiskit/readout_cache";
+    }
+
+    std::string path(const std::string& backend) const {
+        return directory_ + "/" + backend + ".json";
+    }
+
+    // Returns false if there is no usable cache entry for the backend
+    bool load(const std::string& backend, ReadoutCalibration& cal) const {
+        std::ifstream in(path(backend));
+        if (!in) {
+            return false;
+        }
+        nlohmann::json j;
+        try {
+            in >> j;
+            cal.backend = j.at("backend").get<std::string>();
+            cal.timestamp = j.at("timestamp").get<int64_t>();
+            cal.qubits.clear();
+            cal.qubit_timestamps.clear();
+            for (const auto& q : j.at("qubits")) {
+                QubitReadoutError e;
+                e.p01 = q.at("p01").get<double>();
+                e.p10 = q.at("p10").get<double>();
+                const uint32_t qubit = q.at("qubit").get<uint32_t>();
+                cal.qubits[qubit] = e;
+                // Files written before per-qubit times carry only the file's
+                if (q.contains("timestamp")) {
+                    cal.qubit_timestamps[qubit] = q.at("timestamp").get<int64_t>();
+                }
+            }
+        } catch (const nlohmann::json::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    // Merge with any existing entry so calibrations of different qubit
+    // subsets accumulate, each qubit keeping the time it was measured at;
+    // returns false if the file could not be written
+    bool store(const ReadoutCalibration& cal) const {
+        ReadoutCalibration merged;
+        if (!load(cal.backend, merged)) {
+            merged.backend = cal.backend;
+        }
+        for (const auto& q : merged.qubits) {
+            merged.qubit_timestamps[q.first] = merged.qubit_timestamp(q.first);
+        }
+        for (const auto& q : cal.qubits) {
+            merged.qubits[q.first] = q.second;
+            merged.qubit_timestamps[q.first] = cal.qubit_timestamp(q.first);
+        }
+        merged.timestamp = std::max(merged.timestamp, cal.timestamp);
+
+        nlohmann::json j;
+        j["backend"] = merged.backend;
+        j["timestamp"] = merged.timestamp;
+        j["qubits"] = nlohmann::json::array();
+        for (const auto& q : merged.qubits) {
+            j["qubits"].push_back({{"qubit", q.first}, {"p01", q.second.p01}, {"p10", q.second.p10},
+                                   {"timestamp", merged.qubit_timestamp(q.first)}});
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        std::ofstream out(path(cal.backend));
+        if (!out) {
+            return false;
+        }
+        out << j.dump(2) << std::endl;
+        return static_cast<bool>(out);
+    }
+
+private:
+    std::string directory_;
+};
+
+// Mitigated result: quasi-probabilities over the observed outcomes. Values
+// may be slightly negative; use nearest_probability() if that matters.
+struct QuasiDistribution {
+    std::vector<Bitstring> outcomes;
+    std::vector<double> values;
+
+    // Sum of |q|; the variance of mitigated estimates grows with its square
+    double mitigation_overhead() const {
+        double s = 0.0;
+        for (double v : values) {
+            s += std::fabs(v);
+        }
+        return s;
+    }
+
+    // Closest probability distribution in L2 norm (Smolin, Gambetta and
+    // Smith, PRL 108, 070502)
+    QuasiDistribution nearest_probability() const {
+        std::vector<size_t> order(values.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                  [this](size_t a, size_t b) { return values[a] < values[b]; });
+
+        QuasiDistribution out;
+        std::vector<double> probs(values.size(), 0.0);
+        double accumulator = 0.0;
+        size_t k = 0;
+        size_t remaining = values.size();
+        for (; k < order.size(); k++) {
+            double v = values[order[k]];
+            if (v + accumulator / static_cast<double>(remaining) >= 0.0) {
+                break;
+            }
+            accumulator += v;
+            remaining--;
+        }
+        for (; k < order.size(); k++) {
+            probs[order[k]] = values[order[k]] + accumulator / static_cast<double>(remaining);
+        }
+        for (size_t i = 0; i < values.size(); i++) {
+            if (probs[i] > 0.0) {
+                out.outcomes.push_back(outcomes[i]);
+                out.values.push_back(probs[i]);
+            }
+        }
+        return out;
+    }
+};
+
+struct MitigationOptions {
+    int max_distance = 3;      // Hamming-distance truncation of the matrix
+    double tolerance = 1e-6;   // relative residual for GMRES
+    int max_iterations = 200;
+    int restart = 30;
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+};
+
+struct MitigationStats {
+    int iterations = 0;
+    double residual = 0.0;
+    bool converged = false;
+};
+
+class ReadoutMitigator {
+public:
+    // errors[i] holds the rates of the qubit measured into classical bit i
+    explicit ReadoutMitigator(std::vector<QubitReadoutError> errors,
+                              MitigationOptions options = MitigationOptions())
+        : errors_(std::move(errors)), options_(options) {
+        ratio0_.resize(errors_.size());
+        ratio1_.resize(errors_.size());
+        for (size_t i = 0; i < errors_.size(); i++) {
+            ratio0_[i] = errors_[i].p01 / (1.0 - errors_[i].p01);
+            ratio1_[i] = errors_[i].p10 / (1.0 - errors_[i].p10);
+        }
+        options_.num_threads = default_num_threads(options_.num_threads);
+    }
+
+    QuasiDistribution apply(const Histogram& hist, MitigationStats* stats = nullptr) const {
+        System sys = build_system(hist);
+        const size_t n = sys.outcomes.size();
+
+        std::vector<double> b(n);
+        double shots = static_cast<double>(total_shots(hist));
+        for (size_t i = 0; i < n; i++) {
+            b[i] = static_cast<double>(hist[sys.order[i]].second) / shots;
+        }
+
+        std::vector<double> x = gmres(sys, b, stats);
+
+        QuasiDistribution out;
+        out.outcomes.resize(n);
+        out.values.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            out.outcomes[i] = hist[sys.order[i]].first;
+            out.values[i] = x[i];
+        }
+        return out;
+    }
+
+private:
+    // Observed outcomes sorted by Hamming weight, so that candidates within
+    // distance D of an outcome lie in the weight buckets w-D .. w+D. The
+    // truncated sparsity pattern is found once; matrix elements are never
+    // stored and are recomputed from the per-qubit rates on every product.
+    struct System {
+        std::vector<size_t> order;            // index into the input histogram
+        std::vector<const uint64_t*> outcomes;
+        std::vector<int> weight;
+        std::vector<size_t> bucket_start;     // by weight, size num_bits + 2
+        std::vector<std::vector<uint32_t>> neighbours;  // within max_distance
+        std::vector<double> stay;             // P(y | y)
+        std::vector<double> colsum;           // truncated column sums
+        uint32_t words = 0;
+    };
+
+    // A[x][y] / P(y|y): product over differing bits of the flip ratio
+    double flip_factor(const System& sys, size_t x, size_t y) const {
+        const uint64_t* a = sys.outcomes[x];
+        const uint64_t* c = sys.outcomes[y];
+        double f = 1.0;
+        for (uint32_t w = 0; w < sys.words; w++) {
+            uint64_t diff = a[w] ^ c[w];
+            while (diff) {
+                uint32_t bit = (w << 6) + ctz64(diff);
+                f *= ((c[w] >> (bit & 63)) & 1ULL) ? ratio1_[bit] : ratio0_[bit];
+                diff &= diff - 1;
+            }
+        }
+        return f;
+    }
+
+    // Index range of outcomes whose weight is within max_distance of i
+    std::pair<size_t, size_t> candidates(const System& sys, size_t i) const {
+        int lo = std::max(0, sys.weight[i] - options_.max_distance);
+        int hi = std::min(static_cast<int>(errors_.size()), sys.weight[i] + options_.max_distance);
+        return {sys.bucket_start[lo], sys.bucket_start[hi + 1]};
+    }
+
+    System build_system(const Histogram& hist) const {
+        const uint32_t num_bits = static_cast<uint32_t>(errors_.size());
+        System sys;
+        sys.words = num_words(num_bits);
+        const size_t n = hist.size();
+
+        std::vector<int> w(n);
+        for (size_t i = 0; i < n; i++) {
+            if (hist[i].first.num_bits() != num_bits) {
+                throw std::invalid_argument("outcome width does not match calibration");
+            }
+            w[i] = hist[i].first.hamming_weight();
+        }
+        sys.order.resize(n);
+        std::iota(sys.order.begin(), sys.order.end(), 0);
+        std::stable_sort(sys.order.begin(), sys.order.end(),
+                         [&w](size_t a, size_t b) { return w[a] < w[b]; });
+
+        sys.outcomes.resize(n);
+        sys.weight.resize(n);
+        sys.bucket_start.assign(num_bits + 2, n);
+        for (size_t i = n; i > 0; i--) {
+            size_t src = sys.order[i - 1];
+            sys.outcomes[i - 1] = hist[src].first.data();
+            sys.weight[i - 1] = w[src];
+            sys.bucket_start[w[src]] = i - 1;
+        }
+        for (size_t k = num_bits + 1; k > 0; k--) {
+            sys.bucket_start[k - 1] = std::min(sys.bucket_start[k - 1], sys.bucket_start[k]);
+        }
+
+        sys.neighbours.resize(n);
+        sys.stay.resize(n);
+        sys.colsum.resize(n);
+        parallel_for(n, options_.num_threads, 256, [&](size_t begin, size_t end, unsigned) {
+            for (size_t y = begin; y < end; y++) {
+                auto range = candidates(sys, y);
+                for (size_t x = range.first; x < range.second; x++) {
+                    if (hamming_distance(sys.outcomes[x], sys.outcomes[y], sys.words) <= options_.max_distance) {
+                        sys.neighbours[y].push_back(static_cast<uint32_t>(x));
+                    }
+                }
+
+                double stay = 1.0;
+                for (uint32_t bit = 0; bit < num_bits; bit++) {
+                    bool one = (sys.outcomes[y][bit >> 6] >> (bit & 63)) & 1ULL;
+                    stay *= one ? 1.0 - errors_[bit].p10 : 1.0 - errors_[bit].p01;
+                }
+                sys.stay[y] = stay;
+                double sum = 0.0;
+                for (uint32_t x : sys.neighbours[y]) {
+                    sum += flip_factor(sys, x, y);
+                }
+                sys.colsum[y] = stay * sum;
+            }
+        });
+        return sys;
+    }
+
+    // out = A v, computed row by row so threads never share an output
+    void matvec(const System& sys, const std::vector<double>& v, std::vector<double>& out) const {
+        const size_t n = v.size();
+        std::vector<double> scaled(n);
+        for (size_t y = 0; y < n; y++) {
+            scaled[y] = v[y] * sys.stay[y] / sys.colsum[y];
+        }
+        parallel_for(n, options_.num_threads, 256, [&](size_t begin, size_t end, unsigned) {
+            for (size_t x = begin; x < end; x++) {
+                // Truncation is symmetric, so row x has the same pattern
+                double acc = 0.0;
+                for (uint32_t y : sys.neighbours[x]) {
+                    acc += flip_factor(sys, x, y) * scaled[y];
+                }
+                out[x] = acc;
+            }
+        });
+    }
+
+    static double norm(const std::vector<double>& v) {
+        double s = 0.0;
+        for (double x : v) {
+            s += x * x;
+        }
+        return std::sqrt(s);
+    }
+
+    // Restarted GMRES with a right Jacobi preconditioner
+    std::vector<double> gmres(const System& sys, const std::vector<double>& b,
+                              MitigationStats* stats) const {
+        const size_t n = b.size();
+        const int m = std::max(1, std::min<int>(options_.restart, static_cast<int>(n)));
+
+        std::vector<double> inv_diag(n);
+        for (size_t i = 0; i < n; i++) {
+            inv_diag[i] = sys.colsum[i] / sys.stay[i];
+        }
+
+        std::vector<double> x(b);
+        std::vector<double> r(n), w(n), z(n);
+        std::vector<std::vector<double>> V(m + 1, std::vector<double>(n));
+        std::vector<std::vector<double>> H(m + 1, std::vector<double>(m, 0.0));
+        std::vector<double> cs(m), sn(m), g(m + 1);
+
+        const double bnorm = std::max(norm(b), 1e-300);
+        MitigationStats local;
+        int total = 0;
+
+        while (total < options_.max_iterations) {
+            matvec(sys, x, w);
+            for (size_t i = 0; i < n; i++) {
+                r[i] = b[i] - w[i];
+            }
+            double beta = norm(r);
+            local.residual = beta / bnorm;
+            if (local.residual < options_.tolerance) {
+                local.converged = true;
+                break;
+            }
+            for (size_t i = 0; i < n; i++) {
+                V[0][i] = r[i] / beta;
+            }
+            std::fill(g.begin(), g.end(), 0.0);
+            g[0] = beta;
+
+            int k = 0;
+            for (; k < m && total < options_.max_iterations; k++, total++) {
+                for (size_t i = 0; i < n; i++) {
+                    z[i] = V[k][i] * inv_diag[i];
+                }
+                matvec(sys, z, w);
+                // Modified Gram-Schmidt
+                for (int j = 0; j <= k; j++) {
+                    double h = 0.0;
+                    for (size_t i = 0; i < n; i++) {
+                        h += w[i] * V[j][i];
+                    }
+                    H[j][k] = h;
+                    for (size_t i = 0; i < n; i++) {
+                        w[i] -= h * V[j][i];
+                    }
+                }
+                double hnext = norm(w);
+                H[k + 1][k] = hnext;
+                if (hnext > 0.0) {
+                    for (size_t i = 0; i < n; i++) {
+                        V[k + 1][i] = w[i] / hnext;
+                    }
+                }
+                // Apply previous Givens rotations, then make a new one
+                for (int j = 0; j < k; j++) {
+                    double t = cs[j] * H[j][k] + sn[j] * H[j + 1][k];
+                    H[j + 1][k] = -sn[j] * H[j][k] + cs[j] * H[j + 1][k];
+                    H[j][k] = t;
+                }
+                double denom = std::hypot(H[k][k], H[k + 1][k]);
+                cs[k] = denom > 0.0 ? H[k][k] / denom : 1.0;
+                sn[k] = denom > 0.0 ? H[k + 1][k] / denom : 0.0;
+                H[k][k] = denom;
+                H[k + 1][k] = 0.0;
+                g[k + 1] = -sn[k] * g[k];
+                g[k] = cs[k] * g[k];
+
+                local.residual = std::fabs(g[k + 1]) / bnorm;
+                if (local.residual < options_.tolerance || hnext == 0.0) {
+                    k++;
+                    total++;
+                    break;
+                }
+            }
+
+            // Back-substitute H y = g and update x += M^-1 V y
+            std::vector<double> y(k, 0.0);
+            for (int i = k - 1; i >= 0; i--) {
+                double s = g[i];
+                for (int j = i + 1; j < k; j++) {
+                    s -= H[i][j] * y[j];
+                }
+                y[i] = H[i][i] != 0.0 ? s / H[i][i] : 0.0;
+            }
+            for (size_t i = 0; i < n; i++) {
+                double s = 0.0;
+                for (int j = 0; j < k; j++) {
+                    s += V[j][i] * y[j];
+                }
+                x[i] += inv_diag[i] * s;
+            }
+            if (local.residual < options_.tolerance) {
+                local.converged = true;
+                break;
+            }
+        }
+
+        local.iterations = total;
+        if (stats) {
+            *stats = local;
+        }
+        return x;
+    }
+
+    std::vector<QubitReadoutError> errors_;
+    std::vector<double> ratio0_;  // p01 / (1 - p01)
+    std::vector<double> ratio1_;  // p10 / (1 - p10)
+    MitigationOptions options_;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_READOUT_MITIGATION_HPP
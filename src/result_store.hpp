@@ -0,0 +1,586 @@
+/*
+ * Columnar on-disk store for sampler results
+ *
+ * A store is a directory of append-only segment files (seg-000001.qkr,
+ * ...). Each writer session opens a fresh segment, appends one record per
+ * job and, on close, seals it with a footer. Nothing is ever rewritten.
+ *
+ * Segment layout (little-endian; records, shot columns and the footer are
+ * 64-byte aligned):
+ *
+ *   SegmentHeader
+ *   record 0:  RecordHeader | backend | job id | layout (u32 per clbit) |
+ *              metadata (JSON text) | shot columns
+ *   record 1:  ...
+ *   footer:    FooterHeader | per-record columns (offset, timestamp,
+ *              num_shots, num_bits, backend id) | backend name table
+ *   SegmentTrailer
+ *
+ * Shots are stored column-wise: classical bit c is a bitmap of
+ * ceil(num_shots / 64) words, with shot s in bit s % 64 of word s / 64.
+ * Marginals and per-qubit statistics touch only the columns they need,
+ * and whole-job scans stream through contiguous memory.
+ *
+ * Readers mmap every segment. Sealed segments are indexed through the
+ * footer columns alone, so filtering years of runs by time or backend does
+ * not page in any shot data; an unsealed segment (writer still running or
+ * crashed) is recovered by walking record headers up to the last complete
+ * record. Footer columns and record headers are checked against the
+ * mapping first, so a corrupt sealed segment raises std::runtime_error
+ * instead of reading out of bounds.
+ */
+
+#ifndef QKX_RESULT_STORE_HPP
+#define QKX_RESULT_STORE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bitstring.hpp"
+
+namespace qkx {
+
+namespace store_format {
+
+constexpr uint64_t kSegmentMagic = 0x31544553584b51ULL;  // "QKXSET1"
+constexpr uint32_t kRecordMagic = 0x43524b51;            // "QKRC"
+constexpr uint32_t kFooterMagic = 0x54464b51;            // "QKFT"
+constexpr uint64_t kTrailerMagic = 0x444c4145534b51ULL;  // "QKSEALD"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kAlign = 64;
+
+inline size_t align_up(size_t n) {
+    return (n + kAlign - 1) & ~(kAlign - 1);
+}
+
+struct SegmentHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    int64_t created_ns;
+    uint8_t padding[40];
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t num_bits;
+    uint64_t record_size;   // whole record including padding
+    uint64_t num_shots;
+    int64_t timestamp_ns;
+    uint32_t backend_len;
+    uint32_t job_id_len;
+    uint32_t metadata_len;
+    uint32_t layout_len;      // 0 or num_bits
+    uint64_t columns_offset;  // from start of record
+};
+
+struct FooterHeader {
+    uint32_t magic;
+    uint32_t num_backends;
+    uint64_t num_records;
+    uint64_t backend_table_size;
+    uint64_t reserved;
+};
+
+struct SegmentTrailer {
+    uint64_t footer_offset;
+    uint64_t magic;
+};
+
+static_assert(sizeof(SegmentHeader) == kAlign, "segment header must fill one block");
+
+}  // namespace store_format
+
+// Metadata of one sampler job, stored alongside its shots
+struct ResultMetadata {
+    std::string backend;
+    std::string job_id;
+    int64_t timestamp_ns = 0;       // 0 = time of append
+    std::vector<uint32_t> layout;   // physical qubit per classical bit
+    std::string metadata;           // free-form JSON
+};
+
+inline int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+class ResultStoreWriter {
+public:
+    explicit ResultStoreWriter(const std::string& directory) : directory_(directory) {
+        std::filesystem::create_directories(directory_);
+
+        // Each session starts a new segment after the highest existing one
+        int next = 1;
+        for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+            int n = 0;
+            if (std::sscanf(entry.path().filename().c_str(), "seg-%d.qkr", &n) == 1) {
+                next = std::max(next, n + 1);
+            }
+        }
+        char name[32];
+        std::snprintf(name, sizeof(name), "seg-%06d.qkr", next);
+        path_ = directory_ + "/" + name;
+
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot create " + path_);
+        }
+        store_format::SegmentHeader header{};
+        header.magic = store_format::kSegmentMagic;
+        header.version = store_format::kVersion;
+        header.created_ns = now_ns();
+        write_all(&header, sizeof(header));
+        offset_ = sizeof(header);
+    }
+
+    ResultStoreWriter(const ResultStoreWriter&) = delete;
+    ResultStoreWriter& operator=(const ResultStoreWriter&) = delete;
+
+    ~ResultStoreWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    const std::string& path() const { return path_; }
+
+    // Append one job. The record is assembled in memory and written with a
+    // single write(), so a crash leaves at most one truncated tail record.
+    void append(const ResultMetadata& meta, const PackedShots& shots) {
+        using namespace store_format;
+        if (fd_ < 0) {
+            throw std::logic_error("result store writer is closed");
+        }
+        if (!meta.layout.empty() && meta.layout.size() != shots.num_bits()) {
+            throw std::invalid_argument("layout size does not match number of bits");
+        }
+
+        const uint64_t num_shots = shots.num_shots();
+        const uint32_t num_bits = shots.num_bits();
+        const size_t column_words = (num_shots + 63) / 64;
+
+        size_t strings = sizeof(RecordHeader) + meta.backend.size() + meta.job_id.size();
+        size_t layout_offset = (strings + 3) & ~size_t(3);
+        size_t metadata_offset = layout_offset + meta.layout.size() * sizeof(uint32_t);
+        size_t columns_offset = align_up(metadata_offset + meta.metadata.size());
+        size_t record_size = align_up(columns_offset + num_bits * column_words * sizeof(uint64_t));
+
+        std::vector<uint8_t> buf(record_size, 0);
+        RecordHeader header{};
+        header.magic = kRecordMagic;
+        header.num_bits = num_bits;
+        header.record_size = record_size;
+        header.num_shots = num_shots;
+        header.timestamp_ns = meta.timestamp_ns ? meta.timestamp_ns : now_ns();
+        header.backend_len = static_cast<uint32_t>(meta.backend.size());
+        header.job_id_len = static_cast<uint32_t>(meta.job_id.size());
+        header.metadata_len = static_cast<uint32_t>(meta.metadata.size());
+        header.layout_len = static_cast<uint32_t>(meta.layout.size());
+        header.columns_offset = columns_offset;
+        std::memcpy(buf.data(), &header, sizeof(header));
+
+        uint8_t* p = buf.data() + sizeof(header);
+        std::memcpy(p, meta.backend.data(), meta.backend.size());
+        std::memcpy(p + meta.backend.size(), meta.job_id.data(), meta.job_id.size());
+        if (!meta.layout.empty()) {
+            std::memcpy(buf.data() + layout_offset, meta.layout.data(),
+                        meta.layout.size() * sizeof(uint32_t));
+        }
+        std::memcpy(buf.data() + metadata_offset, meta.metadata.data(), meta.metadata.size());
+
+        // Transpose row-major shots into one bitmap per classical bit
+        uint64_t* columns = reinterpret_cast<uint64_t*>(buf.data() + columns_offset);
+        const uint32_t words = shots.words_per_shot();
+        for (uint64_t s = 0; s < num_shots; s++) {
+            const uint64_t* row = shots.shot(s);
+            const uint64_t shot_bit = 1ULL << (s & 63);
+            for (uint32_t w = 0; w < words; w++) {
+                uint64_t bits = row[w];
+                while (bits) {
+                    uint32_t c = (w << 6) + ctz64(bits);
+                    columns[c * column_words + (s >> 6)] |= shot_bit;
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        write_all(buf.data(), buf.size());
+
+        index_offset_.push_back(offset_);
+        index_timestamp_.push_back(header.timestamp_ns);
+        index_shots_.push_back(num_shots);
+        index_bits_.push_back(num_bits);
+        auto it = backend_ids_.emplace(meta.backend, static_cast<uint32_t>(backend_ids_.size())).first;
+        index_backend_.push_back(it->second);
+        offset_ += record_size;
+    }
+
+    // Seal the segment with its footer and trailer
+    void close() {
+        using namespace store_format;
+        if (fd_ < 0) {
+            return;
+        }
+        const uint64_t n = index_offset_.size();
+
+        std::vector<std::string> names(backend_ids_.size());
+        for (const auto& b : backend_ids_) {
+            names[b.second] = b.first;
+        }
+        std::string table;
+        for (const auto& name : names) {
+            table.append(name);
+            table.push_back('\0');
+        }
+
+        FooterHeader footer{};
+        footer.magic = kFooterMagic;
+        footer.num_backends = static_cast<uint32_t>(names.size());
+        footer.num_records = n;
+        footer.backend_table_size = table.size();
+
+        std::vector<uint8_t> buf;
+        auto put = [&buf](const void* data, size_t size) {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            buf.insert(buf.end(), p, p + size);
+        };
+        put(&footer, sizeof(footer));
+        put(index_offset_.data(), n * sizeof(uint64_t));
+        put(index_timestamp_.data(), n * sizeof(int64_t));
+        put(index_shots_.data(), n * sizeof(uint64_t));
+        put(index_bits_.data(), n * sizeof(uint32_t));
+        put(index_backend_.data(), n * sizeof(uint32_t));
+        put(table.data(), table.size());
+        buf.resize(align_up(buf.size()), 0);
+
+        SegmentTrailer trailer{offset_, kTrailerMagic};
+        put(&trailer, sizeof(trailer));
+
+        write_all(buf.data(), buf.size());
+        ::fsync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    void write_all(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd_, p, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "write to " + path_);
+            }
+            p += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    std::string directory_;
+    std::string path_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+
+    std::vector<uint64_t> index_offset_;
+    std::vector<int64_t> index_timestamp_;
+    std::vector<uint64_t> index_shots_;
+    std::vector<uint32_t> index_bits_;
+    std::vector<uint32_t> index_backend_;
+    std::map<std::string, uint32_t> backend_ids_;
+};
+
+// Zero-copy view of one stored record; valid while its reader is alive
+// Obtained from ResultStoreReader, which has checked the record header.
+class ResultView {
+public:
+    ResultView(const uint8_t* record, std::string_view backend)
+        : header_(reinterpret_cast<const store_format::RecordHeader*>(record)),
+          record_(record), backend_(backend) {}
+
+    // Whether the `available` bytes at `record` hold a well-formed record
+    static bool valid_record(const uint8_t* record, uint64_t available) {
+        using namespace store_format;
+        if (available < sizeof(RecordHeader)) {
+            return false;
+        }
+        const auto* header = reinterpret_cast<const RecordHeader*>(record);
+        if (header->magic != kRecordMagic || header->record_size < sizeof(RecordHeader) ||
+            header->record_size > available || header->record_size % kAlign != 0) {
+            return false;
+        }
+        if (header->layout_len != 0 && header->layout_len != header->num_bits) {
+            return false;
+        }
+        const uint64_t size = header->record_size;
+        const uint64_t strings = sizeof(RecordHeader) + uint64_t(header->backend_len) + header->job_id_len;
+        const uint64_t text_end = ((strings + 3) & ~uint64_t(3)) + uint64_t(header->layout_len) * 4 +
+                                  header->metadata_len;
+        if (header->columns_offset % 8 != 0 || header->columns_offset < text_end || header->columns_offset > size) {
+            return false;
+        }
+        const uint64_t column_words = header->num_shots / 64 + (header->num_shots % 64 != 0);
+        const uint64_t rest_words = (size - header->columns_offset) / sizeof(uint64_t);
+        return header->num_bits == 0 || column_words <= rest_words / header->num_bits;
+    }
+
+    std::string_view backend() const { return backend_; }
+    std::string_view job_id() const {
+        return {reinterpret_cast<const char*>(record_ + sizeof(*header_) + header_->backend_len),
+                header_->job_id_len};
+    }
+    int64_t timestamp_ns() const { return header_->timestamp_ns; }
+    uint64_t num_shots() const { return header_->num_shots; }
+    uint32_t num_bits() const { return header_->num_bits; }
+
+    // Physical qubit per classical bit, or nullptr if none was recorded
+    const uint32_t* layout() const {
+        return header_->layout_len ? reinterpret_cast<const uint32_t*>(record_ + layout_offset()) : nullptr;
+    }
+    std::string_view metadata() const {
+        size_t offset = layout_offset() + header_->layout_len * sizeof(uint32_t);
+        return {reinterpret_cast<const char*>(record_ + offset), header_->metadata_len};
+    }
+
+    size_t column_words() const { return (header_->num_shots + 63) / 64; }
+
+    // Bitmap over shots for classical bit c
+    const uint64_t* column(uint32_t c) const {
+        return reinterpret_cast<const uint64_t*>(record_ + header_->columns_offset) + c * column_words();
+    }
+
+    // Number of shots in which classical bit c was 1
+    uint64_t ones(uint32_t c) const {
+        const uint64_t* col = column(c);
+        uint64_t n = 0;
+        for (size_t w = 0; w < column_words(); w++) {
+            n += static_cast<uint64_t>(popcount64(col[w]));
+        }
+        return n;
+    }
+
+    // Rebuild row-major shots
+    PackedShots shots() const {
+        PackedShots out(num_bits(), num_shots());
+        for (uint32_t c = 0; c < num_bits(); c++) {
+            const uint64_t* col = column(c);
+            const uint64_t bit = 1ULL << (c & 63);
+            for (size_t w = 0; w < column_words(); w++) {
+                uint64_t bits = col[w];
+                if (w == column_words() - 1 && num_shots() % 64) {
+                    bits &= (1ULL << (num_shots() % 64)) - 1;  // padding past the last shot
+                }
+                while (bits) {
+                    uint64_t s = (w << 6) + ctz64(bits);
+                    out.shot(s)[c >> 6] |= bit;
+                    bits &= bits - 1;
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    // The layout follows the two strings, padded to 4 bytes
+    size_t layout_offset() const {
+        size_t strings = sizeof(*header_) + header_->backend_len + header_->job_id_len;
+        return (strings + 3) & ~size_t(3);
+    }
+
+    const store_format::RecordHeader* header_;
+    const uint8_t* record_;
+    std::string_view backend_;
+};
+
+class ResultStoreReader {
+public:
+    explicit ResultStoreReader(const std::string& directory) {
+        std::vector<std::string> paths;
+        if (std::filesystem::exists(directory)) {
+            for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+                if (entry.path().extension() == ".qkr") {
+                    paths.push_back(entry.path().string());
+                }
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        try {
+            for (const auto& path : paths) {
+                map_segment(path);
+            }
+        } catch (...) {
+            unmap_all();
+            throw;
+        }
+    }
+
+    ResultStoreReader(const ResultStoreReader&) = delete;
+    ResultStoreReader& operator=(const ResultStoreReader&) = delete;
+
+    ~ResultStoreReader() { unmap_all(); }
+
+    size_t size() const { return index_.size(); }
+
+    ResultView operator[](size_t i) const {
+        const Entry& e = index_[i];
+        return ResultView(e.record, backends_[e.backend]);
+    }
+
+    int64_t timestamp_ns(size_t i) const { return index_[i].timestamp_ns; }
+    std::string_view backend(size_t i) const { return backends_[index_[i].backend]; }
+
+    // Records in [from_ns, to_ns) for a backend ("" = any), selected from
+    // the index without touching record pages
+    std::vector<size_t> select(int64_t from_ns, int64_t to_ns, const std::string& backend = "") const {
+        std::vector<size_t> out;
+        for (size_t i = 0; i < index_.size(); i++) {
+            const Entry& e = index_[i];
+            if (e.timestamp_ns >= from_ns && e.timestamp_ns < to_ns &&
+                (backend.empty() || backends_[e.backend] == backend)) {
+                out.push_back(i);
+            }
+        }
+        return out;
+    }
+
+private:
+    struct Mapping {
+        const uint8_t* data;
+        size_t size;
+    };
+    struct Entry {
+        const uint8_t* record;
+        int64_t timestamp_ns;
+        uint32_t backend;
+    };
+
+    void unmap_all() {
+        for (const auto& m : maps_) {
+            ::munmap(const_cast<uint8_t*>(m.data), m.size);
+        }
+        maps_.clear();
+    }
+
+    uint32_t backend_id(const std::string& name) {
+        for (size_t i = 0; i < backends_.size(); i++) {
+            if (backends_[i] == name) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        backends_.push_back(name);
+        return static_cast<uint32_t>(backends_.size() - 1);
+    }
+
+    void map_segment(const std::string& path) {
+        using namespace store_format;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader)) {
+            ::close(fd);
+            return;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "cannot mmap " + path);
+        }
+        const uint8_t* data = static_cast<const uint8_t*>(addr);
+        maps_.push_back({data, size});
+
+        const auto* header = reinterpret_cast<const SegmentHeader*>(data);
+        if (header->magic != kSegmentMagic || header->version != kVersion) {
+            throw std::runtime_error("not a result store segment: " + path);
+        }
+
+        // Sealed segment: read the footer columns, each checked against the
+        // mapping before it is trusted
+        const auto* trailer = reinterpret_cast<const SegmentTrailer*>(data + size - sizeof(SegmentTrailer));
+        if (size >= sizeof(SegmentHeader) + sizeof(FooterHeader) + sizeof(SegmentTrailer) && size % 8 == 0 &&
+            trailer->magic == kTrailerMagic && trailer->footer_offset >= sizeof(SegmentHeader) &&
+            trailer->footer_offset % kAlign == 0 &&
+            trailer->footer_offset <= size - sizeof(SegmentTrailer) - sizeof(FooterHeader)) {
+            const uint64_t footer_offset = trailer->footer_offset;
+            const uint8_t* f = data + footer_offset;
+            const auto* footer = reinterpret_cast<const FooterHeader*>(f);
+            if (footer->magic == kFooterMagic) {
+                // offset, timestamp, num_shots, num_bits, backend id
+                constexpr uint64_t kColumnBytes = 8 * 3 + 4 * 2;
+                const uint64_t available = size - sizeof(SegmentTrailer) - footer_offset - sizeof(FooterHeader);
+                const uint64_t n = footer->num_records;
+                if (n > available / kColumnBytes || footer->backend_table_size > available - n * kColumnBytes) {
+                    throw std::runtime_error("corrupt result store footer in " + path);
+                }
+                const uint8_t* p = f + sizeof(FooterHeader);
+                const auto* offsets = reinterpret_cast<const uint64_t*>(p);
+                const auto* timestamps = reinterpret_cast<const int64_t*>(p + n * 8);
+                const auto* backend_ids = reinterpret_cast<const uint32_t*>(p + n * 8 * 3 + n * 4);
+                const char* table = reinterpret_cast<const char*>(p + n * kColumnBytes);
+
+                std::vector<uint32_t> remap;
+                const char* name = table;
+                const char* table_end = table + footer->backend_table_size;
+                for (uint32_t b = 0; b < footer->num_backends; b++) {
+                    const void* nul = std::memchr(name, '\0', static_cast<size_t>(table_end - name));
+                    if (!nul) {
+                        throw std::runtime_error("corrupt result store backend table in " + path);
+                    }
+                    const char* end = static_cast<const char*>(nul);
+                    remap.push_back(backend_id(std::string(name, end)));
+                    name = end + 1;
+                }
+                for (uint64_t i = 0; i < n; i++) {
+                    const uint64_t offset = offsets[i];
+                    if (offset < sizeof(SegmentHeader) || offset >= footer_offset || offset % kAlign != 0 ||
+                        !ResultView::valid_record(data + offset, footer_offset - offset) ||
+                        backend_ids[i] >= footer->num_backends) {
+                        throw std::runtime_error("corrupt result store: record " + std::to_string(i) + " in " +
+                                                 path);
+                    }
+                    index_.push_back({data + offset, timestamps[i], remap[backend_ids[i]]});
+                }
+                return;
+            }
+        }
+
+        // Unsealed segment: walk complete records
+        size_t offset = sizeof(SegmentHeader);
+        while (ResultView::valid_record(data + offset, size - offset)) {
+            const auto* rec = reinterpret_cast<const RecordHeader*>(data + offset);
+            std::string name(reinterpret_cast<const char*>(rec + 1), rec->backend_len);
+            index_.push_back({data + offset, rec->timestamp_ns, backend_id(name)});
+            offset += rec->record_size;
+        }
+    }
+
+    std::vector<Mapping> maps_;
+    std::vector<Entry> index_;
+    std::vector<std::string> backends_;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_RESULT_STORE_HPP
@@ -0,0 +1,320 @@
+/*
+ * Runtime daemon - a warm QiskitRuntimeService behind a Unix domain socket
+ *
+ * Creating the service, authenticating, looking up the backend and fetching
+ * its target take seconds, which dominates small jobs like the Bell state.
+ * The daemon does that once (for the --warm backends at start-up, for others
+ * on first use) and then accepts jobs over a Unix domain socket, so a client
+ * submission only pays for a local connection and the submit call.
+ *
+ * Usage:
+ *   runtime_daemon serve [--socket PATH] [--warm ibm_torino,ibm_fez]
+ *   runtime_daemon submit [--socket PATH] '<job json>'
+ *   runtime_daemon stop [--socket PATH]
+ *
+ * The socket defaults to $XDG_RUNTIME_DIR/qkx-runtime.sock, or
+ * /tmp/qkx-runtime-<uid>.sock, and is created with mode 0600. The protocol
+ * is one JSON object per line each way: a request is a job as in a
+ * batch_runner file ({"circuit": "ghz", "num_qubits": 20, "backend":
+ * "ibm_fez", "shots": 4096}, or {"qasm": "/path/circuit.qasm", ...}) or
+ * {"op": "ping"} / {"op": "stop"}; the reply is the job report with counts,
+ * or {"ok": false, "error": ...}. Each connection is served on its own
+ * thread and may send several requests; a request line over 1 MiB gets an
+ * error reply and the connection is closed.
+ *
+ * serve refuses to start while another daemon answers on the socket and
+ * only removes a socket file that refuses connections (a stale one).
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+#include "runtime_session.hpp"
+
+namespace {
+
+std::atomic<int> listen_fd{-1};
+
+// Longest request line the daemon accepts; jobs name QASM files by path,
+// so real requests are a few hundred bytes
+constexpr size_t kMaxRequestBytes = 1 << 20;
+
+// Also called for {"op": "stop"}; shutdown() (unlike close()) wakes an
+// accept() blocked in another thread, which then fails and the daemon exits
+void handle_signal(int) {
+    int fd = listen_fd.exchange(-1);
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+std::string default_socket_path() {
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/qkx-runtime.sock";
+    }
+    return "/tmp/qkx-runtime-" + std::to_string(::getuid()) + ".sock";
+}
+
+sockaddr_un socket_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    return addr;
+}
+
+// Line-oriented reads and writes on a socket
+class LineChannel {
+public:
+    explicit LineChannel(int fd) : fd_(fd) {}
+
+    // False at end of stream, or once max_length bytes arrived without a
+    // newline (too_long() tells the two apart)
+    bool read_line(std::string& line, size_t max_length = std::string::npos) {
+        for (;;) {
+            size_t newline = buffer_.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer_.substr(0, newline);
+                buffer_.erase(0, newline + 1);
+                return true;
+            }
+            if (buffer_.size() > max_length) {
+                too_long_ = true;
+                return false;
+            }
+            char chunk[4096];
+            ssize_t n = ::read(fd_, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            buffer_.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+    bool write_line(const std::string& line) {
+        std::string data = line + "\n";
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = ::send(fd_, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool too_long() const { return too_long_; }
+
+private:
+    int fd_;
+    std::string buffer_;
+    bool too_long_ = false;
+};
+
+void serve_connection(int fd, qkx::RuntimeSession& session) {
+    LineChannel channel(fd);
+    std::string line;
+    while (channel.read_line(line, kMaxRequestBytes)) {
+        nlohmann::json reply;
+        try {
+            nlohmann::json request = nlohmann::json::parse(line);
+            std::string op = request.value("op", "run");
+            if (op == "ping") {
+                reply = {{"ok", true}};
+            } else if (op == "stop") {
+                reply = {{"ok", true}};
+                channel.write_line(reply.dump());
+                handle_signal(0);
+                break;
+            } else {
+                std::vector<qkx::JobSpec> job = {qkx::parse_job(request)};
+                qkx::load_job_programs(job, 1);
+                reply = qkx::job_report(job[0], session.run(job[0]));
+            }
+        } catch (const std::exception& e) {
+            reply = {{"ok", false}, {"error", e.what()}};
+        }
+        if (!channel.write_line(reply.dump())) {
+            break;
+        }
+    }
+    if (channel.too_long()) {
+        nlohmann::json reply = {{"ok", false},
+                                {"error", "request longer than " + std::to_string(kMaxRequestBytes) + " bytes"}};
+        channel.write_line(reply.dump());
+    }
+    ::close(fd);
+}
+
+int serve(const std::string& path, const std::vector<std::string>& warm) {
+    // A socket that accepts connections belongs to a running daemon; one
+    // that refuses them was left behind by a daemon that died. Anything
+    // else at the path is not ours to remove.
+    sockaddr_un addr = socket_address(path);
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    int probe_rc = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    int probe_errno = errno;
+    ::close(probe);
+    if (probe_rc == 0) {
+        std::cerr << "Error: a daemon is already listening on " << path << std::endl;
+        return 1;
+    }
+    struct stat st;
+    if (probe_errno != ENOENT && ::lstat(path.c_str(), &st) == 0 && !S_ISSOCK(st.st_mode)) {
+        std::cerr << "Error: " << path << " exists and is not a socket" << std::endl;
+        return 1;
+    }
+    if (probe_errno == ECONNREFUSED) {
+        ::unlink(path.c_str());
+    } else if (probe_errno != ENOENT) {
+        std::cerr << "Error: cannot use " << path << ": " << std::strerror(probe_errno) << std::endl;
+        return 1;
+    }
+
+    qkx::RuntimeSession session;
+    for (const std::string& name : warm) {
+        try {
+            session.backend(name);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: cannot warm " << name << ": " << e.what() << std::endl;
+        }
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    mode_t old_mask = ::umask(0077);
+    int rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (rc < 0 || ::listen(fd, 64) < 0) {
+        std::cerr << "Error: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return 1;
+    }
+    listen_fd = fd;
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+    std::cout << "Listening on " << path << std::endl;
+
+    for (;;) {
+        int client = ::accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR && listen_fd >= 0) {
+                continue;
+            }
+            break;
+        }
+        std::thread(serve_connection, client, std::ref(session)).detach();
+    }
+    ::close(fd);
+    ::unlink(path.c_str());
+    std::cout << "Stopped" << std::endl;
+    // Connections still waiting on jobs end with the process
+    std::_Exit(0);
+}
+
+int request(const std::string& path, const std::string& body) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = socket_address(path);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Error: cannot connect to " << path << " (is the daemon running?)" << std::endl;
+        return 1;
+    }
+    LineChannel channel(fd);
+    std::string reply;
+    bool ok = channel.write_line(nlohmann::json::parse(body).dump()) && channel.read_line(reply);
+    ::close(fd);
+    if (!ok) {
+        std::cerr << "Error: connection closed by daemon" << std::endl;
+        return 1;
+    }
+    std::cout << reply << std::endl;
+    return nlohmann::json::parse(reply).value("ok", false) ? 0 : 1;
+}
+
+void print_usage(const char* program_name) {
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "  " << program_name << " serve [--socket PATH] [--warm BACKEND[,BACKEND...]]" << std::endl;
+    std::cerr << "  " << program_name << " submit [--socket PATH] '<job json>'" << std::endl;
+    std::cerr << "  " << program_name << " stop [--socket PATH]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "Example:" << std::endl;
+    std::cerr << "  " << program_name << " serve --warm ibm_torino &" << std::endl;
+    std::cerr << "  " << program_name
+              << " submit '{\"circuit\": \"bell\", \"backend\": \"ibm_torino\", \"shots\": 1024}'" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::string command = argv[1];
+    std::string path = default_socket_path();
+    std::vector<std::string> warm;
+    std::vector<std::string> args;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "--warm" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                if (!name.empty()) {
+                    warm.push_back(name);
+                }
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    try {
+        if (command == "serve") {
+            return serve(path, warm);
+        } else if (command == "submit" && args.size() == 1) {
+            return request(path, args[0]);
+        } else if (command == "stop") {
+            return request(path, "{\"op\": \"stop\"}");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,304 @@
+/*
+ * Shared runtime session for the batch driver and the daemon
+ *
+ * A job names a circuit family (bell or ghz), an OpenQASM 3 file or an
+ * entry of a binary circuit library, a backend and a shot count.
+ * RuntimeSession creates one QiskitRuntimeService on first use and keeps
+ * every backend (with its target) and every transpiled (circuit, backend)
+ * pair it has built, so only the first job on a backend pays for
+ * authentication, the backend lookup and transpilation. Transpiled circuits
+ * are keyed by the circuit's structural fingerprint, so the same circuit
+ * from a family, a QASM file or a library entry is transpiled once, and a
+ * file edited while the daemon runs is transpiled again.
+ *
+ * Lookup, transpilation and submission are serialized on the session lock
+ * (the runtime client is not known to be thread-safe); waiting for results
+ * is not, so jobs from several threads overlap on the device queue.
+ */
+
+#ifndef QKX_RUNTIME_SESSION_HPP
+#define QKX_RUNTIME_SESSION_HPP
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "circuit/quantumcircuit.hpp"
+#include "primitives/backend_sampler_v2.hpp"
+#include "service/qiskit_runtime_service.hpp"
+#include "compiler/transpiler.hpp"
+
+#include "bitstring.hpp"
+#include "circuit_fingerprint.hpp"
+#include "circuit_library.hpp"
+#include "local_backend.hpp"
+#include "qasm_reader.hpp"
+#include "qiskit_bridge.hpp"
+
+namespace qkx {
+
+struct JobSpec {
+    std::string name;
+    std::string circuit;  // "bell", "ghz", "qasm" or "library"
+    int num_qubits = 2;
+    std::string path;                              // "qasm" or "library" file
+    std::string entry;                             // "library": circuit name
+    std::shared_ptr<const LocalCircuit> program;   // loaded from `path`
+    Fingerprint fingerprint;                       // of the circuit, once loaded
+    std::string backend;
+    int shots = 1024;
+
+    bool from_file() const { return circuit == "qasm" || circuit == "library"; }
+};
+
+struct JobResult {
+    bool ok = false;
+    std::string error;
+    std::string details;
+    double submit_seconds = 0.0;  // until the job was handed to the backend
+    double seconds = 0.0;         // until results were back
+    std::unordered_map<std::string, uint64_t> counts;
+};
+
+// Bell or GHZ circuit of a family job: H, CX fan-out, measure
+inline LocalCircuit family_circuit(const JobSpec& job) {
+    const uint32_t n = static_cast<uint32_t>(job.num_qubits);
+    LocalCircuit circ(n, n);
+    circ.h(0);
+    for (uint32_t i = 1; i < n; i++) {
+        circ.cx(0, i);
+    }
+    circ.measure_all();
+    return circ;
+}
+
+inline Qiskit::circuit::QuantumCircuit build_job_circuit(const JobSpec& job) {
+    return to_quantum_circuit(job.program ? *job.program : family_circuit(job));
+}
+
+// Job from its JSON description, with `defaults` filling missing keys
+inline JobSpec parse_job(const nlohmann::json& entry, const nlohmann::json& defaults = nlohmann::json::object(),
+                         size_t index = 0) {
+    nlohmann::json merged = defaults;
+    merged.update(entry);
+    JobSpec job;
+    if (merged.contains("qasm")) {
+        job.circuit = "qasm";
+        job.path = merged["qasm"];
+    } else if (merged.contains("library")) {
+        job.circuit = "library";
+        job.path = merged["library"];
+        job.entry = merged.value("entry", "");
+    } else {
+        job.circuit = merged.value("circuit", "bell");
+    }
+    job.num_qubits = job.circuit == "bell" ? 2 : merged.value("num_qubits", 2);
+    job.backend = merged.value("backend", "ibm_torino");
+    job.shots = merged.value("shots", 1024);
+    job.name = merged.value("name", job.circuit + "-" + std::to_string(index));
+    if (job.circuit != "bell" && job.circuit != "ghz" && !job.from_file()) {
+        throw std::invalid_argument("job " + job.name + ": unknown circuit '" + job.circuit + "'");
+    }
+    if (job.circuit == "library" && job.entry.empty()) {
+        throw std::invalid_argument("job " + job.name + ": library jobs need an entry");
+    }
+    if (job.from_file()) {
+        if (job.shots <= 0) {
+            throw std::invalid_argument("job " + job.name + ": shots must be positive");
+        }
+        return job;
+    }
+    if (job.num_qubits < 2 || job.num_qubits > 127 || job.shots <= 0) {
+        throw std::invalid_argument("job " + job.name + ": num_qubits must be 2-127 and shots positive");
+    }
+    return job;
+}
+
+inline nlohmann::json job_report(const JobSpec& job, const JobResult& result) {
+    nlohmann::json entry = {
+        {"name", job.name}, {"circuit", job.circuit}, {"num_qubits", job.num_qubits},
+        {"backend", job.backend}, {"shots", job.shots}, {"ok", result.ok},
+        {"fingerprint", job.fingerprint.hex()},
+        {"submit_seconds", result.submit_seconds}, {"seconds", result.seconds}
+    };
+    if (job.circuit == "qasm") {
+        entry["qasm"] = job.path;
+    } else if (job.circuit == "library") {
+        entry["library"] = job.path;
+        entry["entry"] = job.entry;
+    }
+    if (result.ok) {
+        entry["details"] = result.details;
+        entry["counts"] = result.counts;
+    } else {
+        entry["error"] = result.error;
+    }
+    return entry;
+}
+
+// Loads the circuits of file-based jobs: OpenQASM files are parsed on
+// `num_threads` threads, each once, and each library is mapped once. Records
+// the qubit counts and the fingerprints of all jobs; throws with every file
+// or entry that failed.
+inline void load_job_programs(std::vector<JobSpec>& jobs, unsigned num_threads = 0) {
+    std::vector<std::string> paths;
+    std::map<std::string, size_t> index;
+    std::map<std::string, std::unique_ptr<CircuitLibrary>> libraries;
+    std::string errors;
+    auto error = [&errors](const std::string& message) {
+        errors += (errors.empty() ? "" : "\n") + message;
+    };
+    for (const JobSpec& job : jobs) {
+        if (job.circuit == "qasm" && !job.program && index.emplace(job.path, paths.size()).second) {
+            paths.push_back(job.path);
+        } else if (job.circuit == "library" && !job.program && !libraries.count(job.path)) {
+            try {
+                libraries[job.path] = std::make_unique<CircuitLibrary>(job.path);
+            } catch (const std::exception& e) {
+                libraries[job.path] = nullptr;
+                error(e.what());
+            }
+        }
+    }
+    std::vector<QasmFileResult> parsed = read_qasm_files(paths, num_threads);
+    std::vector<std::shared_ptr<const LocalCircuit>> programs(parsed.size());
+    for (size_t i = 0; i < parsed.size(); i++) {
+        if (!parsed[i].error.empty()) {
+            error(parsed[i].error);
+        } else {
+            programs[i] = std::make_shared<const LocalCircuit>(std::move(parsed[i].circuit));
+        }
+    }
+    for (JobSpec& job : jobs) {
+        if (!job.from_file()) {
+            job.fingerprint = fingerprint(family_circuit(job));
+            continue;
+        }
+        if (job.program) {
+            job.fingerprint = fingerprint(*job.program);
+            continue;
+        }
+        if (job.circuit == "qasm") {
+            job.program = programs[index[job.path]];
+        } else if (const CircuitLibrary* library = libraries[job.path].get()) {
+            try {
+                int64_t i = library->find(job.entry);
+                if (i < 0) {
+                    error("job " + job.name + ": no circuit '" + job.entry + "' in " + job.path);
+                    continue;
+                }
+                job.program =
+                    std::make_shared<const LocalCircuit>((*library)[static_cast<size_t>(i)].to_circuit());
+            } catch (const std::exception& e) {
+                error("job " + job.name + ": " + e.what());
+                continue;
+            }
+        }
+        if (job.program) {
+            job.num_qubits = static_cast<int>(job.program->num_qubits());
+            job.fingerprint = fingerprint(*job.program);
+        }
+    }
+    if (!errors.empty()) {
+        throw std::invalid_argument(errors);
+    }
+}
+
+class RuntimeSession {
+public:
+    // Backend `name`, fetched with its target on first use
+    Qiskit::providers::QkrtBackend& backend(const std::string& name) {
+        std::lock_guard<std::mutex> guard(lock_);
+        return backend_locked(name);
+    }
+
+    JobResult run(JobSpec job) {
+        JobResult out;
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&start]() {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+        try {
+            if ((job.from_file() && !job.program) || job.fingerprint == Fingerprint()) {
+                std::vector<JobSpec> one = {job};
+                load_job_programs(one, 1);
+                job = one[0];
+            }
+            if (is_local_backend(job.backend)) {
+                LocalResult run = job.program ? run_local(job.backend, *job.program, job.shots)
+                                              : run_local(job.backend, family_circuit(job), job.shots);
+                out.submit_seconds = elapsed();
+                out.counts = counts_from_shots(run.shots);
+                out.details = run.details;
+            } else {
+                std::shared_ptr<Qiskit::primitives::RuntimeJob> submitted;
+                {
+                    std::lock_guard<std::mutex> guard(lock_);
+                    Qiskit::circuit::QuantumCircuit& circ = transpiled_locked(job);
+                    Qiskit::primitives::BackendSamplerV2 sampler(backend_locked(job.backend), job.shots);
+                    submitted = sampler.run({Qiskit::primitives::SamplerPub(circ)});
+                }
+                if (submitted == nullptr) {
+                    throw std::runtime_error("failed to submit job");
+                }
+                out.submit_seconds = elapsed();
+                out.details = "sampled on hardware";
+                auto result = submitted->result();
+                auto pub_result = result[0];
+                out.counts = pub_result.data("meas").get_counts();
+            }
+            out.ok = true;
+        } catch (const std::exception& e) {
+            out.error = e.what();
+        }
+        out.seconds = elapsed();
+        return out;
+    }
+
+private:
+    Qiskit::providers::QkrtBackend& backend_locked(const std::string& name) {
+        if (!service_) {
+            // Credentials from $HOME/.qiskit/qiskit-ibm.json or the
+            // QISKIT_IBM_TOKEN / QISKIT_IBM_INSTANCE environment variables
+            service_.reset(new Qiskit::service::QiskitRuntimeService());
+        }
+        auto it = backends_.find(name);
+        if (it == backends_.end()) {
+            auto backend = std::make_unique<Qiskit::providers::QkrtBackend>(service_->backend(name));
+            backend->target();
+            it = backends_.emplace(name, std::move(backend)).first;
+            std::cout << "  [session] fetched backend " << name << std::endl;
+        }
+        return *it->second;
+    }
+
+    Qiskit::circuit::QuantumCircuit& transpiled_locked(const JobSpec& job) {
+        auto key = std::make_pair(job.fingerprint, job.backend);
+        auto it = transpiled_.find(key);
+        if (it == transpiled_.end()) {
+            Qiskit::circuit::QuantumCircuit circ = build_job_circuit(job);
+            auto out = std::make_unique<Qiskit::circuit::QuantumCircuit>(
+                Qiskit::compiler::transpile(circ, backend_locked(job.backend)));
+            it = transpiled_.emplace(key, std::move(out)).first;
+        }
+        return *it->second;
+    }
+
+    std::mutex lock_;
+    std::unique_ptr<Qiskit::service::QiskitRuntimeService> service_;
+    std::map<std::string, std::unique_ptr<Qiskit::providers::QkrtBackend>> backends_;
+    std::map<std::pair<Fingerprint, std::string>, std::unique_ptr<Qiskit::circuit::QuantumCircuit>> transpiled_;
+};
+
+}  // namespace qkx
+
+#endif  // QKX_RUNTIME_SESSION_HPP
@@ -0,0 +1,256 @@
+/*
+ * Dense statevector simulator
+ *
+ * Keeps all 2^n amplitudes, so it is limited to roughly 30 qubits, but it
+ * is exact and handles any gate. The circuit is first fused into dense
+ * k-qubit unitaries (gate_fusion.hpp); each is applied in place with the
+ * 2^k-amplitude groups split across threads, so the state is streamed
+ * through memory once per fused gate. Shots of the terminal measurements
+ * are drawn from an alias table built once over the final probabilities.
+ */
+
+#ifndef QKX_STATEVECTOR_HPP
+#define QKX_STATEVECTOR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "alias_sampler.hpp"
+#include "bitstring.hpp"
+#include "gate_fusion.hpp"
+#include "local_circuit.hpp"
+#include "parallel.hpp"
+
+namespace qkx {
+
+namespace detail {
+
+// Dense gate laid out for the amplitude kernel: real and imaginary parts
+// split, so the inner loop is plain multiply-adds rather than calls into
+// the complex runtime, and the offsets of the 2^k amplitudes of a group.
+// Mostly-zero matrices (fused CX chains are permutations, and so are most
+// density-matrix superoperators) also keep their nonzeros row by row.
+struct PreparedGate {
+    uint32_t k = 0;
+    std::vector<uint32_t> qubits;
+    std::vector<double> re, im;
+    std::vector<size_t> offset;
+    bool sparse = false;
+    std::vector<uint32_t> row_start, col;  // CSR over re/im entries
+    std::vector<double> nz_re, nz_im;
+};
+
+inline PreparedGate prepare_gate(const FusedGate& gate) {
+    PreparedGate g;
+    g.k = static_cast<uint32_t>(gate.qubits.size());
+    if (g.k < 1 || g.k > 5) {
+        throw std::invalid_argument("fused gates are limited to 5 qubits");
+    }
+    g.qubits = gate.qubits;
+    const size_t dim = size_t(1) << g.k;
+    g.re.resize(dim * dim);
+    g.im.resize(dim * dim);
+    for (size_t i = 0; i < dim * dim; i++) {
+        g.re[i] = gate.matrix[i].real();
+        g.im[i] = gate.matrix[i].imag();
+    }
+    size_t nonzeros = 0;
+    for (const cplx& a : gate.matrix) {
+        nonzeros += a != 0.0;
+    }
+    if (2 * nonzeros <= dim * dim) {
+        g.sparse = true;
+        g.row_start.push_back(0);
+        for (size_t r = 0; r < dim; r++) {
+            for (size_t c = 0; c < dim; c++) {
+                if (gate.matrix[r * dim + c] != 0.0) {
+                    g.col.push_back(static_cast<uint32_t>(c));
+                    g.nz_re.push_back(g.re[r * dim + c]);
+                    g.nz_im.push_back(g.im[r * dim + c]);
+                }
+            }
+            g.row_start.push_back(static_cast<uint32_t>(g.col.size()));
+        }
+    }
+    g.offset.assign(dim, 0);
+    for (size_t m = 0; m < dim; m++) {
+        for (uint32_t j = 0; j < g.k; j++) {
+            if (m & (size_t(1) << j)) {
+                g.offset[m] |= size_t(1) << gate.qubits[j];
+            }
+        }
+    }
+    return g;
+}
+
+// Apply `g` to amplitude groups [begin, end); group i is the i-th index
+// with zeros at the gate's qubit positions, so the groups inside an
+// aligned block of 2^b amplitudes (b above every gate qubit) are the
+// contiguous range [block << (b - k), (block + 1) << (b - k))
+template <int K>
+void apply_groups(double* amp, const PreparedGate& g, size_t begin, size_t end) {
+    constexpr size_t dim = size_t(1) << K;
+    double mr[dim * dim], mi[dim * dim], vr[dim], vi[dim];
+    size_t offset[dim];
+    std::copy(g.re.begin(), g.re.end(), mr);
+    std::copy(g.im.begin(), g.im.end(), mi);
+    std::copy(g.offset.begin(), g.offset.end(), offset);
+    const uint32_t* qubits = g.qubits.data();
+    for (size_t i = begin; i < end; i++) {
+        size_t base = i;
+        for (int j = 0; j < K; j++) {
+            base = ((base >> qubits[j]) << (qubits[j] + 1)) | (base & ((size_t(1) << qubits[j]) - 1));
+        }
+        for (size_t m = 0; m < dim; m++) {
+            vr[m] = amp[2 * (base + offset[m])];
+            vi[m] = amp[2 * (base + offset[m]) + 1];
+        }
+        if (g.sparse) {
+            for (size_t r = 0; r < dim; r++) {
+                double sr = 0.0, si = 0.0;
+                for (uint32_t e = g.row_start[r]; e < g.row_start[r + 1]; e++) {
+                    sr += g.nz_re[e] * vr[g.col[e]] - g.nz_im[e] * vi[g.col[e]];
+                    si += g.nz_re[e] * vi[g.col[e]] + g.nz_im[e] * vr[g.col[e]];
+                }
+                amp[2 * (base + offset[r])] = sr;
+                amp[2 * (base + offset[r]) + 1] = si;
+            }
+            continue;
+        }
+        for (size_t r = 0; r < dim; r++) {
+            double sr = 0.0, si = 0.0;
+            for (size_t m = 0; m < dim; m++) {
+                sr += mr[r * dim + m] * vr[m] - mi[r * dim + m] * vi[m];
+                si += mr[r * dim + m] * vi[m] + mi[r * dim + m] * vr[m];
+            }
+            amp[2 * (base + offset[r])] = sr;
+            amp[2 * (base + offset[r]) + 1] = si;
+        }
+    }
+}
+
+inline void apply_groups(double* amp, const PreparedGate& g, size_t begin, size_t end) {
+    switch (g.k) {
+        case 1: apply_groups<1>(amp, g, begin, end); break;
+        case 2: apply_groups<2>(amp, g, begin, end); break;
+        case 3: apply_groups<3>(amp, g, begin, end); break;
+        case 4: apply_groups<4>(amp, g, begin, end); break;
+        default: apply_groups<5>(amp, g, begin, end); break;
+    }
+}
+
+}  // namespace detail
+
+struct StatevectorOptions {
+    uint32_t max_qubits = 30;  // 16 GiB of amplitudes
+    unsigned num_threads = 0;  // 0 = hardware concurrency
+    uint64_t seed = 0x5e7;
+    FusionOptions fusion;
+};
+
+struct StatevectorStats {
+    size_t num_gates = 0;
+    size_t num_passes = 0;  // fused gates applied, one memory pass each
+    uint32_t max_fused_qubits = 0;
+};
+
+class StatevectorSimulator {
+public:
+    explicit StatevectorSimulator(uint32_t num_qubits, StatevectorOptions options = StatevectorOptions())
+        : num_qubits_(num_qubits), options_(options) {
+        if (num_qubits > options_.max_qubits) {
+            throw std::invalid_argument("statevector engine limited to " +
+                                        std::to_string(options_.max_qubits) + " qubits");
+        }
+        options_.num_threads = default_num_threads(options_.num_threads);
+        options_.fusion.max_qubits = std::min(options_.fusion.max_qubits, 5u);
+        options_.fusion.width = std::min(options_.fusion.width, 5u);
+        amplitudes_.assign(size_t(1) << num_qubits, 0.0);
+        amplitudes_[0] = 1.0;
+    }
+
+    uint32_t num_qubits() const { return num_qubits_; }
+    const std::vector<cplx>& amplitudes() const { return amplitudes_; }
+    const StatevectorStats& stats() const { return stats_; }
+
+    void run(const LocalCircuit& circ) {
+        if (circ.num_qubits() != num_qubits_) {
+            throw std::invalid_argument("circuit width does not match simulator");
+        }
+        for (const Operation& op : circ.ops()) {
+            if (op.kind == GateKind::Reset) {
+                throw std::invalid_argument("statevector engine does not support reset");
+            }
+        }
+        for (const FusedGate& gate : fuse(circ, options_.fusion)) {
+            apply(gate);
+        }
+    }
+
+    // Apply a dense unitary on up to 5 qubits
+    void apply(const FusedGate& gate) {
+        detail::PreparedGate g = detail::prepare_gate(gate);
+        double* amp = reinterpret_cast<double*>(amplitudes_.data());
+        const size_t groups = amplitudes_.size() >> g.k;
+        parallel_for(groups, options_.num_threads, size_t(1) << (14 - g.k), [&](size_t begin, size_t end, unsigned) {
+            detail::apply_groups(amp, g, begin, end);
+        });
+        stats_.num_gates += gate.num_gates;
+        stats_.num_passes++;
+        stats_.max_fused_qubits = std::max<uint32_t>(stats_.max_fused_qubits,
+                                                     static_cast<uint32_t>(gate.qubits.size()));
+    }
+
+    std::vector<double> probabilities() const {
+        std::vector<double> p(amplitudes_.size());
+        parallel_for(p.size(), options_.num_threads, 1 << 14, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) {
+                p[i] = std::norm(amplitudes_[i]);
+            }
+        });
+        return p;
+    }
+
+    // Shots of the measured qubits of `circ`, each written into its clbit
+    PackedShots sample(const LocalCircuit& circ, size_t shots) const {
+        auto measured = terminal_measurements(circ);
+        AliasTable table(probabilities());
+        PackedShots out(circ.num_clbits(), shots);
+        SamplingOptions sampling;
+        sampling.num_threads = options_.num_threads;
+        sampling.seed = options_.seed;
+        table.sample(shots, sampling, [&](size_t shot, uint64_t index) {
+            uint64_t* row = out.shot(shot);
+            for (const auto& m : measured) {
+                if ((index >> m.first) & 1) {
+                    row[m.second >> 6] |= 1ULL << (m.second & 63);
+                }
+            }
+        });
+        return out;
+    }
+
+private:
+    uint32_t num_qubits_;
+    StatevectorOptions options_;
+    std::vector<cplx> amplitudes_;
+    StatevectorStats stats_;
+};
+
+inline PackedShots run_statevector(const LocalCircuit& circ, size_t shots,
+                                   StatevectorOptions options = StatevectorOptions(),
+                                   StatevectorStats* stats = nullptr) {
+    StatevectorSimulator sim(circ.num_qubits(), options);
+    sim.run(circ);
+    if (stats) {
+        *stats = sim.stats();
+    }
+    return sim.sample(circ, shots);
+}
+
+}  // namespace qkx
+
+#endif  // QKX_STATEVECTOR_HPP
@@ -0,0 +1,309 @@
+/*
+ * OpenQASM 3 writer/reader round trip
+ *
+ * Checks that every standard gate the reader expands (cp, crz, ch, cu, ccx,
+ * cswap, rzz, ...) lowers to the right unitary up to global phase, that the
+ * lowered circuits survive write_qasm3() and read_qasm() unchanged, and that
+ * out-of-range numbers are rejected with their line number.
+ *
+ * Usage: test_qasm_roundtrip   (exit status 0 when every check passes)
+ */
+
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "local_circuit.hpp"
+#include "qasm_reader.hpp"
+#include "qasm_writer.hpp"
+
+namespace {
+
+using qkx::cplx;
+using Unitary = std::vector<cplx>;  // row-major, basis index bit q = qubit q
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+Unitary identity(uint32_t n) {
+    const size_t d = size_t(1) << n;
+    Unitary u(d * d, 0.0);
+    for (size_t i = 0; i < d; i++) {
+        u[i * d + i] = 1.0;
+    }
+    return u;
+}
+
+// U = op * U for one gate of the circuit
+void apply(Unitary& u, uint32_t n, const qkx::Operation& op) {
+    const size_t d = size_t(1) << n;
+    Unitary out(d * d, 0.0);
+    for (size_t r = 0; r < d; r++) {
+        for (size_t c = 0; c < d; c++) {
+            if (op.num_qubits == 1) {
+                qkx::Matrix2 m = qkx::unitary_1q(op);
+                const size_t bit = size_t(1) << op.qubits[0];
+                const size_t rb = (r & bit) ? 1 : 0;
+                for (size_t k = 0; k < 2; k++) {
+                    size_t kk = (r & ~bit) | (k ? bit : 0);
+                    out[r * d + c] += m[rb * 2 + k] * u[kk * d + c];
+                }
+            } else {
+                qkx::Matrix4 m = qkx::unitary_2q(op);
+                const size_t b0 = size_t(1) << op.qubits[0], b1 = size_t(1) << op.qubits[1];
+                const size_t ri = ((r & b0) ? 1 : 0) + ((r & b1) ? 2 : 0);
+                for (size_t k = 0; k < 4; k++) {
+                    size_t kk = (r & ~(b0 | b1)) | ((k & 1) ? b0 : 0) | ((k & 2) ? b1 : 0);
+                    out[r * d + c] += m[ri * 4 + k] * u[kk * d + c];
+                }
+            }
+        }
+    }
+    u = out;
+}
+
+Unitary unitary(const qkx::LocalCircuit& circ) {
+    Unitary u = identity(circ.num_qubits());
+    for (const qkx::Operation& op : circ.ops()) {
+        apply(u, circ.num_qubits(), op);
+    }
+    return u;
+}
+
+bool equal_up_to_phase(const Unitary& a, const Unitary& b) {
+    cplx phase = 0.0;
+    for (size_t i = 0; i < a.size() && std::abs(phase) == 0.0; i++) {
+        if (std::abs(b[i]) > 1e-9) {
+            phase = a[i] / b[i];
+        }
+    }
+    if (std::abs(std::abs(phase) - 1.0) > 1e-9) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::abs(a[i] - phase * b[i]) > 1e-9) {
+            return false;
+        }
+    }
+    return true;
+}
+
+qkx::Operation gate(qkx::GateKind kind, std::vector<uint32_t> qubits, std::vector<double> params = {}) {
+    qkx::Operation op{};
+    op.kind = kind;
+    op.num_qubits = static_cast<uint32_t>(qubits.size());
+    for (size_t i = 0; i < qubits.size(); i++) {
+        op.qubits[i] = qubits[i];
+    }
+    for (size_t i = 0; i < params.size(); i++) {
+        op.params[i] = params[i];
+    }
+    return op;
+}
+
+// Controlled-m with control qubit c and target qubit t on n qubits
+Unitary controlled(uint32_t n, uint32_t c, uint32_t t, const qkx::Matrix2& m) {
+    const size_t d = size_t(1) << n;
+    Unitary u(d * d, 0.0);
+    for (size_t col = 0; col < d; col++) {
+        if (!((col >> c) & 1)) {
+            u[col * d + col] = 1.0;
+            continue;
+        }
+        const size_t tb = (col >> t) & 1;
+        for (size_t k = 0; k < 2; k++) {
+            size_t row = (col & ~(size_t(1) << t)) | (k << t);
+            u[row * d + col] = m[k * 2 + tb];
+        }
+    }
+    return u;
+}
+
+// exp(-iθ/2 P⊗Q) with P on qubit 0 and Q on qubit 1
+Unitary pauli_rotation(qkx::GateKind p, qkx::GateKind q, double theta) {
+    qkx::Matrix2 a = qkx::unitary_1q(gate(p, {0})), b = qkx::unitary_1q(gate(q, {0}));
+    Unitary u(16, 0.0);
+    for (size_t r = 0; r < 4; r++) {
+        for (size_t c = 0; c < 4; c++) {
+            cplx pq = a[(r & 1) * 2 + (c & 1)] * b[(r >> 1) * 2 + (c >> 1)];
+            u[r * 4 + c] = (r == c ? std::cos(theta / 2) : 0.0) - cplx(0, 1) * std::sin(theta / 2) * pq;
+        }
+    }
+    return u;
+}
+
+// Permutation unitary: basis state i goes to perm(i)
+Unitary permutation(uint32_t n, const std::function<size_t(size_t)>& perm) {
+    const size_t d = size_t(1) << n;
+    Unitary u(d * d, 0.0);
+    for (size_t i = 0; i < d; i++) {
+        u[perm(i) * d + i] = 1.0;
+    }
+    return u;
+}
+
+qkx::LocalCircuit read(const std::string& body, uint32_t num_qubits) {
+    std::string source = "OPENQASM 3.0;\ninclude \"stdgates.inc\";\nqubit[" + std::to_string(num_qubits) +
+                         "] q;\n" + body + "\n";
+    return qkx::read_qasm(source, "<test>");
+}
+
+// write_qasm3 followed by read_qasm gives back the same operations
+void check_round_trip(const qkx::LocalCircuit& circ, const std::string& name) {
+    std::ostringstream text;
+    qkx::write_qasm3(circ, text);
+    qkx::LocalCircuit back;
+    try {
+        back = qkx::read_qasm(text.str(), "<round trip>");
+    } catch (const std::exception& e) {
+        check(false, name + ": written program does not read back: " + e.what());
+        return;
+    }
+    bool same = back.num_qubits() == circ.num_qubits() && back.num_clbits() == circ.num_clbits() &&
+                back.size() == circ.size();
+    for (size_t i = 0; same && i < circ.size(); i++) {
+        const qkx::Operation &a = circ.ops()[i], &b = back.ops()[i];
+        same = a.kind == b.kind && a.num_qubits == b.num_qubits;
+        for (uint32_t k = 0; same && k < a.num_qubits; k++) {
+            same = a.qubits[k] == b.qubits[k];
+        }
+        for (uint32_t p = 0; same && p < qkx::gate_num_params(a.kind); p++) {
+            same = a.params[p] == b.params[p];
+        }
+        if (same && a.kind == qkx::GateKind::Measure) {
+            same = a.clbit == b.clbit;
+        }
+    }
+    check(same, name + ": round trip changed the circuit");
+}
+
+}  // namespace
+
+int main() {
+    using K = qkx::GateKind;
+    const double t = 0.7, f = -1.3, l = 2.1, g = 0.4;
+
+    struct Case {
+        std::string name;
+        std::string call;
+        uint32_t num_qubits;
+        Unitary expected;
+    };
+    std::vector<Case> cases = {
+        {"cp", "cp(0.7) q[0], q[1];", 2, controlled(2, 0, 1, qkx::unitary_1q(gate(K::P, {0}, {t})))},
+        {"cphase", "cphase(0.7) q[1], q[0];", 2, controlled(2, 1, 0, qkx::unitary_1q(gate(K::P, {0}, {t})))},
+        {"cu1", "cu1(0.7) q[0], q[1];", 2, controlled(2, 0, 1, qkx::unitary_1q(gate(K::P, {0}, {t})))},
+        {"crx", "crx(0.7) q[0], q[1];", 2, controlled(2, 0, 1, qkx::unitary_1q(gate(K::RX, {0}, {t})))},
+        {"cry", "cry(0.7) q[0], q[1];", 2, controlled(2, 0, 1, qkx::unitary_1q(gate(K::RY, {0}, {t})))},
+        {"crz", "crz(0.7) q[1], q[0];", 2, controlled(2, 1, 0, qkx::unitary_1q(gate(K::RZ, {0}, {t})))},
+        {"ch", "ch q[0], q[1];", 2, controlled(2, 0, 1, qkx::unitary_1q(gate(K::H, {0})))},
+        {"csx", "csx q[0], q[1];", 2, controlled(2, 0, 1, qkx::unitary_1q(gate(K::SX, {0})))},
+        {"cu3", "cu3(0.7, -1.3, 2.1) q[0], q[1];", 2,
+         controlled(2, 0, 1, qkx::unitary_1q(gate(K::U, {0}, {t, f, l})))},
+        {"rxx", "rxx(0.7) q[0], q[1];", 2, pauli_rotation(K::X, K::X, t)},
+        {"ryy", "ryy(0.7) q[0], q[1];", 2, pauli_rotation(K::Y, K::Y, t)},
+        {"rzz", "rzz(0.7) q[0], q[1];", 2, pauli_rotation(K::Z, K::Z, t)},
+        {"rzx", "rzx(0.7) q[0], q[1];", 2, pauli_rotation(K::Z, K::X, t)},
+        {"dcx", "dcx q[0], q[1];", 2,
+         // CX(0,1) then CX(1,0)
+         permutation(2, [](size_t i) { size_t a = i & 1, b = ((i >> 1) ^ a) & 1; return ((a ^ b) & 1) | (b << 1); })},
+        {"ccx", "ccx q[0], q[1], q[2];", 3, permutation(3, [](size_t i) { return (i & 3) == 3 ? i ^ 4 : i; })},
+        {"toffoli", "toffoli q[2], q[0], q[1];", 3,
+         permutation(3, [](size_t i) { return (i & 5) == 5 ? i ^ 2 : i; })},
+        {"cswap", "cswap q[0], q[1], q[2];", 3,
+         permutation(3, [](size_t i) { return (i & 1) && ((i >> 1) & 1) != ((i >> 2) & 1) ? i ^ 6 : i; })},
+    };
+
+    // cu(θ, φ, λ, γ): controlled e^{iγ} U(θ, φ, λ)
+    qkx::Matrix2 u = qkx::unitary_1q(gate(K::U, {0}, {t, f, l}));
+    for (cplx& x : u) {
+        x *= std::polar(1.0, g);
+    }
+    cases.push_back({"cu", "cu(0.7, -1.3, 2.1, 0.4) q[0], q[1];", 2, controlled(2, 0, 1, u)});
+
+    // iswap: |01> and |10> swapped with a factor i
+    Unitary iswap(16, 0.0);
+    iswap[0] = iswap[15] = 1.0;
+    iswap[1 * 4 + 2] = iswap[2 * 4 + 1] = cplx(0, 1);
+    cases.push_back({"iswap", "iswap q[0], q[1];", 2, iswap});
+
+    for (const Case& c : cases) {
+        qkx::LocalCircuit circ;
+        try {
+            circ = read(c.call, c.num_qubits);
+        } catch (const std::exception& e) {
+            check(false, c.name + ": " + e.what());
+            continue;
+        }
+        check(equal_up_to_phase(unitary(circ), c.expected), c.name + ": wrong unitary");
+        check_round_trip(circ, c.name);
+    }
+
+    // Every native gate with measurements, through the writer and back
+    qkx::LocalCircuit natives(3, 3);
+    for (int k = 0; k <= static_cast<int>(K::U); k++) {
+        qkx::Operation op = gate(static_cast<K>(k), {1}, {t, f, l});
+        natives.append(op);
+    }
+    for (K kind : {K::CX, K::CY, K::CZ, K::ECR, K::Swap}) {
+        natives.append(gate(kind, {2, 0}));
+    }
+    natives.rz(1e-300, 0);
+    natives.rx(-0.0, 2);
+    natives.measure(0, 2);
+    natives.measure(2, 0);
+    check_round_trip(natives, "native gates");
+
+    // A file definition of a standard gate overrides the built-in one
+    qkx::LocalCircuit overridden = read("gate cp(x) a, b { cz a, b; }\ncp(0.7) q[0], q[1];", 2);
+    check(overridden.size() == 1 && overridden.ops()[0].kind == K::CZ, "file definition does not override cp");
+
+    // Numbers that do not fit a double fail with their line number
+    for (const char* number : {"1e400", "-1e400"}) {
+        try {
+            read(std::string("rz(") + number + ") q[0];", 1);
+            check(false, std::string("rz(") + number + ") was accepted");
+        } catch (const std::invalid_argument& e) {
+            check(std::string(e.what()).find("<test>:4:") != std::string::npos,
+                  std::string("rz(") + number + ") error lacks the line number: " + e.what());
+        }
+    }
+
+    // Nested definitions that expand past the operation cap fail at the
+    // top-level call instead of exhausting memory
+    try {
+        qkx::QasmProgram bomb;
+        bomb.file = "<test>";
+        std::string source = "OPENQASM 3.0;\nqubit[1] q;\ngate g0 a { x a; x a; x a; x a; }\n";
+        for (int k = 1; k < 8; k++) {
+            source += "gate g" + std::to_string(k) + " a { g" + std::to_string(k - 1) + " a; g" +
+                      std::to_string(k - 1) + " a; g" + std::to_string(k - 1) + " a; g" + std::to_string(k - 1) +
+                      " a; }\n";
+        }
+        source += "h q[0];\ng7 q[0];\n";
+        bomb.source.assign(source.begin(), source.end());
+        qkx::parse_qasm(bomb);
+        qkx::lower_qasm(bomb, 1000);
+        check(false, "expansion past the operation cap was accepted");
+    } catch (const std::invalid_argument& e) {
+        check(std::string(e.what()).find("<test>:12:") != std::string::npos,
+              std::string("operation cap error lacks the line number: ") + e.what());
+    }
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All QASM round-trip checks passed (" << cases.size() << " standard gates)" << std::endl;
+    return 0;
+}
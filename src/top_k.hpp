@@ -0,0 +1,172 @@
+/*
+ * Top-k outcome extraction
+ *
+ * top_k() selects the k most frequent entries of a histogram with a
+ * bounded min-heap: O(n log k) time and O(k) extra memory, instead of
+ * sorting every distinct outcome. At 100+ qubits with near-uniform noise
+ * the histogram can hold almost one entry per shot.
+ *
+ * StreamingTopK handles outcomes that arrive one shot at a time and are
+ * never collected into a histogram. Frequencies are estimated with a
+ * conservative-update count-min sketch (fixed width x depth counters) and
+ * only the current k candidates are kept, so memory is bounded regardless
+ * of the number of distinct outcomes. Estimates never undercount; they
+ * overcount by at most e*N/width with probability 1 - exp(-depth).
+ */
+
+#ifndef QKX_TOP_K_HPP
+#define QKX_TOP_K_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace qkx {
+
+// The k entries of `counts` with the highest counts, most frequent first.
+// `counts` is any range of (key, count) pairs, e.g. the map returned by
+// BitArray::get_counts() or a Histogram.
+template <typename Counts>
+auto top_k(const Counts& counts, size_t k)
+    -> std::vector<std::pair<typename std::decay<decltype(std::begin(counts)->first)>::type, uint64_t>> {
+    using Key = typename std::decay<decltype(std::begin(counts)->first)>::type;
+    using Entry = std::pair<uint64_t, const Key*>;
+
+    // Min-heap on count: the root is the weakest of the current top k
+    auto greater = [](const Entry& a, const Entry& b) { return a.first > b.first; };
+    std::priority_queue<Entry, std::vector<Entry>, decltype(greater)> heap(greater);
+
+    if (k > 0) {
+        for (const auto& c : counts) {
+            uint64_t count = static_cast<uint64_t>(c.second);
+            if (heap.size() < k) {
+                heap.emplace(count, &c.first);
+            } else if (count > heap.top().first) {
+                heap.pop();
+                heap.emplace(count, &c.first);
+            }
+        }
+    }
+
+    std::vector<std::pair<Key, uint64_t>> result(heap.size());
+    for (size_t i = heap.size(); i > 0; i--) {
+        result[i - 1] = {*heap.top().second, heap.top().first};
+        heap.pop();
+    }
+    return result;
+}
+
+// Count-min sketch with conservative update
+class CountMinSketch {
+public:
+    CountMinSketch(size_t width, size_t depth)
+        : width_(width), depth_(depth), table_(width * depth, 0) {
+        if (width == 0 || depth == 0) {
+            throw std::invalid_argument("count-min sketch needs non-zero width and depth");
+        }
+    }
+
+    // Add `count` occurrences of an item with the given 64-bit hash and
+    // return the new frequency estimate
+    uint64_t add(uint64_t hash, uint64_t count = 1) {
+        uint64_t estimate = UINT64_MAX;
+        for (size_t d = 0; d < depth_; d++) {
+            estimate = std::min(estimate, table_[slot(hash, d)]);
+        }
+        estimate += count;
+        // Only raise counters that are below the new estimate
+        for (size_t d = 0; d < depth_; d++) {
+            uint64_t& cell = table_[slot(hash, d)];
+            cell = std::max(cell, estimate);
+        }
+        total_ += count;
+        return estimate;
+    }
+
+    uint64_t estimate(uint64_t hash) const {
+        uint64_t estimate = UINT64_MAX;
+        for (size_t d = 0; d < depth_; d++) {
+            estimate = std::min(estimate, table_[slot(hash, d)]);
+        }
+        return estimate;
+    }
+
+    uint64_t total() const { return total_; }
+
+private:
+    // Row d uses the hash remixed with a row-specific odd constant
+    size_t slot(uint64_t hash, size_t d) const {
+        uint64_t h = hash + 0x9e3779b97f4a7c15ULL * (d + 1);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return d * width_ + static_cast<size_t>(h % width_);
+    }
+
+    size_t width_;
+    size_t depth_;
+    std::vector<uint64_t> table_;
+    uint64_t total_ = 0;
+};
+
+// Approximate top-k over a stream of outcomes in bounded memory. Key needs
+// operator< (Bitstring and std::string both qualify).
+template <typename Key, typename Hash = std::hash<Key>>
+class StreamingTopK {
+public:
+    explicit StreamingTopK(size_t k, size_t width = 1 << 14, size_t depth = 4)
+        : k_(k), sketch_(width, depth) {}
+
+    void add(const Key& key, uint64_t count = 1) {
+        uint64_t estimate = sketch_.add(static_cast<uint64_t>(hash_(key)), count);
+
+        auto it = candidates_.find(key);
+        if (it != candidates_.end()) {
+            ranked_.erase({it->second, key});
+            it->second = estimate;
+            ranked_.insert({estimate, key});
+            return;
+        }
+        if (k_ == 0) {
+            return;
+        }
+        if (candidates_.size() < k_) {
+            candidates_.emplace(key, estimate);
+            ranked_.insert({estimate, key});
+        } else if (estimate > ranked_.begin()->first) {
+            candidates_.erase(ranked_.begin()->second);
+            ranked_.erase(ranked_.begin());
+            candidates_.emplace(key, estimate);
+            ranked_.insert({estimate, key});
+        }
+    }
+
+    uint64_t total() const { return sketch_.total(); }
+
+    // Current candidates with their estimated counts, most frequent first
+    std::vector<std::pair<Key, uint64_t>> result() const {
+        std::vector<std::pair<Key, uint64_t>> out;
+        out.reserve(ranked_.size());
+        for (auto it = ranked_.rbegin(); it != ranked_.rend(); ++it) {
+            out.emplace_back(it->second, it->first);
+        }
+        return out;
+    }
+
+private:
+    size_t k_;
+    Hash hash_;
+    CountMinSketch sketch_;
+    std::unordered_map<Key, uint64_t, Hash> candidates_;
+    std::set<std::pair<uint64_t, Key>> ranked_;  // ordered by estimate
+};
+
+}  // namespace qkx
+
+#endif  // QKX_TOP_K_HPP